@@ -36,6 +36,11 @@ void AChunk::AddQuads(TMap<FIntVector4, FVoxel> VoxelQuadsToAdd)
 	VoxelQuads.Append(VoxelQuadsToAdd);
 }
 
+const TMap<FIntVector4, FVoxel>& AChunk::GetQuads() const
+{
+	return VoxelQuads;
+}
+
 bool AChunk::HasQuadAt(FIntVector4 QuadLocation)
 {
 	/*Tests if there is a face at the given location*/
@@ -202,13 +207,36 @@ void AChunk::RenderChunk(float VoxelSize)
 		}
 
 	}
+	OwningWorld->MakeChunkDataWritable(BlocksDataPtr);
 	FChunkData::Compress(*BlocksDataPtr);
 
 }
 
+void AChunk::LinkNeighbour(int32 DirectionIndex, AChunk* Neighbour)
+{
+	Neighbours[DirectionIndex] = Neighbour;
+	if (IsValid(Neighbour))
+	{
+		Neighbour->Neighbours[FChunkPipeline::OppositeDirections[DirectionIndex]] = this;
+	}
+}
+
+void AChunk::UnlinkNeighbours()
+{
+	for (int32 i = 0; i < 6; i++)
+	{
+		if (IsValid(Neighbours[i]))
+		{
+			Neighbours[i]->Neighbours[FChunkPipeline::OppositeDirections[i]] = nullptr;
+		}
+		Neighbours[i] = nullptr;
+	}
+}
+
 void AChunk::DestroyBlockAt(FVector BlockWorldLocation)
 {
 	/*Destroys the block at the given world location*/
+	IsMeshCached = false;
 	const auto BlockLocation = FloorVector(BlockWorldLocation - GetActorLocation())/(DefaultVoxelSize);
 	
 	const FIntVector Neighbors[6] = {
@@ -220,15 +248,6 @@ void AChunk::DestroyBlockAt(FVector BlockWorldLocation)
 		FIntVector(BlockLocation.X,BlockLocation.Y,BlockLocation.Z-1)							
 	};
 
-	const FIntVector NeighboringChunks[6] = {
-		FIntVector(Location.X+1,Location.Y,Location.Z),
-		FIntVector(Location.X,Location.Y+1,Location.Z),
-		FIntVector(Location.X-1,Location.Y,Location.Z),
-		FIntVector(Location.X,Location.Y-1,Location.Z),
-		FIntVector(Location.X,Location.Y,Location.Z+1),
-		FIntVector(Location.X,Location.Y,Location.Z-1)							
-	};
-
 	const int32 OppositeDirections[6] = {
 		2,
 		3,
@@ -253,7 +272,7 @@ void AChunk::DestroyBlockAt(FVector BlockWorldLocation)
 		}
 		else
 		{
-			if (const auto NeighborPtr = OwningWorld->GetActorOfLoadedChunk(NeighboringChunks[i]))
+			if (const auto NeighborPtr = Neighbours[i])
 			{
 				const auto NeighboringVoxel = NeighborPtr->BlocksDataPtr->GetVoxelAt(NormaliseCyclicalCoordinates(Neighbors[i], ChunkSize));
 				if ((NeighboringVoxel != DefaultVoxel) && !NeighborPtr->HasQuadAt(FIntVector4(Neighbors[i].X, Neighbors[i].Y, Neighbors[i].Z, OppositeDirections[i])))
@@ -271,6 +290,7 @@ void AChunk::DestroyBlockAt(FVector BlockWorldLocation)
 			}
 		}
 	}
+	OwningWorld->MakeChunkDataWritable(BlocksDataPtr);
 	BlocksDataPtr->RemoveVoxel(BlockLocation);
 	RenderChunk(DefaultVoxelSize);
 	
@@ -279,6 +299,7 @@ void AChunk::DestroyBlockAt(FVector BlockWorldLocation)
 void AChunk::SetBlockAt(FVector BlockWorldLocation, FVoxel BlockType)
 {
 	/*Sets the block at the given world location*/
+	IsMeshCached = false;
 	auto RelativeLocation = (BlockWorldLocation - GetActorLocation())/(DefaultVoxelSize);
 	const auto BlockLocation = FIntVector(FMath::Floor(RelativeLocation.X), FMath::Floor(RelativeLocation.Y), FMath::Floor(RelativeLocation.Z));
 	
@@ -291,15 +312,6 @@ void AChunk::SetBlockAt(FVector BlockWorldLocation, FVoxel BlockType)
 		FIntVector(BlockLocation.X,BlockLocation.Y,BlockLocation.Z-1)							
 	};
 
-	const FIntVector NeighboringChunks[6] = {
-		FIntVector(Location.X+1,Location.Y,Location.Z),
-		FIntVector(Location.X,Location.Y+1,Location.Z),
-		FIntVector(Location.X-1,Location.Y,Location.Z),
-		FIntVector(Location.X,Location.Y-1,Location.Z),
-		FIntVector(Location.X,Location.Y,Location.Z+1),
-		FIntVector(Location.X,Location.Y,Location.Z-1)							
-	};
-
 	const int32 OppositeDirections[6] = {
 		2,
 		3,
@@ -324,7 +336,7 @@ void AChunk::SetBlockAt(FVector BlockWorldLocation, FVoxel BlockType)
 		}
 		else
 		{
-			if (const auto NeighborPtr = OwningWorld->GetActorOfLoadedChunk(NeighboringChunks[i]))
+			if (const auto NeighborPtr = Neighbours[i])
 			{
 				const auto NeighboringVoxel = NeighborPtr->BlocksDataPtr->GetVoxelAt(NormaliseCyclicalCoordinates(Neighbors[i], ChunkSize));
 				
@@ -337,6 +349,7 @@ void AChunk::SetBlockAt(FVector BlockWorldLocation, FVoxel BlockType)
 		}
 	}
 
+	OwningWorld->MakeChunkDataWritable(BlocksDataPtr);
 	BlocksDataPtr->SetVoxel(BlockLocation, BlockType);
 	
 	RenderChunk(DefaultVoxelSize);
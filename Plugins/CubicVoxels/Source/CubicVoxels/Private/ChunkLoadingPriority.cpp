@@ -0,0 +1,44 @@
+﻿// .cpp
+#include "ChunkLoading/ChunkLoadingPriority.h"
+
+float FChunkLoadingPriority::GetPriority(const FChunkLoadingAnchor& Anchor, FIntVector ChunkLocation)
+{
+	const FVector ChunkCenter = FVector(ChunkLocation) + FVector(0.5f);
+
+	//Distance to the segment going from the anchor to its predicted position
+	const FVector PredictedPosition = Anchor.Position + Anchor.LookaheadTime*Anchor.Velocity;
+	const float Distance = FMath::PointDistToSegment(ChunkCenter, Anchor.Position, PredictedPosition)/FMath::Max(Anchor.PriorityScale, UE_KINDA_SMALL_NUMBER);
+
+	if (Anchor.ViewDirectionWeight <= 0 || Anchor.Forward.IsNearlyZero())
+	{
+		return Distance;
+	}
+
+	//The chunk the anchor is in and its neighbours are needed whatever the view direction
+	const FVector ToChunk = ChunkCenter - Anchor.Position;
+	const float DistanceToAnchor = ToChunk.Size();
+	if (DistanceToAnchor < 1.5f)
+	{
+		return Distance;
+	}
+
+	//1 in front of the camera, 0 right behind it
+	const float Alignment = 0.5f*(1 + FVector::DotProduct(ToChunk/DistanceToAnchor, Anchor.Forward));
+	return Distance*(1 + Anchor.ViewDirectionWeight*(1 - Alignment));
+}
+
+float FChunkLoadingPriority::GetPriority(const TArray<FChunkLoadingAnchor>& Anchors, FIntVector ChunkLocation)
+{
+	float Result = TNumericLimits<float>::Max();
+	for (const auto& Anchor : Anchors)
+	{
+		Result = FMath::Min(Result, GetPriority(Anchor, ChunkLocation));
+	}
+	return Result;
+}
+
+bool FChunkLoadingPriority::IsInFront(const FChunkLoadingAnchor& Anchor, FIntVector ChunkLocation)
+{
+	const FVector ToChunk = FVector(ChunkLocation) + FVector(0.5f) - Anchor.Position;
+	return FVector::DotProduct(ToChunk, Anchor.Forward) > 0;
+}
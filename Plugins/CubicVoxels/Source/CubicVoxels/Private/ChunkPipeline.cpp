@@ -0,0 +1,211 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/ChunkPipeline.h"
+
+const FIntVector FChunkPipeline::Directions[6] = {
+	FIntVector(1,0,0),
+	FIntVector(0,1,0),
+	FIntVector(-1,0,0),
+	FIntVector(0,-1,0),
+	FIntVector(0,0,1),
+	FIntVector(0,0,-1)
+};
+
+const int32 FChunkPipeline::OppositeDirections[6] = {
+	2,
+	3,
+	0,
+	1,
+	5,
+	4
+};
+
+FChunkPipeline::FChunkPipeline()
+{
+	Stats.StartTime = FPlatformTime::Seconds();
+}
+
+void FChunkPipeline::OnChunkRequested(FIntVector ChunkLocation, bool InFront)
+{
+	/*Registers a chunk whose generation or meshing order has just been sent*/
+	FChunkPipelineState NewState;
+	NewState.RequestTime = FPlatformTime::Seconds();
+	NewState.RequestedInFront = InFront;
+	EnterStage(NewState, EChunkPipelineStage::Requested);
+	ChunkPipelineStates.Add(ChunkLocation, NewState);
+}
+
+void FChunkPipeline::OnChunkGenerated(FIntVector ChunkLocation)
+{
+	if (const auto State = ChunkPipelineStates.Find(ChunkLocation))
+	{
+		if (State->Stage < EChunkPipelineStage::Generated)
+		{
+			EnterStage(*State, EChunkPipelineStage::Generated);
+		}
+	}
+}
+
+void FChunkPipeline::OnInsideGeometryReceived(FIntVector ChunkLocation, bool FromCache)
+{
+	if (const auto State = ChunkPipelineStates.Find(ChunkLocation))
+	{
+		if (State->Stage < EChunkPipelineStage::Meshed)
+		{
+			EnterStage(*State, EChunkPipelineStage::Meshed);
+		}
+		if (FromCache)
+		{
+			Stats.InsideMeshesFromCache += 1;
+		}
+		State->NeedsUpload = true;
+		ChunksToUpload.Add(ChunkLocation);
+	}
+}
+
+void FChunkPipeline::OnSideGeometryReceived(FIntVector ChunkLocation, int32 DirectionIndex)
+{
+	if (const auto State = ChunkPipelineStates.Find(ChunkLocation))
+	{
+		State->MeshedSidesMask |= 1 << DirectionIndex;
+		State->NeedsUpload = true;
+		ChunksToUpload.Add(ChunkLocation);
+		Stats.SideMeshingsReceived += 1;
+	}
+}
+
+void FChunkPipeline::OnChunkUploaded(FIntVector ChunkLocation)
+{
+	if (const auto State = ChunkPipelineStates.Find(ChunkLocation))
+	{
+		State->NeedsUpload = false;
+		if (State->Stage < EChunkPipelineStage::Uploaded)
+		{
+			EnterStage(*State, EChunkPipelineStage::Uploaded);
+			if (State->RequestedInFront)
+			{
+				Stats.InFrontChunksUploaded += 1;
+				Stats.TotalInFrontLatencyToUpload += FPlatformTime::Seconds() - State->RequestTime;
+			}
+		}
+		Stats.Uploads += 1;
+	}
+}
+
+void FChunkPipeline::OnChunkRemoved(FIntVector ChunkLocation)
+{
+	/*Forgets a chunk, the neighbours' sides facing it will have to be meshed again if it is reloaded*/
+	for (int32 i = 0; i < 6; i++)
+	{
+		if (const auto NeighbourState = ChunkPipelineStates.Find(ChunkLocation + Directions[i]))
+		{
+			NeighbourState->IssuedSidesMask &= ~(1 << OppositeDirections[i]);
+			NeighbourState->MeshedSidesMask &= ~(1 << OppositeDirections[i]);
+		}
+	}
+	ChunkPipelineStates.Remove(ChunkLocation);
+	ChunksToUpload.Remove(ChunkLocation);
+}
+
+bool FChunkPipeline::HasReachedStage(FIntVector ChunkLocation, EChunkPipelineStage Stage) const
+{
+	if (const auto State = ChunkPipelineStates.Find(ChunkLocation))
+	{
+		return State->Stage >= Stage;
+	}
+	return false;
+}
+
+TArray<int32> FChunkPipeline::ClaimReadySideMeshings(FIntVector ChunkLocation)
+{
+	/*The meshing of the side shared by two chunks depends on the data of both, so it is ready once both are generated
+	 *Claiming a side marks it on both chunks so that the second chunk to arrive does not issue it again
+	 */
+	TArray<int32> Result;
+
+	const auto State = ChunkPipelineStates.Find(ChunkLocation);
+	if (!State || State->Stage < EChunkPipelineStage::Generated)
+	{
+		return Result;
+	}
+
+	for (int32 i = 0; i < 6; i++)
+	{
+		if (State->IssuedSidesMask & (1 << i))
+		{
+			continue;
+		}
+
+		const auto NeighbourState = ChunkPipelineStates.Find(ChunkLocation + Directions[i]);
+		if (NeighbourState && NeighbourState->Stage >= EChunkPipelineStage::Generated)
+		{
+			State->IssuedSidesMask |= 1 << i;
+			NeighbourState->IssuedSidesMask |= 1 << OppositeDirections[i];
+			Stats.SideMeshingsIssued += 2;
+			Result.Add(i);
+		}
+	}
+
+	return Result;
+}
+
+TArray<FIntVector> FChunkPipeline::ConsumeChunksToUpload()
+{
+	/*Side geometry may only be uploaded once the inside geometry is there, the other chunks wait for the next call*/
+	TArray<FIntVector> Result;
+
+	for (auto It = ChunksToUpload.CreateIterator(); It; ++It)
+	{
+		const auto State = ChunkPipelineStates.Find(*It);
+		if (!State)
+		{
+			It.RemoveCurrent();
+		}
+		else if (State->Stage >= EChunkPipelineStage::Meshed)
+		{
+			Result.Add(*It);
+			It.RemoveCurrent();
+		}
+	}
+
+	return Result;
+}
+
+const FChunkPipelineStats& FChunkPipeline::GetStats() const
+{
+	return Stats;
+}
+
+void FChunkPipeline::LogStats() const
+{
+	const TCHAR* StageNames[static_cast<int32>(EChunkPipelineStage::Num)] = { TEXT("Requested"), TEXT("Generated"), TEXT("Meshed"), TEXT("Uploaded") };
+
+	const double ElapsedTime = FPlatformTime::Seconds() - Stats.StartTime;
+
+	for (int32 i = 0; i < static_cast<int32>(EChunkPipelineStage::Num); i++)
+	{
+		const int32 Count = Stats.ChunksEnteringStage[i];
+		const double AverageLatency = Count > 0 ? 1000*Stats.TotalLatencyToStage[i]/Count : 0;
+		const double Throughput = ElapsedTime > 0 ? Count/ElapsedTime : 0;
+		UE_LOG(LogTemp, Display, TEXT("Chunk pipeline stage %s: %d chunks, %f chunks/s, average latency %f ms, max latency %f ms"), StageNames[i], Count, Throughput, AverageLatency, 1000*Stats.MaxLatencyToStage[i]);
+	}
+
+	const double AverageInFrontLatency = Stats.InFrontChunksUploaded > 0 ? 1000*Stats.TotalInFrontLatencyToUpload/Stats.InFrontChunksUploaded : 0;
+	UE_LOG(LogTemp, Display, TEXT("Chunk pipeline chunks in front of the camera: %d uploaded, average time to visible %f ms"), Stats.InFrontChunksUploaded, AverageInFrontLatency);
+
+	UE_LOG(LogTemp, Display, TEXT("Chunk pipeline sides: %d issued, %d received, %d uploads, %d chunks tracked"), Stats.SideMeshingsIssued, Stats.SideMeshingsReceived, Stats.Uploads, ChunkPipelineStates.Num());
+
+	const int32 ChunksMeshed = Stats.ChunksEnteringStage[static_cast<int32>(EChunkPipelineStage::Meshed)];
+	UE_LOG(LogTemp, Display, TEXT("Chunk pipeline mesh cache: %d of %d inside meshes read from the cache"), Stats.InsideMeshesFromCache, ChunksMeshed);
+}
+
+void FChunkPipeline::EnterStage(FChunkPipelineState& State, EChunkPipelineStage Stage)
+{
+	State.Stage = Stage;
+
+	const int32 StageIndex = static_cast<int32>(Stage);
+	const double Latency = FPlatformTime::Seconds() - State.RequestTime;
+
+	Stats.ChunksEnteringStage[StageIndex] += 1;
+	Stats.TotalLatencyToStage[StageIndex] += Latency;
+	Stats.MaxLatencyToStage[StageIndex] = FMath::Max(Stats.MaxLatencyToStage[StageIndex], Latency);
+}
@@ -0,0 +1,130 @@
+﻿// .cpp
+#include "ChunkLoading/ChunkViewShells.h"
+
+FChunkViewShells::FChunkViewShells(int32 InViewDistance, int32 InVerticalViewDistance)
+{
+	ViewDistance = InViewDistance;
+	VerticalViewDistance = InVerticalViewDistance;
+
+	ViewLayers.SetNum(ViewDistance + 1);
+
+	//Initialize the list that gives the order in which chunks should be iterated
+	for (int32 x = -ViewDistance; x <= ViewDistance; x++)
+	{
+		for (int32 y = -ViewDistance; y <= ViewDistance; y++)
+		{
+			for (int32 z = -VerticalViewDistance; z <= VerticalViewDistance; z++)
+			{
+				const auto Offset = FIntVector(x,y,z);
+				if (Contains(Offset))
+				{
+					ViewLayers[FMath::Abs(x) + FMath::Abs(y) + FMath::Abs(z)].Add(Offset);
+				}
+			}
+		}
+	}
+
+	//Precompute the entering shell of every unit step, layer by layer so that the shells are sorted by distance to the new origin
+	for (int32 StepIndex = 0; StepIndex < 27; StepIndex++)
+	{
+		const auto Step = FIntVector(StepIndex/9 - 1, (StepIndex/3)%3 - 1, StepIndex%3 - 1);
+		if (Step == FIntVector(0,0,0))
+		{
+			continue;
+		}
+
+		for (const auto& ViewLayer : ViewLayers)
+		{
+			for (const auto& Offset : ViewLayer)
+			{
+				if (!Contains(Offset + Step))
+				{
+					EnteringShells[StepIndex].Add(Offset);
+				}
+			}
+		}
+	}
+}
+
+bool FChunkViewShells::Contains(FIntVector Offset) const
+{
+	return FMath::Abs(Offset.X) + FMath::Abs(Offset.Y) + FMath::Abs(Offset.Z) <= ViewDistance && FMath::Abs(Offset.Z) < VerticalViewDistance;
+}
+
+const TArray<TArray<FIntVector>>& FChunkViewShells::GetViewLayers() const
+{
+	return ViewLayers;
+}
+
+int32 FChunkViewShells::Num() const
+{
+	int32 Result = 0;
+	for (const auto& ViewLayer : ViewLayers)
+	{
+		Result += ViewLayer.Num();
+	}
+	return Result;
+}
+
+void FChunkViewShells::GetEnteringChunks(FIntVector OldOrigin, FIntVector NewOrigin, TArray<FIntVector>& OutChunks) const
+{
+	/*A chunk at offset O from the new origin is at offset O + NewOrigin - OldOrigin from the old one*/
+	const auto Step = NewOrigin - OldOrigin;
+
+	if (Step == FIntVector(0,0,0))
+	{
+		return;
+	}
+
+	if (IsUnitStep(Step))
+	{
+		for (const auto& Offset : EnteringShells[GetStepIndex(Step)])
+		{
+			OutChunks.Add(NewOrigin + Offset);
+		}
+		return;
+	}
+
+	//Teleportations and fast movements fall back to a scan of the whole view
+	for (const auto& ViewLayer : ViewLayers)
+	{
+		for (const auto& Offset : ViewLayer)
+		{
+			if (!Contains(Offset + Step))
+			{
+				OutChunks.Add(NewOrigin + Offset);
+			}
+		}
+	}
+}
+
+void FChunkViewShells::GetLeavingChunks(FIntVector OldOrigin, FIntVector NewOrigin, TArray<FIntVector>& OutChunks) const
+{
+	/*The chunks leaving the view when moving from A to B are the chunks entering it when moving from B to A*/
+	GetEnteringChunks(NewOrigin, OldOrigin, OutChunks);
+}
+
+void FChunkViewShells::GetChunksNotInView(const FChunkViewShells& OtherShells, FIntVector Origin, TArray<FIntVector>& OutChunks) const
+{
+	/*Used when the view distance changes, the loading origin stays the same but the shape of the view changes*/
+	for (const auto& ViewLayer : ViewLayers)
+	{
+		for (const auto& Offset : ViewLayer)
+		{
+			if (!OtherShells.Contains(Offset))
+			{
+				OutChunks.Add(Origin + Offset);
+			}
+		}
+	}
+}
+
+int32 FChunkViewShells::GetStepIndex(FIntVector Step)
+{
+	return (Step.X + 1)*9 + (Step.Y + 1)*3 + (Step.Z + 1);
+}
+
+bool FChunkViewShells::IsUnitStep(FIntVector Step)
+{
+	return FMath::Abs(Step.X) <= 1 && FMath::Abs(Step.Y) <= 1 && FMath::Abs(Step.Z) <= 1;
+}
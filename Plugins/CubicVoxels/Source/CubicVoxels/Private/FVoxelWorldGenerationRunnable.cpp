@@ -16,27 +16,46 @@ uint32 FVoxelWorldGenerationRunnable::Run() {
 	while (!bShutdown) {
 		
 		//Empty the queue used to communicate with the game thread into an array
-		//Sorted by distance to the players
+		//Sorted by priority, which depends on the distance to the players' predicted paths and on their view directions
 
 		FChunkThreadedWorkOrderBase CurrentOrder;
 		while (ChunkThreadedWorkOrdersQueue.Dequeue(CurrentOrder) && !bShutdown )
 		{
-			SortedByDistanceToPlayerChunkBuffer.Add(CurrentOrder);
+			SortedByPriorityChunkBuffer.Add(MakeTuple(0.f, CurrentOrder));
 		}
 
-		const TMap<int32, FIntVector> ManagedPlayersPositionsMapCopy = ManagedPlayersPositionsMapCopy; //Copy of the managed players' positions that is guaranteed not to change during sorting of generation orders by distance
+		if (SortedByPriorityChunkBuffer.Num() == 0)
+		{
+			//Nothing to do, let the other threads run instead of spinning
+			FPlatformProcess::Sleep(0.001f);
+			continue;
+		}
 
-		SortedByDistanceToPlayerChunkBuffer.Sort([this, ManagedPlayersPositionsMapCopy](const FChunkThreadedWorkOrderBase& A, const FChunkThreadedWorkOrderBase& B)
+		LoadingAnchorsMutex.Lock();
+		const TArray<FChunkLoadingAnchor> LoadingAnchorsCopy = LoadingAnchors; //Copy of the anchors that is guaranteed not to change during sorting of generation orders by priority
+		LoadingAnchorsMutex.Unlock();
+
+		//The priority is computed once per order rather than in every comparison
+		for (auto& PrioritizedOrder : SortedByPriorityChunkBuffer)
 		{
-			return IsCloserToNearestPlayer(A,B, ManagedPlayersPositionsMapCopy);
+			PrioritizedOrder.Get<0>() = FChunkLoadingPriority::GetPriority(LoadingAnchorsCopy, PrioritizedOrder.Get<1>().ChunkLocation);
+		}
+
+		SortedByPriorityChunkBuffer.Sort([](const TTuple<float, FChunkThreadedWorkOrderBase>& A, const TTuple<float, FChunkThreadedWorkOrderBase>& B)
+		{
+			return A.Get<0>() < B.Get<0>();
 		});
 		
 		
-		for (int32 i = 0; i < SortedByDistanceToPlayerChunkBuffer.Num() && !bShutdown ; i++)
+		for (int32 i = 0; i < SortedByPriorityChunkBuffer.Num() && !bShutdown ; i++)
 		{
-			SortedByDistanceToPlayerChunkBuffer[i].SendOrder();
+			auto& Order = SortedByPriorityChunkBuffer[i].Get<1>();
+			Order.SendOrder();
+			PendingOrdersCost.Subtract(Order.GetCost());
+			PendingOrdersCount.Decrement();
+			CompletedOrdersCount.Increment();
 		}
-		SortedByDistanceToPlayerChunkBuffer.Empty();
+		SortedByPriorityChunkBuffer.Empty();
 		
 	}
 	UE_LOG(LogTemp, Warning, TEXT("Run function is exiting"))
@@ -51,45 +70,39 @@ void FVoxelWorldGenerationRunnable::Stop() {
 	bShutdown = true;
 }
 
-TQueue<FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* FVoxelWorldGenerationRunnable::GetGenerationOrdersQueue()
+void FVoxelWorldGenerationRunnable::AddOrder(const FChunkThreadedWorkOrderBase& Order)
 {
-	return &ChunkThreadedWorkOrdersQueue;
+	PendingOrdersCost.Add(Order.GetCost());
+	PendingOrdersCount.Increment();
+	ChunkThreadedWorkOrdersQueue.Enqueue(Order);
 }
 
-
-void FVoxelWorldGenerationRunnable::StartShutdown()
+int32 FVoxelWorldGenerationRunnable::GetPendingOrdersCost() const
 {
-	ChunkThreadedWorkOrdersQueue.Empty();
-	bShutdown = true;
+	return PendingOrdersCost.GetValue();
 }
 
+int32 FVoxelWorldGenerationRunnable::GetPendingOrdersCount() const
+{
+	return PendingOrdersCount.GetValue();
+}
 
-
-bool FVoxelWorldGenerationRunnable::IsCloserToNearestPlayer(FChunkThreadedWorkOrderBase A,
-                                                            FChunkThreadedWorkOrderBase B, const TMap<int32, FIntVector>& ManagedPlayersPositionsMapConstCopy)
+int32 FVoxelWorldGenerationRunnable::GetCompletedOrdersCount() const
 {
-	int32 MinSquareDistanceAToPlayer = -1;
-	int32 MinSquareDistanceBToPlayer = -1;
+	return CompletedOrdersCount.GetValue();
+}
 
-	const auto PlayerPositionsCopy = ManagedPlayersPositionsMap;
-	for (const auto& PlayerDataPair : PlayerPositionsCopy) //TODO: Add a set that stores all the managed players to avoid weird data race issue
-	{
-		
-		const auto DA = (PlayerDataPair.Value - A.ChunkLocation);
-		const int32 CurrentDistanceToA = DA.X*DA.X + DA.Y*DA.Y + DA.Z*DA.Z;
-		if (MinSquareDistanceAToPlayer == -1 || CurrentDistanceToA < MinSquareDistanceAToPlayer)
-		{
-			MinSquareDistanceAToPlayer = CurrentDistanceToA;
-		}
+void FVoxelWorldGenerationRunnable::SetLoadingAnchors(const TArray<FChunkLoadingAnchor>& Anchors)
+{
+	LoadingAnchorsMutex.Lock();
+	LoadingAnchors = Anchors;
+	LoadingAnchorsMutex.Unlock();
+}
 
-		const auto DB = (PlayerDataPair.Value - B.ChunkLocation);
-		const int32 CurrentDistanceToB = DB.X*DB.X + DB.Y*DB.Y + DB.Z*DB.Z;
-		if (MinSquareDistanceBToPlayer == -1 || CurrentDistanceToB < MinSquareDistanceBToPlayer)
-		{
-			MinSquareDistanceBToPlayer = CurrentDistanceToB;
-		}
-		
-	}
 
-	return MinSquareDistanceAToPlayer < MinSquareDistanceBToPlayer;
+void FVoxelWorldGenerationRunnable::StartShutdown()
+{
+	ChunkThreadedWorkOrdersQueue.Empty();
+	bShutdown = true;
 }
+
@@ -0,0 +1,132 @@
+﻿// .cpp
+#include "ChunkLoading/UnloadedChunkCache.h"
+#include "SerializationAndNetworking/VoxelRegionCache.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+
+uint64 FUnloadedChunkCache::Add(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkData, TSharedPtr<TMap<FIntVector4, FVoxel>> InsideQuads, bool WasGenerated)
+{
+	FUnloadedChunk Chunk;
+	Chunk.ChunkData = ChunkData;
+	Chunk.InsideQuads = InsideQuads;
+	Chunk.WasGenerated = WasGenerated;
+
+	const int64 Bytes = GetEntryBytes(Chunk);
+	return Chunks.Add(ChunkLocation, MoveTemp(Chunk), Bytes);
+}
+
+void FUnloadedChunkCache::SetEncoded(FIntVector ChunkLocation, uint64 Sequence, TArray<uint8>&& EncodedChunkData, TArray<uint8>&& EncodedInsideQuads)
+{
+	const auto Chunk = Chunks.Find(ChunkLocation, Sequence);
+	if (!Chunk)
+	{
+		return;
+	}
+
+	//The geometry is only kept if it was given when the chunk was added
+	const bool KeepInsideQuads = Chunk->InsideQuads.IsValid();
+	Chunk->ChunkData.Reset();
+	Chunk->InsideQuads.Reset();
+	Chunk->EncodedChunkData = MoveTemp(EncodedChunkData);
+	if (KeepInsideQuads)
+	{
+		Chunk->EncodedInsideQuads = MoveTemp(EncodedInsideQuads);
+	}
+	Chunks.SetBytes(ChunkLocation, GetEntryBytes(*Chunk));
+}
+
+bool FUnloadedChunkCache::Take(FIntVector ChunkLocation, FUnloadedChunk& OutUnloadedChunk)
+{
+	const auto Chunk = Chunks.Find(ChunkLocation);
+	if (!Chunk)
+	{
+		Stats.Misses += 1;
+		return false;
+	}
+
+	Stats.Hits += 1;
+	Stats.GenerationsAvoided += Chunk->WasGenerated ? 1 : 0;
+	Stats.MeshingsAvoided += Chunk->HasInsideQuads() ? 1 : 0;
+
+	OutUnloadedChunk = MoveTemp(*Chunk);
+	if (OutUnloadedChunk.ChunkData.IsValid())
+	{
+		OutUnloadedChunk.ChunkData = MakeShared<FChunkData>(*OutUnloadedChunk.ChunkData);
+	}
+	Chunks.Remove(ChunkLocation);
+	return true;
+}
+
+bool FUnloadedChunkCache::Contains(FIntVector ChunkLocation) const
+{
+	return Chunks.Contains(ChunkLocation);
+}
+
+const FChunkData* FUnloadedChunkCache::FindChunkData(FIntVector ChunkLocation)
+{
+	const auto Chunk = Chunks.Find(ChunkLocation);
+	if (!Chunk)
+	{
+		return nullptr;
+	}
+
+	if (!Chunk->ChunkData.IsValid())
+	{
+		const auto ChunkData = MakeShared<FChunkData>();
+		if (!FVoxelChunkCodec::Decode(Chunk->EncodedChunkData, *ChunkData))
+		{
+			return nullptr;
+		}
+		Chunk->ChunkData = ChunkData;
+		Chunks.SetBytes(ChunkLocation, GetEntryBytes(*Chunk));
+	}
+	return Chunk->ChunkData.Get();
+}
+
+void FUnloadedChunkCache::Invalidate(FIntVector ChunkLocation)
+{
+	if (Chunks.Remove(ChunkLocation))
+	{
+		Stats.Invalidations += 1;
+	}
+}
+
+void FUnloadedChunkCache::Evict(int64 ByteBudget)
+{
+	Stats.Evictions += Chunks.Evict(ByteBudget);
+}
+
+void FUnloadedChunkCache::Empty()
+{
+	Chunks.Empty();
+}
+
+FUnloadedChunkCacheStats FUnloadedChunkCache::GetStats() const
+{
+	FUnloadedChunkCacheStats CurrentStats = Stats;
+	CurrentStats.ResidentBytes = Chunks.GetResidentBytes();
+	CurrentStats.ResidentChunks = Chunks.Num();
+	return CurrentStats;
+}
+
+void FUnloadedChunkCache::LogStats() const
+{
+	const auto CurrentStats = GetStats();
+	const int64 Lookups = CurrentStats.Hits + CurrentStats.Misses;
+	const double HitRate = Lookups > 0 ? 100.0*CurrentStats.Hits/Lookups : 0;
+	UE_LOG(LogTemp, Display, TEXT("Unloaded chunk cache: %d chunks, %f MB resident, %lld hits, %lld misses, hit rate %f%%, %lld evictions, %lld invalidations"), CurrentStats.ResidentChunks, CurrentStats.ResidentBytes/(1024.0*1024.0), CurrentStats.Hits, CurrentStats.Misses, HitRate, CurrentStats.Evictions, CurrentStats.Invalidations);
+	UE_LOG(LogTemp, Display, TEXT("Unloaded chunk cache savings: %lld generations and %lld inside meshings avoided"), CurrentStats.GenerationsAvoided, CurrentStats.MeshingsAvoided);
+}
+
+int64 FUnloadedChunkCache::GetEntryBytes(const FUnloadedChunk& Chunk)
+{
+	int64 Bytes = sizeof(FUnloadedChunk) + 2*sizeof(uint64) + Chunk.EncodedChunkData.GetAllocatedSize() + Chunk.EncodedInsideQuads.GetAllocatedSize();
+	if (Chunk.ChunkData.IsValid())
+	{
+		Bytes += FVoxelRegionCache::GetChunkDataBytes(*Chunk.ChunkData);
+	}
+	if (Chunk.InsideQuads.IsValid())
+	{
+		Bytes += Chunk.InsideQuads->GetAllocatedSize();
+	}
+	return Bytes;
+}
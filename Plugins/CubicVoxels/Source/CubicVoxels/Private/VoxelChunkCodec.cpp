@@ -0,0 +1,524 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+bool FVoxelChunkCodec::Encode(const FChunkData& ChunkData, TArray<uint8>& OutBytes, EVoxelChunkCompression Compression)
+{
+	/*Sizes of the dense encodings are known from the palette and the number of runs, so only the chosen one is written*/
+	if (ChunkData.IsSparse || ChunkData.IsAdditive)
+	{
+		return EncodeAs(ChunkData, EVoxelChunkEncoding::Edits, OutBytes, Compression);
+	}
+
+	FPalettedChunk PalettedChunk;
+	BuildPalettedChunk(ChunkData, PalettedChunk);
+
+	EVoxelChunkEncoding Encoding = EVoxelChunkEncoding::Uniform;
+	if (PalettedChunk.Palette.Num() > 1)
+	{
+		Encoding = GetRunsSize(PalettedChunk) <= GetPackedSize(PalettedChunk) ? EVoxelChunkEncoding::Runs : EVoxelChunkEncoding::PackedPalette;
+	}
+
+	TArray<uint8> Payload;
+	return WritePayload(ChunkData, Encoding, &PalettedChunk, Payload) && Finish(Encoding, Compression, Payload, OutBytes);
+}
+
+bool FVoxelChunkCodec::EncodeAs(const FChunkData& ChunkData, EVoxelChunkEncoding Encoding, TArray<uint8>& OutBytes, EVoxelChunkCompression Compression)
+{
+	TArray<uint8> Payload;
+	if (Encoding == EVoxelChunkEncoding::Edits)
+	{
+		return WritePayload(ChunkData, Encoding, nullptr, Payload) && Finish(Encoding, Compression, Payload, OutBytes);
+	}
+
+	//The edits of a sparse chunk don't say what the other voxels are, they can't be written densely
+	if (ChunkData.IsSparse)
+	{
+		return false;
+	}
+
+	FPalettedChunk PalettedChunk;
+	BuildPalettedChunk(ChunkData, PalettedChunk);
+	return WritePayload(ChunkData, Encoding, &PalettedChunk, Payload) && Finish(Encoding, Compression, Payload, OutBytes);
+}
+
+bool FVoxelChunkCodec::Decode(const uint8* Bytes, int32 NumberOfBytes, FChunkData& OutChunkData)
+{
+	if (NumberOfBytes < HeaderSize || Bytes[0] >= static_cast<uint8>(EVoxelChunkEncoding::Num) || Bytes[1] >= static_cast<uint8>(EVoxelChunkCompression::Num))
+	{
+		return false;
+	}
+
+	const EVoxelChunkEncoding Encoding = static_cast<EVoxelChunkEncoding>(Bytes[0]);
+	const EVoxelChunkCompression Compression = static_cast<EVoxelChunkCompression>(Bytes[1]);
+	int32 RawSize = 0;
+	FMemory::Memcpy(&RawSize, Bytes + 2, sizeof(int32));
+
+	const uint8* Payload = Bytes + HeaderSize;
+	const int32 PayloadSize = NumberOfBytes - HeaderSize;
+
+	if (Compression == EVoxelChunkCompression::None)
+	{
+		return RawSize == PayloadSize && ReadPayload(Payload, PayloadSize, Encoding, OutChunkData);
+	}
+
+	//A chunk never takes more than a byte per palette index and a few bytes per palette entry
+	if (RawSize <= 0 || RawSize > 4*ChunkSize*ChunkSize*ChunkSize + (1 << 20))
+	{
+		return false;
+	}
+
+	TArray<uint8> RawPayload;
+	RawPayload.SetNumUninitialized(RawSize);
+	if (!FCompression::UncompressMemory(GetCompressionFormat(Compression), RawPayload.GetData(), RawSize, Payload, PayloadSize))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not decompress chunk data"))
+		return false;
+	}
+	return ReadPayload(RawPayload.GetData(), RawSize, Encoding, OutChunkData);
+}
+
+bool FVoxelChunkCodec::Decode(const TArray<uint8>& Bytes, FChunkData& OutChunkData)
+{
+	return Decode(Bytes.GetData(), Bytes.Num(), OutChunkData);
+}
+
+EVoxelChunkEncoding FVoxelChunkCodec::GetEncoding(const TArray<uint8>& Bytes)
+{
+	return Bytes.Num() >= HeaderSize && Bytes[0] < static_cast<uint8>(EVoxelChunkEncoding::Num) ? static_cast<EVoxelChunkEncoding>(Bytes[0]) : EVoxelChunkEncoding::Num;
+}
+
+const TCHAR* FVoxelChunkCodec::GetEncodingName(EVoxelChunkEncoding Encoding)
+{
+	switch (Encoding)
+	{
+	case EVoxelChunkEncoding::Uniform:
+		return TEXT("Uniform");
+	case EVoxelChunkEncoding::Runs:
+		return TEXT("Runs");
+	case EVoxelChunkEncoding::PackedPalette:
+		return TEXT("PackedPalette");
+	case EVoxelChunkEncoding::Edits:
+		return TEXT("Edits");
+	default:
+		return TEXT("Invalid");
+	}
+}
+
+const TCHAR* FVoxelChunkCodec::GetCompressionName(EVoxelChunkCompression Compression)
+{
+	switch (Compression)
+	{
+	case EVoxelChunkCompression::None:
+		return TEXT("None");
+	case EVoxelChunkCompression::LZ4:
+		return TEXT("LZ4");
+	case EVoxelChunkCompression::Zlib:
+		return TEXT("Zlib");
+	case EVoxelChunkCompression::Oodle:
+		return TEXT("Oodle");
+	default:
+		return TEXT("Invalid");
+	}
+}
+
+void FVoxelChunkCodec::BuildPalettedChunk(const FChunkData& ChunkData, FPalettedChunk& OutPalettedChunk)
+{
+	/*Neighbouring voxels are mostly identical, so the index of the previous voxel is tried before searching the palette*/
+	OutPalettedChunk.Palette.Reset();
+	OutPalettedChunk.Indices.Reset(ChunkSize*ChunkSize*ChunkSize);
+
+	int32 LastIndex = INDEX_NONE;
+	auto AddVoxels = [&OutPalettedChunk, &LastIndex](const FVoxel& Voxel, int32 Count)
+	{
+		if (LastIndex == INDEX_NONE || !(OutPalettedChunk.Palette[LastIndex] == Voxel))
+		{
+			LastIndex = OutPalettedChunk.Palette.IndexOfByKey(Voxel);
+			if (LastIndex == INDEX_NONE)
+			{
+				LastIndex = OutPalettedChunk.Palette.Add(Voxel);
+			}
+		}
+		for (int32 i = 0; i < Count; i++)
+		{
+			OutPalettedChunk.Indices.Add(static_cast<uint16>(LastIndex));
+		}
+	};
+
+	if (ChunkData.IsCompressed)
+	{
+		for (const auto& VoxelStack : ChunkData.CompressedChunkData)
+		{
+			AddVoxels(VoxelStack.Voxel, VoxelStack.StackSize);
+		}
+	}
+	else
+	{
+		for (const auto& Voxel : ChunkData.UncompressedChunkData)
+		{
+			AddVoxels(Voxel, 1);
+		}
+	}
+
+	//Data that was emptied reads as the default voxel
+	if (OutPalettedChunk.Indices.Num() < ChunkSize*ChunkSize*ChunkSize)
+	{
+		AddVoxels(DefaultVoxel, ChunkSize*ChunkSize*ChunkSize - OutPalettedChunk.Indices.Num());
+	}
+	OutPalettedChunk.Indices.SetNum(ChunkSize*ChunkSize*ChunkSize);
+}
+
+void FVoxelChunkCodec::BuildEdits(const FChunkData& ChunkData, TArray<FVoxel>& OutPalette, TArray<FAdditiveVoxel>& OutEdits, TArray<uint16>& OutEditPaletteIndices)
+{
+	if (ChunkData.IsSparse)
+	{
+		OutEdits = ChunkData.AdditiveVoxels;
+	}
+	else
+	{
+		FChunkData SparseChunkData = ChunkData;
+		SparseChunkData.IsAdditive = true;
+		SparseChunkData.MakeSparse();
+		OutEdits = MoveTemp(SparseChunkData.AdditiveVoxels);
+	}
+
+	OutPalette.Reset();
+	OutEditPaletteIndices.Reset(OutEdits.Num());
+	for (const auto& Edit : OutEdits)
+	{
+		OutEditPaletteIndices.Add(static_cast<uint16>(OutPalette.AddUnique(Edit.Voxel)));
+	}
+}
+
+int32 FVoxelChunkCodec::GetBitsPerIndex(int32 PaletteSize)
+{
+	return FMath::Max(1, static_cast<int32>(FMath::CeilLogTwo(static_cast<uint32>(PaletteSize))));
+}
+
+int32 FVoxelChunkCodec::GetPackedSize(const FPalettedChunk& PalettedChunk)
+{
+	return 1 + (ChunkSize*ChunkSize*ChunkSize*GetBitsPerIndex(PalettedChunk.Palette.Num()) + 7)/8;
+}
+
+int32 FVoxelChunkCodec::GetRunsSize(const FPalettedChunk& PalettedChunk)
+{
+	int32 NumberOfRuns = 0;
+	for (int32 i = 0; i < PalettedChunk.Indices.Num(); i++)
+	{
+		if (i == 0 || PalettedChunk.Indices[i] != PalettedChunk.Indices[i-1])
+		{
+			NumberOfRuns += 1;
+		}
+	}
+	return sizeof(int32) + NumberOfRuns*2*sizeof(uint16);
+}
+
+void FVoxelChunkCodec::WritePalette(FArchive& Writer, const TArray<FVoxel>& Palette)
+{
+	/*Voxel names are written once in the palette instead of once per voxel*/
+	uint16 PaletteCount = Palette.Num();
+	Writer << PaletteCount;
+	for (const auto& Voxel : Palette)
+	{
+		FString VoxelType = Voxel.VoxelType.ToString();
+		uint8 IsTransparent = Voxel.IsTransparent ? 1 : 0;
+		uint8 IsSolid = Voxel.IsSolid ? 1 : 0;
+		Writer << VoxelType << IsTransparent << IsSolid;
+	}
+}
+
+bool FVoxelChunkCodec::ReadPalette(FArchive& Reader, TArray<FVoxel>& OutPalette)
+{
+	uint16 PaletteCount = 0;
+	Reader << PaletteCount;
+	OutPalette.SetNum(PaletteCount);
+	for (auto& Voxel : OutPalette)
+	{
+		FString VoxelType;
+		uint8 IsTransparent = 0;
+		uint8 IsSolid = 0;
+		Reader << VoxelType << IsTransparent << IsSolid;
+		Voxel.VoxelType = FName(*VoxelType);
+		Voxel.IsTransparent = IsTransparent != 0;
+		Voxel.IsSolid = IsSolid != 0;
+	}
+	return !Reader.IsError();
+}
+
+bool FVoxelChunkCodec::WritePayload(const FChunkData& ChunkData, EVoxelChunkEncoding Encoding, const FPalettedChunk* PalettedChunk, TArray<uint8>& OutPayload)
+{
+	OutPayload.Reset();
+	FMemoryWriter Writer(OutPayload);
+
+	uint8 Flags = ChunkData.IsAdditive ? AdditiveFlag : 0;
+	Writer << Flags;
+
+	if (Encoding == EVoxelChunkEncoding::Edits)
+	{
+		TArray<FVoxel> Palette;
+		TArray<FAdditiveVoxel> Edits;
+		TArray<uint16> EditPaletteIndices;
+		BuildEdits(ChunkData, Palette, Edits, EditPaletteIndices);
+
+		WritePalette(Writer, Palette);
+		int32 EditCount = Edits.Num();
+		Writer << EditCount;
+		for (int32 i = 0; i < EditCount; i++)
+		{
+			uint16 VoxelIndex = static_cast<uint16>(Edits[i].VoxelIndex);
+			Writer << VoxelIndex << EditPaletteIndices[i];
+		}
+		return true;
+	}
+
+	if (!PalettedChunk || (Encoding == EVoxelChunkEncoding::Uniform && PalettedChunk->Palette.Num() != 1))
+	{
+		return false;
+	}
+
+	WritePalette(Writer, PalettedChunk->Palette);
+	const TArray<uint16>& Indices = PalettedChunk->Indices;
+
+	if (Encoding == EVoxelChunkEncoding::Runs)
+	{
+		//Runs never exceed the size of a chunk, which fits in 16 bits
+		TArray<uint16> RunPaletteIndices;
+		TArray<uint16> RunLengths;
+		for (int32 i = 0; i < Indices.Num(); i++)
+		{
+			if (i > 0 && Indices[i] == Indices[i-1])
+			{
+				RunLengths.Last() += 1;
+			}
+			else
+			{
+				RunPaletteIndices.Add(Indices[i]);
+				RunLengths.Add(1);
+			}
+		}
+
+		int32 RunCount = RunLengths.Num();
+		Writer << RunCount;
+		for (int32 i = 0; i < RunCount; i++)
+		{
+			Writer << RunPaletteIndices[i] << RunLengths[i];
+		}
+	}
+	else if (Encoding == EVoxelChunkEncoding::PackedPalette)
+	{
+		//Indices are packed least significant bit first, an index may straddle two bytes
+		uint8 BitsPerIndex = static_cast<uint8>(GetBitsPerIndex(PalettedChunk->Palette.Num()));
+		Writer << BitsPerIndex;
+
+		TArray<uint8> PackedBytes;
+		PackedBytes.Reserve((Indices.Num()*BitsPerIndex + 7)/8);
+		uint32 BitBuffer = 0;
+		int32 BitsInBuffer = 0;
+		for (const uint16 Index : Indices)
+		{
+			BitBuffer |= static_cast<uint32>(Index) << BitsInBuffer;
+			BitsInBuffer += BitsPerIndex;
+			while (BitsInBuffer >= 8)
+			{
+				PackedBytes.Add(static_cast<uint8>(BitBuffer & 0xFF));
+				BitBuffer >>= 8;
+				BitsInBuffer -= 8;
+			}
+		}
+		if (BitsInBuffer > 0)
+		{
+			PackedBytes.Add(static_cast<uint8>(BitBuffer & 0xFF));
+		}
+		Writer.Serialize(PackedBytes.GetData(), PackedBytes.Num());
+	}
+
+	return true;
+}
+
+bool FVoxelChunkCodec::ReadPayload(const uint8* Payload, int32 PayloadSize, EVoxelChunkEncoding Encoding, FChunkData& OutChunkData)
+{
+	FMemoryReaderView Reader(TArrayView<const uint8>(Payload, PayloadSize));
+
+	uint8 Flags = 0;
+	Reader << Flags;
+
+	TArray<FVoxel> Palette;
+	if (!ReadPalette(Reader, Palette))
+	{
+		return false;
+	}
+	const int32 PaletteCount = Palette.Num();
+
+	if (Encoding == EVoxelChunkEncoding::Edits)
+	{
+		int32 EditCount = 0;
+		Reader << EditCount;
+		if (Reader.IsError() || EditCount < 0 || EditCount > ChunkSize*ChunkSize*ChunkSize)
+		{
+			return false;
+		}
+
+		OutChunkData = FChunkData::SparseAdditiveChunkData();
+		OutChunkData.AdditiveVoxels.SetNum(EditCount);
+		for (int32 i = 0; i < EditCount; i++)
+		{
+			uint16 VoxelIndex = 0;
+			uint16 PaletteIndex = 0;
+			Reader << VoxelIndex << PaletteIndex;
+			//Edits are written in increasing voxel index order, which the binary search of FChunkData relies on
+			if (Reader.IsError() || PaletteIndex >= PaletteCount || VoxelIndex >= ChunkSize*ChunkSize*ChunkSize || (i > 0 && VoxelIndex <= OutChunkData.AdditiveVoxels[i-1].VoxelIndex))
+			{
+				return false;
+			}
+			OutChunkData.AdditiveVoxels[i] = FAdditiveVoxel(VoxelIndex, Palette[PaletteIndex]);
+		}
+		return true;
+	}
+
+	if (PaletteCount == 0)
+	{
+		return false;
+	}
+
+	OutChunkData.IsCompressed = false;
+	OutChunkData.IsSparse = false;
+	OutChunkData.AdditiveVoxels.Empty();
+	OutChunkData.CompressedChunkData.Empty();
+	OutChunkData.IsAdditive = (Flags & AdditiveFlag) != 0;
+	OutChunkData.UncompressedChunkData.SetNum(ChunkSize*ChunkSize*ChunkSize);
+	TArray<FVoxel>& Voxels = OutChunkData.UncompressedChunkData;
+
+	if (Encoding == EVoxelChunkEncoding::Uniform)
+	{
+		for (auto& Voxel : Voxels)
+		{
+			Voxel = Palette[0];
+		}
+	}
+	else if (Encoding == EVoxelChunkEncoding::Runs)
+	{
+		int32 RunCount = 0;
+		Reader << RunCount;
+		if (Reader.IsError() || RunCount < 0 || RunCount > ChunkSize*ChunkSize*ChunkSize)
+		{
+			return false;
+		}
+
+		int32 VoxelIndex = 0;
+		for (int32 i = 0; i < RunCount; i++)
+		{
+			uint16 PaletteIndex = 0;
+			uint16 RunLength = 0;
+			Reader << PaletteIndex << RunLength;
+			if (Reader.IsError() || PaletteIndex >= PaletteCount || VoxelIndex + RunLength > ChunkSize*ChunkSize*ChunkSize)
+			{
+				return false;
+			}
+
+			for (int32 j = 0; j < RunLength; j++)
+			{
+				Voxels[VoxelIndex + j] = Palette[PaletteIndex];
+			}
+			VoxelIndex += RunLength;
+		}
+
+		if (VoxelIndex != ChunkSize*ChunkSize*ChunkSize)
+		{
+			return false;
+		}
+	}
+	else if (Encoding == EVoxelChunkEncoding::PackedPalette)
+	{
+		uint8 BitsPerIndex = 0;
+		Reader << BitsPerIndex;
+		const int32 PackedSize = (ChunkSize*ChunkSize*ChunkSize*BitsPerIndex + 7)/8;
+		if (Reader.IsError() || BitsPerIndex != GetBitsPerIndex(PaletteCount) || Reader.Tell() + PackedSize > PayloadSize)
+		{
+			return false;
+		}
+
+		const uint8* PackedBytes = Payload + Reader.Tell();
+		const uint32 IndexMask = (1u << BitsPerIndex) - 1;
+		uint32 BitBuffer = 0;
+		int32 BitsInBuffer = 0;
+		int32 ByteIndex = 0;
+		for (auto& Voxel : Voxels)
+		{
+			while (BitsInBuffer < BitsPerIndex)
+			{
+				BitBuffer |= static_cast<uint32>(PackedBytes[ByteIndex]) << BitsInBuffer;
+				ByteIndex += 1;
+				BitsInBuffer += 8;
+			}
+			const uint32 PaletteIndex = BitBuffer & IndexMask;
+			BitBuffer >>= BitsPerIndex;
+			BitsInBuffer -= BitsPerIndex;
+
+			if (PaletteIndex >= static_cast<uint32>(PaletteCount))
+			{
+				return false;
+			}
+			Voxel = Palette[PaletteIndex];
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	//Dense additive data is kept as a list of edits in memory
+	OutChunkData.MakeSparse();
+	return true;
+}
+
+bool FVoxelChunkCodec::Finish(EVoxelChunkEncoding Encoding, EVoxelChunkCompression Compression, const TArray<uint8>& Payload, TArray<uint8>& OutBytes)
+{
+	/*The payload is kept as it is when the compression doesn't make it smaller, which is common for uniform and edited chunks*/
+	OutBytes.Reset();
+	OutBytes.AddUninitialized(HeaderSize);
+
+	EVoxelChunkCompression UsedCompression = EVoxelChunkCompression::None;
+	if (Compression != EVoxelChunkCompression::None && Payload.Num() > 0)
+	{
+		const FName CompressionFormat = GetCompressionFormat(Compression);
+		int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, Payload.Num());
+		OutBytes.AddUninitialized(CompressedSize);
+		if (FCompression::CompressMemory(CompressionFormat, OutBytes.GetData() + HeaderSize, CompressedSize, Payload.GetData(), Payload.Num()) && CompressedSize < Payload.Num())
+		{
+			OutBytes.SetNum(HeaderSize + CompressedSize);
+			UsedCompression = Compression;
+		}
+		else
+		{
+			OutBytes.SetNum(HeaderSize);
+		}
+	}
+
+	if (UsedCompression == EVoxelChunkCompression::None)
+	{
+		OutBytes.Append(Payload);
+	}
+
+	int32 RawSize = Payload.Num();
+	OutBytes[0] = static_cast<uint8>(Encoding);
+	OutBytes[1] = static_cast<uint8>(UsedCompression);
+	FMemory::Memcpy(OutBytes.GetData() + 2, &RawSize, sizeof(int32));
+	return true;
+}
+
+FName FVoxelChunkCodec::GetCompressionFormat(EVoxelChunkCompression Compression)
+{
+	switch (Compression)
+	{
+	case EVoxelChunkCompression::LZ4:
+		return NAME_LZ4;
+	case EVoxelChunkCompression::Zlib:
+		return NAME_Zlib;
+	case EVoxelChunkCompression::Oodle:
+		return NAME_Oodle;
+	default:
+		return NAME_None;
+	}
+}
@@ -0,0 +1,220 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelChunkMeshCache.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+uint32 FVoxelChunkMeshCache::HashChunkData(const FChunkData& ChunkData)
+{
+	/*The voxels are hashed as runs of palette indices, the palette is hashed with the names of the voxel types, which is what a save keeps of them*/
+	TArray<FVoxel> Palette;
+	TArray<uint32> Runs;
+
+	int32 RunPaletteIndex = INDEX_NONE;
+	uint32 RunLength = 0;
+	for (int32 x = 0; x < ChunkSize; x++)
+	{
+		for (int32 y = 0; y < ChunkSize; y++)
+		{
+			for (int32 z = 0; z < ChunkSize; z++)
+			{
+				const FVoxel Voxel = ChunkData.GetVoxelAt(x, y, z);
+				if (RunPaletteIndex != INDEX_NONE && Palette[RunPaletteIndex] == Voxel)
+				{
+					RunLength += 1;
+					continue;
+				}
+
+				if (RunPaletteIndex != INDEX_NONE)
+				{
+					Runs.Add(static_cast<uint32>(RunPaletteIndex) << 16 | RunLength);
+				}
+				RunPaletteIndex = Palette.IndexOfByKey(Voxel);
+				if (RunPaletteIndex == INDEX_NONE)
+				{
+					RunPaletteIndex = Palette.Add(Voxel);
+				}
+				RunLength = 1;
+			}
+		}
+	}
+	Runs.Add(static_cast<uint32>(RunPaletteIndex) << 16 | RunLength);
+
+	uint32 Hash = FCrc::MemCrc32(Runs.GetData(), Runs.Num()*sizeof(uint32));
+	for (const auto& Voxel : Palette)
+	{
+		Hash = FCrc::StrCrc32(*Voxel.VoxelType.ToString(), Hash);
+		Hash = HashCombine(Hash, (Voxel.IsTransparent ? 1 : 0) | (Voxel.IsSolid ? 2 : 0));
+	}
+	return Hash;
+}
+
+void FVoxelChunkMeshCache::GetInsideQuads(const TMap<FIntVector4, FVoxel>& Quads, TMap<FIntVector4, FVoxel>& OutInsideQuads)
+{
+	const FIntVector Directions[6] = {
+		FIntVector(1,0,0),
+		FIntVector(0,1,0),
+		FIntVector(-1,0,0),
+		FIntVector(0,-1,0),
+		FIntVector(0,0,1),
+		FIntVector(0,0,-1)
+	};
+
+	OutInsideQuads.Reserve(Quads.Num());
+	for (const auto& QuadPair : Quads)
+	{
+		const FIntVector4& Quad = QuadPair.Key;
+		if (Quad.W < 0 || Quad.W >= 6)
+		{
+			continue;
+		}
+
+		const FIntVector FacingVoxel = FIntVector(Quad.X, Quad.Y, Quad.Z) + Directions[Quad.W];
+		if (FacingVoxel.X >= 0 && FacingVoxel.X < ChunkSize && FacingVoxel.Y >= 0 && FacingVoxel.Y < ChunkSize && FacingVoxel.Z >= 0 && FacingVoxel.Z < ChunkSize)
+		{
+			OutInsideQuads.Add(Quad, QuadPair.Value);
+		}
+	}
+}
+
+bool FVoxelChunkMeshCache::Encode(uint32 DataHash, const TMap<FIntVector4, FVoxel>& InsideQuads, TArray<uint8>& OutBytes)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+
+	TArray<FVoxel> Palette;
+	TArray<uint32> PackedQuads;
+	TArray<uint16> QuadPaletteIndices;
+	PackedQuads.Reserve(InsideQuads.Num());
+	QuadPaletteIndices.Reserve(InsideQuads.Num());
+	for (const auto& QuadPair : InsideQuads)
+	{
+		const FIntVector4& Quad = QuadPair.Key;
+		PackedQuads.Add(static_cast<uint32>((Quad.X*ChunkSize + Quad.Y)*ChunkSize + Quad.Z) << 3 | static_cast<uint32>(Quad.W));
+
+		int32 PaletteIndex = Palette.IndexOfByKey(QuadPair.Value);
+		if (PaletteIndex == INDEX_NONE)
+		{
+			PaletteIndex = Palette.Add(QuadPair.Value);
+		}
+		QuadPaletteIndices.Add(static_cast<uint16>(PaletteIndex));
+	}
+
+	uint16 PaletteCount = static_cast<uint16>(Palette.Num());
+	Writer << PaletteCount;
+	for (const auto& Voxel : Palette)
+	{
+		FString VoxelType = Voxel.VoxelType.ToString();
+		uint8 IsTransparent = Voxel.IsTransparent ? 1 : 0;
+		uint8 IsSolid = Voxel.IsSolid ? 1 : 0;
+		Writer << VoxelType << IsTransparent << IsSolid;
+	}
+
+	int32 QuadCount = PackedQuads.Num();
+	Writer << QuadCount;
+	for (int32 i = 0; i < QuadCount; i++)
+	{
+		Writer << PackedQuads[i] << QuadPaletteIndices[i];
+	}
+
+	int32 RawSize = Payload.Num();
+	OutBytes.SetNumUninitialized(HeaderSize);
+	FMemory::Memcpy(OutBytes.GetData(), &DataHash, sizeof(uint32));
+	FMemory::Memcpy(OutBytes.GetData() + 5, &RawSize, sizeof(int32));
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_LZ4, RawSize);
+	OutBytes.SetNumUninitialized(HeaderSize + CompressedSize);
+	if (FCompression::CompressMemory(NAME_LZ4, OutBytes.GetData() + HeaderSize, CompressedSize, Payload.GetData(), RawSize) && CompressedSize < RawSize)
+	{
+		OutBytes[4] = 1;
+		OutBytes.SetNum(HeaderSize + CompressedSize);
+		return true;
+	}
+
+	OutBytes[4] = 0;
+	OutBytes.SetNum(HeaderSize);
+	OutBytes.Append(Payload);
+	return true;
+}
+
+bool FVoxelChunkMeshCache::Decode(const TArray<uint8>& Bytes, uint32& OutDataHash, TMap<FIntVector4, FVoxel>& OutInsideQuads)
+{
+	if (Bytes.Num() < HeaderSize || Bytes[4] > 1)
+	{
+		return false;
+	}
+
+	int32 RawSize = 0;
+	FMemory::Memcpy(&OutDataHash, Bytes.GetData(), sizeof(uint32));
+	FMemory::Memcpy(&RawSize, Bytes.GetData() + 5, sizeof(int32));
+
+	//A chunk never has more than six quads per voxel
+	if (RawSize <= 0 || RawSize > 6*6*ChunkSize*ChunkSize*ChunkSize + (1 << 20))
+	{
+		return false;
+	}
+
+	TArray<uint8> Payload;
+	if (Bytes[4] == 1)
+	{
+		Payload.SetNumUninitialized(RawSize);
+		if (!FCompression::UncompressMemory(NAME_LZ4, Payload.GetData(), RawSize, Bytes.GetData() + HeaderSize, Bytes.Num() - HeaderSize))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if (RawSize != Bytes.Num() - HeaderSize)
+		{
+			return false;
+		}
+		Payload.Append(Bytes.GetData() + HeaderSize, RawSize);
+	}
+
+	FMemoryReader Reader(Payload);
+
+	uint16 PaletteCount = 0;
+	Reader << PaletteCount;
+	TArray<FVoxel> Palette;
+	Palette.SetNum(PaletteCount);
+	for (auto& Voxel : Palette)
+	{
+		FString VoxelType;
+		uint8 IsTransparent = 0;
+		uint8 IsSolid = 0;
+		Reader << VoxelType << IsTransparent << IsSolid;
+		Voxel.VoxelType = FName(*VoxelType);
+		Voxel.IsTransparent = IsTransparent != 0;
+		Voxel.IsSolid = IsSolid != 0;
+	}
+
+	int32 QuadCount = 0;
+	Reader << QuadCount;
+	if (Reader.IsError() || QuadCount < 0 || QuadCount > 6*ChunkSize*ChunkSize*ChunkSize)
+	{
+		return false;
+	}
+
+	OutInsideQuads.Reserve(QuadCount);
+	for (int32 i = 0; i < QuadCount; i++)
+	{
+		uint32 PackedQuad = 0;
+		uint16 PaletteIndex = 0;
+		Reader << PackedQuad << PaletteIndex;
+		const int32 VoxelIndex = PackedQuad >> 3;
+		const int32 DirectionIndex = PackedQuad & 7;
+		if (Reader.IsError() || PaletteIndex >= PaletteCount || VoxelIndex >= ChunkSize*ChunkSize*ChunkSize || DirectionIndex >= 6)
+		{
+			return false;
+		}
+		OutInsideQuads.Add(FIntVector4(VoxelIndex/(ChunkSize*ChunkSize), (VoxelIndex/ChunkSize)%ChunkSize, VoxelIndex%ChunkSize, DirectionIndex), Palette[PaletteIndex]);
+	}
+	return true;
+}
+
+FString FVoxelChunkMeshCache::GetMeshCacheFilePath(const FString& WorldName, FIntVector RegionLocation)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VoxelWorlds"), WorldName, TEXT("Meshes"), FString::Printf(TEXT("m.%d.%d.%d.cvm"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z));
+}
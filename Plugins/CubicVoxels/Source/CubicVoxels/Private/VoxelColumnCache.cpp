@@ -0,0 +1,93 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/VoxelColumnCache.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
+#include "GlobalPluginParameters.h"
+
+FVoxelColumnCache::FVoxelColumnCache(int64 InByteBudget)
+{
+	ByteBudget = InByteBudget;
+}
+
+TSharedPtr<const FVoxelChunkColumn> FVoxelColumnCache::FindOrCompute(FIntPoint ColumnLocation, float (*ColumnFunction) (FVector2D))
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (const auto CachedColumn = Columns.Find(ColumnLocation))
+		{
+			Stats.Hits += 1;
+			Columns.Touch(ColumnLocation);
+			return *CachedColumn;
+		}
+		Stats.Misses += 1;
+	}
+
+	const TSharedPtr<const FVoxelChunkColumn> Column = ComputeColumn(ColumnLocation, ColumnFunction);
+
+	FScopeLock Lock(&CriticalSection);
+	if (const auto CachedColumn = Columns.Find(ColumnLocation))
+	{
+		return *CachedColumn;
+	}
+
+	Columns.Add(ColumnLocation, CopyTemp(Column), GetColumnBytes());
+	Stats.Evictions += Columns.Evict(ByteBudget);
+	return Column;
+}
+
+void FVoxelColumnCache::Remove(FIntPoint ColumnLocation)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (Columns.Remove(ColumnLocation))
+	{
+		Stats.Removals += 1;
+	}
+}
+
+void FVoxelColumnCache::Empty()
+{
+	FScopeLock Lock(&CriticalSection);
+	Columns.Empty();
+}
+
+FVoxelColumnCacheStats FVoxelColumnCache::GetStats() const
+{
+	FScopeLock Lock(&CriticalSection);
+	FVoxelColumnCacheStats CurrentStats = Stats;
+	CurrentStats.ResidentColumns = Columns.Num();
+	CurrentStats.ResidentBytes = Columns.GetResidentBytes();
+	return CurrentStats;
+}
+
+void FVoxelColumnCache::LogStats() const
+{
+	const auto CurrentStats = GetStats();
+	const int64 Lookups = CurrentStats.Hits + CurrentStats.Misses;
+	const double HitRate = Lookups > 0 ? 100.0*CurrentStats.Hits/Lookups : 0;
+	UE_LOG(LogTemp, Display, TEXT("Column cache: %d columns, %f MB resident, %lld hits, %lld misses, hit rate %f%%, %lld removed out of view, %lld evictions"), CurrentStats.ResidentColumns, CurrentStats.ResidentBytes/(1024.0*1024.0), CurrentStats.Hits, CurrentStats.Misses, HitRate, CurrentStats.Removals, CurrentStats.Evictions);
+}
+
+TSharedPtr<FVoxelChunkColumn> FVoxelColumnCache::ComputeColumn(FIntPoint ColumnLocation, float (*ColumnFunction) (FVector2D))
+{
+	const auto Column = MakeShared<FVoxelChunkColumn>();
+	Column->Values.SetNumUninitialized(ChunkSize*ChunkSize);
+	Column->MinValue = TNumericLimits<float>::Max();
+	Column->MaxValue = TNumericLimits<float>::Lowest();
+
+	for (int32 x = 0; x < ChunkSize; x++)
+	{
+		for (int32 y = 0; y < ChunkSize; y++)
+		{
+			const FVector ColumnPosition = FVoxelWorldGenerator::GetVoxelPosition(FIntVector(ColumnLocation.X, ColumnLocation.Y, 0), x, y, 0);
+			const float Value = (*ColumnFunction)(FVector2D(ColumnPosition.X, ColumnPosition.Y));
+			Column->Values[x*ChunkSize + y] = Value;
+			Column->MinValue = FMath::Min(Column->MinValue, Value);
+			Column->MaxValue = FMath::Max(Column->MaxValue, Value);
+		}
+	}
+	return Column;
+}
+
+int64 FVoxelColumnCache::GetColumnBytes()
+{
+	return sizeof(TSharedPtr<const FVoxelChunkColumn>) + sizeof(FVoxelChunkColumn) + ChunkSize*ChunkSize*sizeof(float);
+}
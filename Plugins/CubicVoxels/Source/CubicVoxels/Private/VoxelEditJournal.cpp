@@ -0,0 +1,369 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelEditJournal.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FVoxelEditJournal::FVoxelEditJournal()
+{
+}
+
+FVoxelEditJournal::~FVoxelEditJournal()
+{
+	Close();
+}
+
+bool FVoxelEditJournal::Open(const FString& InDirectory)
+{
+	/*The existing segments are left untouched for replay, writing starts in a segment after them*/
+	FScopeLock FileLock(&FileMutex);
+	FScopeLock Lock(&JournalMutex);
+	Directory = InDirectory;
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*Directory);
+
+	const auto SegmentIndices = GetSegmentIndices();
+	UnwrittenBytes.Empty();
+	SegmentsToDeleteBefore = INDEX_NONE;
+	StartSegment(SegmentIndices.Num() > 0 ? SegmentIndices.Last() + 1 : 0);
+	IsJournalOpen = OpenSegmentFile(CurrentSegmentIndex, true);
+	return IsJournalOpen;
+}
+
+void FVoxelEditJournal::Close()
+{
+	Flush();
+
+	FScopeLock FileLock(&FileMutex);
+	FScopeLock Lock(&JournalMutex);
+	FileHandle.Reset();
+	FileSegmentIndex = INDEX_NONE;
+	IsJournalOpen = false;
+}
+
+bool FVoxelEditJournal::IsOpen() const
+{
+	FScopeLock Lock(&JournalMutex);
+	return IsJournalOpen;
+}
+
+bool FVoxelEditJournal::ReadEdits(TArray<FVoxelEdit>& OutEdits)
+{
+	FScopeLock Lock(&JournalMutex);
+	bool Success = true;
+	for (const auto SegmentIndex : GetSegmentIndices())
+	{
+		if (SegmentIndex != CurrentSegmentIndex)
+		{
+			Success &= ReadSegment(SegmentIndex, OutEdits);
+		}
+	}
+
+	//Sequence numbers keep increasing across sessions
+	if (OutEdits.Num() > 0)
+	{
+		NextSequence = FMath::Max(NextSequence, OutEdits.Last().Sequence + 1);
+	}
+	return Success;
+}
+
+void FVoxelEditJournal::Append(FVoxelEdit Edit)
+{
+	FScopeLock Lock(&JournalMutex);
+
+	uint16 OldVoxelTypeId = Edit.OldVoxelKnown ? GetVoxelTypeId(Edit.OldVoxel) : UnknownVoxelTypeId;
+	uint16 NewVoxelTypeId = GetVoxelTypeId(Edit.NewVoxel);
+	uint64 Sequence = NextSequence++;
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	Writer << Sequence << Edit.VoxelLocation.X << Edit.VoxelLocation.Y << Edit.VoxelLocation.Z << OldVoxelTypeId << NewVoxelTypeId;
+	AppendRecord(ERecordType::Edit, Payload);
+}
+
+bool FVoxelEditJournal::NeedsFlush() const
+{
+	FScopeLock Lock(&JournalMutex);
+	return PendingBytes.Num() > 0 || UnwrittenBytes.Num() > 0 || SegmentsToDeleteBefore != INDEX_NONE;
+}
+
+bool FVoxelEditJournal::Flush()
+{
+	/*The buffers are taken under the journal lock and written outside of it, the file lock keeps the flushes in order
+	 *Bytes that could not be written are put back in front of the ones buffered meanwhile, and tried again by the next flush
+	 */
+	FScopeLock FileLock(&FileMutex);
+
+	TArray<TPair<int32, TArray<uint8>>> BytesToWrite;
+	int32 DeleteBefore = INDEX_NONE;
+	{
+		FScopeLock Lock(&JournalMutex);
+		if (!IsJournalOpen)
+		{
+			return PendingBytes.Num() == 0 && UnwrittenBytes.Num() == 0;
+		}
+
+		BytesToWrite = MoveTemp(UnwrittenBytes);
+		UnwrittenBytes.Reset();
+		if (PendingBytes.Num() > 0)
+		{
+			BytesToWrite.Emplace(CurrentSegmentIndex, MoveTemp(PendingBytes));
+			PendingBytes.Reset();
+		}
+		DeleteBefore = SegmentsToDeleteBefore;
+		SegmentsToDeleteBefore = INDEX_NONE;
+	}
+
+	int32 NumberWritten = 0;
+	for (; NumberWritten < BytesToWrite.Num(); NumberWritten++)
+	{
+		const auto& SegmentBytes = BytesToWrite[NumberWritten];
+
+		//Segments only move forward, the first time one is written its file is created
+		if (FileSegmentIndex != SegmentBytes.Key && !OpenSegmentFile(SegmentBytes.Key, SegmentBytes.Key > FileSegmentIndex))
+		{
+			break;
+		}
+		if (!FileHandle->Write(SegmentBytes.Value.GetData(), SegmentBytes.Value.Num()) || !FileHandle->Flush())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not write to the edit journal %s"), *GetSegmentPath(SegmentBytes.Key))
+			break;
+		}
+	}
+
+	if (NumberWritten < BytesToWrite.Num())
+	{
+		FScopeLock Lock(&JournalMutex);
+		BytesToWrite.RemoveAt(0, NumberWritten);
+		UnwrittenBytes.Insert(MoveTemp(BytesToWrite), 0);
+		SegmentsToDeleteBefore = FMath::Max(SegmentsToDeleteBefore, DeleteBefore);
+		return false;
+	}
+
+	//The file handle has moved past the released segments by now, unless nothing was written since they were released
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for (const auto SegmentIndex : GetSegmentIndices())
+	{
+		if (SegmentIndex < DeleteBefore && SegmentIndex != FileSegmentIndex)
+		{
+			PlatformFile.DeleteFile(*GetSegmentPath(SegmentIndex));
+		}
+	}
+	return true;
+}
+
+int32 FVoxelEditJournal::Rotate()
+{
+	/*Called on the game thread when a save takes its snapshot, the new segment's file is created by the next flush*/
+	FScopeLock Lock(&JournalMutex);
+	if (PendingBytes.Num() > 0)
+	{
+		UnwrittenBytes.Emplace(CurrentSegmentIndex, MoveTemp(PendingBytes));
+	}
+	StartSegment(CurrentSegmentIndex + 1);
+	return CurrentSegmentIndex;
+}
+
+void FVoxelEditJournal::DeleteSegmentsBefore(int32 SegmentIndex)
+{
+	FScopeLock Lock(&JournalMutex);
+	SegmentsToDeleteBefore = FMath::Max(SegmentsToDeleteBefore, FMath::Min(SegmentIndex, CurrentSegmentIndex));
+
+	//Edits of a released segment that are not on disk yet are covered by the save too
+	const int32 DeleteBefore = SegmentsToDeleteBefore;
+	UnwrittenBytes.RemoveAll([DeleteBefore](const TPair<int32, TArray<uint8>>& SegmentBytes)
+	{
+		return SegmentBytes.Key < DeleteBefore;
+	});
+}
+
+int64 FVoxelEditJournal::GetCurrentSegmentBytes() const
+{
+	FScopeLock Lock(&JournalMutex);
+	return CurrentSegmentBytes;
+}
+
+FString FVoxelEditJournal::GetJournalDirectory(const FString& WorldName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VoxelWorlds"), WorldName, TEXT("Journal"));
+}
+
+FString FVoxelEditJournal::GetSegmentPath(int32 SegmentIndex) const
+{
+	return FPaths::Combine(Directory, FString::Printf(TEXT("%08d.cvj"), SegmentIndex));
+}
+
+TArray<int32> FVoxelEditJournal::GetSegmentIndices() const
+{
+	TArray<FString> SegmentFiles;
+	IFileManager::Get().FindFiles(SegmentFiles, *FPaths::Combine(Directory, TEXT("*.cvj")), true, false);
+
+	TArray<int32> Result;
+	for (const auto& SegmentFile : SegmentFiles)
+	{
+		const FString BaseName = FPaths::GetBaseFilename(SegmentFile);
+		if (BaseName.IsNumeric())
+		{
+			Result.Add(FCString::Atoi(*BaseName));
+		}
+	}
+	Result.Sort();
+	return Result;
+}
+
+void FVoxelEditJournal::StartSegment(int32 SegmentIndex)
+{
+	CurrentSegmentIndex = SegmentIndex;
+	VoxelTypeIds.Empty();
+	PendingBytes.Reset();
+
+	TArray<uint8> HeaderBytes;
+	FMemoryWriter Writer(HeaderBytes);
+	uint32 Magic = SegmentMagic;
+	uint32 Version = SegmentVersion;
+	Writer << Magic << Version;
+	PendingBytes.Append(HeaderBytes);
+	CurrentSegmentBytes = HeaderBytes.Num();
+}
+
+bool FVoxelEditJournal::OpenSegmentFile(int32 SegmentIndex, bool Create)
+{
+	FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*GetSegmentPath(SegmentIndex), !Create, false));
+	FileSegmentIndex = FileHandle ? SegmentIndex : INDEX_NONE;
+	if (!FileHandle)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open the edit journal %s"), *GetSegmentPath(SegmentIndex))
+		return false;
+	}
+	return true;
+}
+
+uint16 FVoxelEditJournal::GetVoxelTypeId(const FVoxel& Voxel)
+{
+	if (const auto VoxelTypeId = VoxelTypeIds.Find(Voxel.VoxelType))
+	{
+		return *VoxelTypeId;
+	}
+
+	uint16 VoxelTypeId = VoxelTypeIds.Num();
+	VoxelTypeIds.Add(Voxel.VoxelType, VoxelTypeId);
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	FString VoxelType = Voxel.VoxelType.ToString();
+	uint8 IsTransparent = Voxel.IsTransparent ? 1 : 0;
+	uint8 IsSolid = Voxel.IsSolid ? 1 : 0;
+	Writer << VoxelTypeId << VoxelType << IsTransparent << IsSolid;
+	AppendRecord(ERecordType::VoxelType, Payload);
+
+	return VoxelTypeId;
+}
+
+void FVoxelEditJournal::AppendRecord(ERecordType RecordType, const TArray<uint8>& Payload)
+{
+	/*Record layout: type, payload size, payload, checksum of everything before it*/
+	TArray<uint8> RecordBytes;
+	FMemoryWriter Writer(RecordBytes);
+	uint8 StoredRecordType = static_cast<uint8>(RecordType);
+	uint16 PayloadSize = Payload.Num();
+	Writer << StoredRecordType << PayloadSize;
+	Writer.Serialize(const_cast<uint8*>(Payload.GetData()), Payload.Num());
+	uint32 Checksum = FCrc::MemCrc32(RecordBytes.GetData(), RecordBytes.Num());
+	Writer << Checksum;
+
+	PendingBytes.Append(RecordBytes);
+	CurrentSegmentBytes += RecordBytes.Num();
+}
+
+bool FVoxelEditJournal::ReadSegment(int32 SegmentIndex, TArray<FVoxelEdit>& OutEdits)
+{
+	TArray<uint8> SegmentBytes;
+	if (!FFileHelper::LoadFileToArray(SegmentBytes, *GetSegmentPath(SegmentIndex)))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(SegmentBytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Reader.IsError() || Magic != SegmentMagic || Version != SegmentVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Edit journal %s has an invalid header"), *GetSegmentPath(SegmentIndex))
+		return false;
+	}
+
+	TMap<uint16, FVoxel> SegmentVoxelTypes;
+	constexpr int64 RecordHeaderSize = sizeof(uint8) + sizeof(uint16);
+	constexpr int64 ChecksumSize = sizeof(uint32);
+
+	while (Reader.Tell() + RecordHeaderSize + ChecksumSize <= Reader.TotalSize())
+	{
+		const int64 RecordStart = Reader.Tell();
+		uint8 RecordType = 0;
+		uint16 PayloadSize = 0;
+		Reader << RecordType << PayloadSize;
+
+		const int64 PayloadStart = Reader.Tell();
+		if (PayloadStart + PayloadSize + ChecksumSize > Reader.TotalSize())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Edit journal %s ends with a torn record, it is ignored"), *GetSegmentPath(SegmentIndex))
+			return true;
+		}
+
+		uint32 Checksum = 0;
+		Reader.Seek(PayloadStart + PayloadSize);
+		Reader << Checksum;
+		if (Checksum != FCrc::MemCrc32(SegmentBytes.GetData() + RecordStart, PayloadStart + PayloadSize - RecordStart))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Edit journal %s has a corrupted record, the edits after it are ignored"), *GetSegmentPath(SegmentIndex))
+			return true;
+		}
+		Reader.Seek(PayloadStart);
+
+		if (RecordType == static_cast<uint8>(ERecordType::VoxelType))
+		{
+			uint16 VoxelTypeId = 0;
+			FString VoxelType;
+			uint8 IsTransparent = 0;
+			uint8 IsSolid = 0;
+			Reader << VoxelTypeId << VoxelType << IsTransparent << IsSolid;
+
+			FVoxel Voxel;
+			Voxel.VoxelType = FName(*VoxelType);
+			Voxel.IsTransparent = IsTransparent != 0;
+			Voxel.IsSolid = IsSolid != 0;
+			SegmentVoxelTypes.Add(VoxelTypeId, Voxel);
+		}
+		else if (RecordType == static_cast<uint8>(ERecordType::Edit))
+		{
+			FVoxelEdit Edit;
+			uint16 OldVoxelTypeId = 0;
+			uint16 NewVoxelTypeId = 0;
+			Reader << Edit.Sequence << Edit.VoxelLocation.X << Edit.VoxelLocation.Y << Edit.VoxelLocation.Z << OldVoxelTypeId << NewVoxelTypeId;
+
+			const auto NewVoxel = SegmentVoxelTypes.Find(NewVoxelTypeId);
+			if (!NewVoxel)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Edit journal %s uses an undefined voxel type"), *GetSegmentPath(SegmentIndex))
+				return false;
+			}
+			Edit.NewVoxel = *NewVoxel;
+
+			if (const auto OldVoxel = SegmentVoxelTypes.Find(OldVoxelTypeId))
+			{
+				Edit.OldVoxel = *OldVoxel;
+				Edit.OldVoxelKnown = true;
+			}
+			OutEdits.Add(Edit);
+		}
+
+		//Records of unknown types are skipped thanks to their size
+		Reader.Seek(PayloadStart + PayloadSize + ChecksumSize);
+	}
+	return true;
+}
@@ -0,0 +1,335 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/VoxelNoise.h"
+#include "Math/VectorRegister.h"
+
+namespace VoxelNoiseLanes
+{
+	//Lane operations on one sample. Integers are unsigned so that the hash wraps around like the vector registers do
+	struct FScalarLanes
+	{
+		using FFloat = float;
+		using FInt = uint32;
+		using FMask = bool;
+
+		static FORCEINLINE FFloat Set(float Value) { return Value; }
+		static FORCEINLINE FInt SetInt(int32 Value) { return static_cast<uint32>(Value); }
+
+		static FORCEINLINE FFloat Add(FFloat A, FFloat B) { return A + B; }
+		static FORCEINLINE FFloat Sub(FFloat A, FFloat B) { return A - B; }
+		static FORCEINLINE FFloat Mul(FFloat A, FFloat B) { return A * B; }
+		static FORCEINLINE FFloat Floor(FFloat A) { return FMath::FloorToFloat(A); }
+		static FORCEINLINE FFloat Abs(FFloat A) { return FMath::Abs(A); }
+		static FORCEINLINE FFloat Sqrt(FFloat A) { return FMath::Sqrt(A); }
+		static FORCEINLINE FMask Less(FFloat A, FFloat B) { return A < B; }
+		static FORCEINLINE FFloat Select(FMask Mask, FFloat A, FFloat B) { return Mask ? A : B; }
+
+		//Conversions are only applied to integral floats and to integers below 2^24, which are exact
+		static FORCEINLINE FInt ToInt(FFloat A) { return static_cast<uint32>(static_cast<int32>(A)); }
+		static FORCEINLINE FFloat ToFloat(FInt A) { return static_cast<float>(static_cast<int32>(A)); }
+
+		static FORCEINLINE FInt IntAdd(FInt A, FInt B) { return A + B; }
+		static FORCEINLINE FInt IntMul(FInt A, FInt B) { return A * B; }
+		static FORCEINLINE FInt IntXor(FInt A, FInt B) { return A ^ B; }
+		static FORCEINLINE FInt IntAnd(FInt A, FInt B) { return A & B; }
+		template<int32 Shift> static FORCEINLINE FInt ShiftRight(FInt A) { return A >> Shift; }
+		static FORCEINLINE FMask HasBits(FInt A, FInt Bits) { return (A & Bits) == Bits; }
+	};
+
+	//Lane operations on 4 samples
+	struct FVector4Lanes
+	{
+		using FFloat = VectorRegister4Float;
+		using FInt = VectorRegister4Int;
+		using FMask = VectorRegister4Float;
+
+		static FORCEINLINE FFloat Set(float Value) { return VectorSetFloat1(Value); }
+		static FORCEINLINE FInt SetInt(int32 Value) { return VectorIntSet1(Value); }
+
+		static FORCEINLINE FFloat Add(const FFloat& A, const FFloat& B) { return VectorAdd(A, B); }
+		static FORCEINLINE FFloat Sub(const FFloat& A, const FFloat& B) { return VectorSubtract(A, B); }
+		static FORCEINLINE FFloat Mul(const FFloat& A, const FFloat& B) { return VectorMultiply(A, B); }
+		static FORCEINLINE FFloat Floor(const FFloat& A) { return VectorFloor(A); }
+		static FORCEINLINE FFloat Abs(const FFloat& A) { return VectorAbs(A); }
+		static FORCEINLINE FFloat Sqrt(const FFloat& A) { return VectorSqrt(A); }
+		static FORCEINLINE FMask Less(const FFloat& A, const FFloat& B) { return VectorCompareLT(A, B); }
+		static FORCEINLINE FFloat Select(const FMask& Mask, const FFloat& A, const FFloat& B) { return VectorSelect(Mask, A, B); }
+
+		static FORCEINLINE FInt ToInt(const FFloat& A) { return VectorFloatToInt(A); }
+		static FORCEINLINE FFloat ToFloat(const FInt& A) { return VectorIntToFloat(A); }
+
+		static FORCEINLINE FInt IntAdd(const FInt& A, const FInt& B) { return VectorIntAdd(A, B); }
+		static FORCEINLINE FInt IntMul(const FInt& A, const FInt& B) { return VectorIntMultiply(A, B); }
+		static FORCEINLINE FInt IntXor(const FInt& A, const FInt& B) { return VectorIntXor(A, B); }
+		static FORCEINLINE FInt IntAnd(const FInt& A, const FInt& B) { return VectorIntAnd(A, B); }
+		template<int32 Shift> static FORCEINLINE FInt ShiftRight(const FInt& A) { return VectorShiftRightImmLogical(A, Shift); }
+		static FORCEINLINE FMask HasBits(const FInt& A, const FInt& Bits) { return VectorCastIntToFloat(VectorIntCompareEQ(VectorIntAnd(A, Bits), Bits)); }
+	};
+}
+
+namespace VoxelNoiseKernels
+{
+	constexpr int32 PrimeX = 501125321;
+	constexpr int32 PrimeY = 1136930381;
+	constexpr int32 HashMultiplier = 0x27d4eb2d;
+
+	template<typename L>
+	FORCEINLINE typename L::FInt Hash(const typename L::FInt& X, const typename L::FInt& Y, const typename L::FInt& Seed)
+	{
+		typename L::FInt H = L::IntXor(Seed, L::IntXor(L::IntMul(X, L::SetInt(PrimeX)), L::IntMul(Y, L::SetInt(PrimeY))));
+		H = L::IntMul(H, L::SetInt(HashMultiplier));
+		return L::IntXor(H, L::template ShiftRight<15>(H));
+	}
+
+	//One of the 4 diagonal gradients, picked by the hash, dotted with the offset to the corner
+	template<typename L>
+	FORCEINLINE typename L::FFloat Gradient(const typename L::FInt& H, const typename L::FFloat& X, const typename L::FFloat& Y)
+	{
+		const typename L::FFloat Zero = L::Set(0);
+		const typename L::FFloat GX = L::Select(L::HasBits(H, L::SetInt(1)), L::Sub(Zero, X), X);
+		const typename L::FFloat GY = L::Select(L::HasBits(H, L::SetInt(2)), L::Sub(Zero, Y), Y);
+		return L::Add(GX, GY);
+	}
+
+	template<typename L>
+	FORCEINLINE typename L::FFloat Fade(const typename L::FFloat& T)
+	{
+		//T^3 * (T * (6T - 15) + 10)
+		typename L::FFloat Polynomial = L::Mul(T, L::Set(6));
+		Polynomial = L::Sub(Polynomial, L::Set(15));
+		Polynomial = L::Mul(Polynomial, T);
+		Polynomial = L::Add(Polynomial, L::Set(10));
+		const typename L::FFloat Cube = L::Mul(L::Mul(T, T), T);
+		return L::Mul(Cube, Polynomial);
+	}
+
+	template<typename L>
+	FORCEINLINE typename L::FFloat Lerp(const typename L::FFloat& A, const typename L::FFloat& B, const typename L::FFloat& T)
+	{
+		return L::Add(A, L::Mul(T, L::Sub(B, A)));
+	}
+
+	template<typename L>
+	typename L::FFloat Perlin(const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& Seed)
+	{
+		const typename L::FFloat X0 = L::Floor(X);
+		const typename L::FFloat Y0 = L::Floor(Y);
+		const typename L::FInt IX = L::ToInt(X0);
+		const typename L::FInt IY = L::ToInt(Y0);
+		const typename L::FInt IX1 = L::IntAdd(IX, L::SetInt(1));
+		const typename L::FInt IY1 = L::IntAdd(IY, L::SetInt(1));
+
+		const typename L::FFloat FX = L::Sub(X, X0);
+		const typename L::FFloat FY = L::Sub(Y, Y0);
+		const typename L::FFloat FX1 = L::Sub(FX, L::Set(1));
+		const typename L::FFloat FY1 = L::Sub(FY, L::Set(1));
+
+		const typename L::FFloat G00 = Gradient<L>(Hash<L>(IX, IY, Seed), FX, FY);
+		const typename L::FFloat G10 = Gradient<L>(Hash<L>(IX1, IY, Seed), FX1, FY);
+		const typename L::FFloat G01 = Gradient<L>(Hash<L>(IX, IY1, Seed), FX, FY1);
+		const typename L::FFloat G11 = Gradient<L>(Hash<L>(IX1, IY1, Seed), FX1, FY1);
+
+		const typename L::FFloat U = Fade<L>(FX);
+		const typename L::FFloat V = Fade<L>(FY);
+		return Lerp<L>(Lerp<L>(G00, G10, U), Lerp<L>(G01, G11, U), V);
+	}
+
+	template<typename L>
+	FORCEINLINE typename L::FFloat HashToSignedUnit(const typename L::FInt& H)
+	{
+		return L::Sub(L::Mul(L::ToFloat(L::IntAnd(H, L::SetInt(0xFFFF))), L::Set(2.0f/65535)), L::Set(1));
+	}
+
+	template<typename L>
+	typename L::FFloat Value(const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& Seed)
+	{
+		const typename L::FFloat X0 = L::Floor(X);
+		const typename L::FFloat Y0 = L::Floor(Y);
+		const typename L::FInt IX = L::ToInt(X0);
+		const typename L::FInt IY = L::ToInt(Y0);
+		const typename L::FInt IX1 = L::IntAdd(IX, L::SetInt(1));
+		const typename L::FInt IY1 = L::IntAdd(IY, L::SetInt(1));
+
+		const typename L::FFloat V00 = HashToSignedUnit<L>(Hash<L>(IX, IY, Seed));
+		const typename L::FFloat V10 = HashToSignedUnit<L>(Hash<L>(IX1, IY, Seed));
+		const typename L::FFloat V01 = HashToSignedUnit<L>(Hash<L>(IX, IY1, Seed));
+		const typename L::FFloat V11 = HashToSignedUnit<L>(Hash<L>(IX1, IY1, Seed));
+
+		const typename L::FFloat U = Fade<L>(L::Sub(X, X0));
+		const typename L::FFloat V = Fade<L>(L::Sub(Y, Y0));
+		return Lerp<L>(Lerp<L>(V00, V10, U), Lerp<L>(V01, V11, U), V);
+	}
+
+	template<typename L>
+	FORCEINLINE typename L::FFloat SimplexCorner(const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& H)
+	{
+		//(0.5 - X^2 - Y^2)^4 * gradient, nothing outside of the corner's radius
+		const typename L::FFloat T = L::Sub(L::Sub(L::Set(0.5f), L::Mul(X, X)), L::Mul(Y, Y));
+		const typename L::FFloat T2 = L::Mul(T, T);
+		const typename L::FFloat Contribution = L::Mul(L::Mul(T2, T2), Gradient<L>(H, X, Y));
+		return L::Select(L::Less(L::Set(0), T), Contribution, L::Set(0));
+	}
+
+	template<typename L>
+	typename L::FFloat Simplex(const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& Seed)
+	{
+		constexpr float F2 = 0.36602540378f; //(sqrt(3) - 1)/2
+		constexpr float G2 = 0.21132486540f; //(3 - sqrt(3))/6
+
+		const typename L::FFloat Skew = L::Mul(L::Add(X, Y), L::Set(F2));
+		const typename L::FFloat I = L::Floor(L::Add(X, Skew));
+		const typename L::FFloat J = L::Floor(L::Add(Y, Skew));
+		const typename L::FFloat Unskew = L::Mul(L::Add(I, J), L::Set(G2));
+
+		const typename L::FFloat X0 = L::Sub(X, L::Sub(I, Unskew));
+		const typename L::FFloat Y0 = L::Sub(Y, L::Sub(J, Unskew));
+
+		//Middle corner of the simplex the sample is in, the lower or the upper triangle of the cell
+		const typename L::FMask Lower = L::Less(Y0, X0);
+		const typename L::FFloat I1 = L::Select(Lower, L::Set(1), L::Set(0));
+		const typename L::FFloat J1 = L::Sub(L::Set(1), I1);
+
+		const typename L::FFloat X1 = L::Add(L::Sub(X0, I1), L::Set(G2));
+		const typename L::FFloat Y1 = L::Add(L::Sub(Y0, J1), L::Set(G2));
+		const typename L::FFloat X2 = L::Add(L::Sub(X0, L::Set(1)), L::Set(2*G2));
+		const typename L::FFloat Y2 = L::Add(L::Sub(Y0, L::Set(1)), L::Set(2*G2));
+
+		const typename L::FInt II = L::ToInt(I);
+		const typename L::FInt IJ = L::ToInt(J);
+		const typename L::FInt H0 = Hash<L>(II, IJ, Seed);
+		const typename L::FInt H1 = Hash<L>(L::ToInt(L::Add(I, I1)), L::ToInt(L::Add(J, J1)), Seed);
+		const typename L::FInt H2 = Hash<L>(L::IntAdd(II, L::SetInt(1)), L::IntAdd(IJ, L::SetInt(1)), Seed);
+
+		const typename L::FFloat Sum = L::Add(L::Add(SimplexCorner<L>(X0, Y0, H0), SimplexCorner<L>(X1, Y1, H1)), SimplexCorner<L>(X2, Y2, H2));
+		return L::Mul(Sum, L::Set(70));
+	}
+
+	template<typename L>
+	typename L::FFloat Cellular(const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& Seed)
+	{
+		/*One feature point per cell, jittered by the hash of the cell, the nearest one is searched in the 3x3 cells around the sample*/
+		const typename L::FFloat X0 = L::Floor(X);
+		const typename L::FFloat Y0 = L::Floor(Y);
+		const typename L::FFloat JitterScale = L::Set(1.0f/65536);
+
+		typename L::FFloat NearestSquaredDistance = L::Set(8);
+		for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+		{
+			const typename L::FFloat CellX = L::Add(X0, L::Set(OffsetX));
+			for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+			{
+				const typename L::FFloat CellY = L::Add(Y0, L::Set(OffsetY));
+				const typename L::FInt H = Hash<L>(L::ToInt(CellX), L::ToInt(CellY), Seed);
+
+				const typename L::FFloat FeatureX = L::Add(CellX, L::Mul(L::ToFloat(L::IntAnd(H, L::SetInt(0xFFFF))), JitterScale));
+				const typename L::FFloat FeatureY = L::Add(CellY, L::Mul(L::ToFloat(L::template ShiftRight<16>(H)), JitterScale));
+				const typename L::FFloat DX = L::Sub(FeatureX, X);
+				const typename L::FFloat DY = L::Sub(FeatureY, Y);
+				const typename L::FFloat SquaredDistance = L::Add(L::Mul(DX, DX), L::Mul(DY, DY));
+
+				NearestSquaredDistance = L::Select(L::Less(SquaredDistance, NearestSquaredDistance), SquaredDistance, NearestSquaredDistance);
+			}
+		}
+
+		//The nearest feature point is at most sqrt(2) away, [0, 1] covers almost every sample
+		return L::Sub(L::Mul(L::Sqrt(NearestSquaredDistance), L::Set(2)), L::Set(1));
+	}
+
+	template<typename L>
+	FORCEINLINE typename L::FFloat BaseNoise(EVoxelNoiseType Type, const typename L::FFloat& X, const typename L::FFloat& Y, const typename L::FInt& Seed)
+	{
+		switch (Type)
+		{
+		case EVoxelNoiseType::Simplex:
+			return Simplex<L>(X, Y, Seed);
+		case EVoxelNoiseType::Value:
+			return Value<L>(X, Y, Seed);
+		case EVoxelNoiseType::Cellular:
+			return Cellular<L>(X, Y, Seed);
+		default:
+			return Perlin<L>(X, Y, Seed);
+		}
+	}
+
+	template<typename L>
+	typename L::FFloat Fractal(const FVoxelNoiseSettings& Settings, const typename L::FFloat& X, const typename L::FFloat& Y)
+	{
+		/*The frequencies and amplitudes of the octaves are computed on scalars, identically for both paths*/
+		const int32 Octaves = Settings.Fractal == EVoxelNoiseFractal::None ? 1 : FMath::Max(Settings.Octaves, 1);
+
+		typename L::FFloat Sum = L::Set(0);
+		float Frequency = Settings.Frequency;
+		float Amplitude = 1;
+		float TotalAmplitude = 0;
+		for (int32 Octave = 0; Octave < Octaves; Octave++)
+		{
+			const typename L::FFloat OctaveFrequency = L::Set(Frequency);
+			typename L::FFloat Noise = BaseNoise<L>(Settings.Type, L::Mul(X, OctaveFrequency), L::Mul(Y, OctaveFrequency), L::SetInt(Settings.Seed + Octave));
+			if (Settings.Fractal == EVoxelNoiseFractal::Ridged)
+			{
+				Noise = L::Sub(L::Set(1), L::Abs(Noise));
+			}
+			Sum = L::Add(Sum, L::Mul(Noise, L::Set(Amplitude)));
+
+			TotalAmplitude += Amplitude;
+			Amplitude *= Settings.Gain;
+			Frequency *= Settings.Lacunarity;
+		}
+
+		typename L::FFloat Result = L::Mul(Sum, L::Set(1/TotalAmplitude));
+		if (Settings.Fractal == EVoxelNoiseFractal::Ridged)
+		{
+			Result = L::Sub(L::Mul(Result, L::Set(2)), L::Set(1));
+		}
+		return Result;
+	}
+}
+
+float FVoxelNoise::Evaluate2D(const FVoxelNoiseSettings& Settings, float X, float Y)
+{
+	return VoxelNoiseKernels::Fractal<VoxelNoiseLanes::FScalarLanes>(Settings, X, Y);
+}
+
+void FVoxelNoise::Evaluate2D(const FVoxelNoiseSettings& Settings, const float* X, const float* Y, float* OutValues, int32 Count)
+{
+	int32 i = 0;
+	for (; i + 4 <= Count; i += 4)
+	{
+		const VectorRegister4Float Values = VoxelNoiseKernels::Fractal<VoxelNoiseLanes::FVector4Lanes>(Settings, VectorLoad(X + i), VectorLoad(Y + i));
+		VectorStore(Values, OutValues + i);
+	}
+	for (; i < Count; i++)
+	{
+		OutValues[i] = VoxelNoiseKernels::Fractal<VoxelNoiseLanes::FScalarLanes>(Settings, X[i], Y[i]);
+	}
+}
+
+void FVoxelNoise::Evaluate2DScalar(const FVoxelNoiseSettings& Settings, const float* X, const float* Y, float* OutValues, int32 Count)
+{
+	for (int32 i = 0; i < Count; i++)
+	{
+		OutValues[i] = VoxelNoiseKernels::Fractal<VoxelNoiseLanes::FScalarLanes>(Settings, X[i], Y[i]);
+	}
+}
+
+void FVoxelNoise::EvaluateGrid2D(const FVoxelNoiseSettings& Settings, FVector2f Origin, float Step, int32 SizeX, int32 SizeY, float* OutValues)
+{
+	/*Samples are evaluated along Y, 4 at a time, each sample's coordinates are computed the same way whatever its lane*/
+	TArray<float, TInlineAllocator<64>> YCoordinates;
+	YCoordinates.SetNum(SizeY);
+	for (int32 y = 0; y < SizeY; y++)
+	{
+		YCoordinates[y] = Origin.Y + Step*y;
+	}
+
+	TArray<float, TInlineAllocator<64>> XCoordinates;
+	XCoordinates.SetNum(SizeY);
+	for (int32 x = 0; x < SizeX; x++)
+	{
+		const float XCoordinate = Origin.X + Step*x;
+		for (int32 y = 0; y < SizeY; y++)
+		{
+			XCoordinates[y] = XCoordinate;
+		}
+		Evaluate2D(Settings, XCoordinates.GetData(), YCoordinates.GetData(), OutValues + x*SizeY, SizeY);
+	}
+}
@@ -0,0 +1,159 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelRegionCache.h"
+
+TMap<FIntVector, FChunkData>* FVoxelRegionCache::Find(FIntVector RegionLocation)
+{
+	if (const auto Entry = Entries.Find(RegionLocation))
+	{
+		Stats.Hits += 1;
+		return &Touch(RegionLocation, *Entry).Chunks;
+	}
+	Stats.Misses += 1;
+	return nullptr;
+}
+
+TMap<FIntVector, FChunkData>& FVoxelRegionCache::FindOrAdd(FIntVector RegionLocation)
+{
+	return Touch(RegionLocation, Entries.FindOrAdd(RegionLocation)).Chunks;
+}
+
+bool FVoxelRegionCache::Contains(FIntVector RegionLocation) const
+{
+	return Entries.Contains(RegionLocation);
+}
+
+const TMap<FIntVector, FChunkData>* FVoxelRegionCache::Peek(FIntVector RegionLocation) const
+{
+	const auto Entry = Entries.Find(RegionLocation);
+	return Entry ? &Entry->Chunks : nullptr;
+}
+
+void FVoxelRegionCache::Remove(FIntVector RegionLocation)
+{
+	if (const auto Entry = Entries.Find(RegionLocation))
+	{
+		ResidentBytes -= Entry->Bytes;
+		Entries.Remove(RegionLocation);
+		RegionsWithStaleSize.Remove(RegionLocation);
+	}
+}
+
+void FVoxelRegionCache::Pin(FIntVector RegionLocation)
+{
+	PinCounts.FindOrAdd(RegionLocation) += 1;
+}
+
+void FVoxelRegionCache::Unpin(FIntVector RegionLocation)
+{
+	if (const auto PinCount = PinCounts.Find(RegionLocation))
+	{
+		*PinCount -= 1;
+		if (*PinCount <= 0)
+		{
+			PinCounts.Remove(RegionLocation);
+		}
+	}
+}
+
+bool FVoxelRegionCache::IsPinned(FIntVector RegionLocation) const
+{
+	return PinCounts.Contains(RegionLocation);
+}
+
+void FVoxelRegionCache::GetEvictionCandidates(int64 ByteBudget, TArray<FIntVector>& OutCandidates)
+{
+	/*Only called when the cache may be over budget, sorting the entries is then cheap compared to writing regions back*/
+	RefreshStaleSizes();
+	if (ResidentBytes <= ByteBudget)
+	{
+		return;
+	}
+
+	TArray<TTuple<uint64, FIntVector, int64>> SortedEntries;
+	for (const auto& EntryPair : Entries)
+	{
+		if (!IsPinned(EntryPair.Key))
+		{
+			SortedEntries.Add(MakeTuple(EntryPair.Value.LastAccess, EntryPair.Key, EntryPair.Value.Bytes));
+		}
+	}
+	SortedEntries.Sort([](const TTuple<uint64, FIntVector, int64>& A, const TTuple<uint64, FIntVector, int64>& B)
+	{
+		return A.Get<0>() < B.Get<0>();
+	});
+
+	int64 BytesAfterEviction = ResidentBytes;
+	for (const auto& Entry : SortedEntries)
+	{
+		if (BytesAfterEviction <= ByteBudget)
+		{
+			break;
+		}
+		OutCandidates.Add(Entry.Get<1>());
+		BytesAfterEviction -= Entry.Get<2>();
+	}
+}
+
+int64 FVoxelRegionCache::GetResidentBytes()
+{
+	RefreshStaleSizes();
+	return ResidentBytes;
+}
+
+void FVoxelRegionCache::RecordEviction()
+{
+	Stats.Evictions += 1;
+}
+
+void FVoxelRegionCache::RecordWriteBack()
+{
+	Stats.WriteBacks += 1;
+}
+
+FVoxelRegionCacheStats FVoxelRegionCache::GetStats()
+{
+	RefreshStaleSizes();
+	Stats.ResidentBytes = ResidentBytes;
+	Stats.ResidentRegions = Entries.Num();
+	return Stats;
+}
+
+void FVoxelRegionCache::LogStats()
+{
+	const auto CurrentStats = GetStats();
+	const int64 Lookups = CurrentStats.Hits + CurrentStats.Misses;
+	const double HitRate = Lookups > 0 ? 100.0*CurrentStats.Hits/Lookups : 0;
+	UE_LOG(LogTemp, Display, TEXT("Region cache: %d regions, %f MB resident, %lld hits, %lld misses, hit rate %f%%, %lld evictions, %lld write-backs"), CurrentStats.ResidentRegions, CurrentStats.ResidentBytes/(1024.0*1024.0), CurrentStats.Hits, CurrentStats.Misses, HitRate, CurrentStats.Evictions, CurrentStats.WriteBacks);
+}
+
+int64 FVoxelRegionCache::GetChunkDataBytes(const FChunkData& ChunkData)
+{
+	return sizeof(FChunkData) + ChunkData.UncompressedChunkData.GetAllocatedSize() + ChunkData.CompressedChunkData.GetAllocatedSize() + ChunkData.AdditiveVoxels.GetAllocatedSize();
+}
+
+FVoxelRegionCache::FRegionCacheEntry& FVoxelRegionCache::Touch(FIntVector RegionLocation, FRegionCacheEntry& Entry)
+{
+	/*The chunks may be modified through the returned entry, so its size is computed again before the next eviction*/
+	AccessClock += 1;
+	Entry.LastAccess = AccessClock;
+	RegionsWithStaleSize.Add(RegionLocation);
+	return Entry;
+}
+
+void FVoxelRegionCache::RefreshStaleSizes()
+{
+	for (const auto& RegionLocation : RegionsWithStaleSize)
+	{
+		if (const auto Entry = Entries.Find(RegionLocation))
+		{
+			int64 Bytes = 0;
+			for (const auto& ChunkPair : Entry->Chunks)
+			{
+				Bytes += GetChunkDataBytes(ChunkPair.Value);
+			}
+			ResidentBytes += Bytes - Entry->Bytes;
+			Entry->Bytes = Bytes;
+		}
+	}
+	RegionsWithStaleSize.Empty();
+}
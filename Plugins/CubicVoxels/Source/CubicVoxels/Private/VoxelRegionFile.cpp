@@ -0,0 +1,751 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FVoxelRegionFile::FVoxelRegionFile(const FString& InFilePath, FIntVector InRegionLocation, EVoxelRegionFileContent InContent)
+{
+	FilePath = InFilePath;
+	RegionLocation = InRegionLocation;
+	Content = InContent;
+}
+
+FVoxelRegionFile::~FVoxelRegionFile()
+{
+	Close();
+}
+
+bool FVoxelRegionFile::Open(bool CreateIfMissing)
+{
+	FScopeLock Lock(&FileMutex);
+	if (IsOpen())
+	{
+		return true;
+	}
+
+	RecoverInterruptedReplace();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const bool FileExists = PlatformFile.FileExists(*FilePath);
+	if (!FileExists && !CreateIfMissing)
+	{
+		return false;
+	}
+
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+
+	//Opened for appending so that an existing file is not truncated, writes still go wherever the handle is seeked to
+	FileHandle.Reset(PlatformFile.OpenWrite(*FilePath, true, true));
+	if (!FileHandle)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open region file %s"), *FilePath)
+		return false;
+	}
+
+	if (FileExists && FileHandle->Size() > 0)
+	{
+		if (ReadHeaderAndTable())
+		{
+			return true;
+		}
+
+		if (Content == EVoxelRegionFileContent::Chunks)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Region file %s is corrupted"), *FilePath)
+			Close();
+			return false;
+		}
+
+		//A mesh cache that can't be read, which may have been written by a newer version, is only started over by a writer, readers mesh the chunks instead
+		if (!CreateIfMissing)
+		{
+			Close();
+			return false;
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("Mesh cache file %s can't be read, it is started over"), *FilePath)
+		FileHandle.Reset(PlatformFile.OpenWrite(*FilePath, false, true));
+		if (!FileHandle)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not open region file %s"), *FilePath)
+			return false;
+		}
+	}
+
+	ChunkTable.Empty();
+	TableOffset = HeaderSize;
+	UnusedBytes = 0;
+	Version = FileVersion;
+	if (!WriteHeader() || !WriteTable())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FVoxelRegionFile::Close()
+{
+	FScopeLock Lock(&FileMutex);
+	if (FileHandle)
+	{
+		FileHandle->Flush();
+		FileHandle.Reset();
+	}
+}
+
+bool FVoxelRegionFile::IsOpen() const
+{
+	FScopeLock Lock(&FileMutex);
+	return FileHandle.IsValid();
+}
+
+bool FVoxelRegionFile::Contains(FIntVector ChunkLocation) const
+{
+	FScopeLock Lock(&FileMutex);
+	return IsInRegion(ChunkLocation) && ChunkTable.Contains(GetLocalIndex(ChunkLocation));
+}
+
+int32 FVoxelRegionFile::Num() const
+{
+	FScopeLock Lock(&FileMutex);
+	return ChunkTable.Num();
+}
+
+TArray<FIntVector> FVoxelRegionFile::GetChunkLocations() const
+{
+	FScopeLock Lock(&FileMutex);
+	TArray<FIntVector> Result;
+	Result.Reserve(ChunkTable.Num());
+	for (const auto& EntryPair : ChunkTable)
+	{
+		Result.Add(GetChunkLocation(EntryPair.Key));
+	}
+	return Result;
+}
+
+bool FVoxelRegionFile::ReadChunk(FIntVector ChunkLocation, FChunkData& OutChunkData)
+{
+	FScopeLock Lock(&FileMutex);
+	const auto Entry = IsInRegion(ChunkLocation) ? ChunkTable.Find(GetLocalIndex(ChunkLocation)) : nullptr;
+	if (!IsOpen() || !Entry)
+	{
+		return false;
+	}
+
+	TArray<uint8> CompressedBytes;
+	return ReadBlob(*Entry, CompressedBytes) && DecodeChunk(CompressedBytes, Entry->LegacyUncompressedSize, OutChunkData);
+}
+
+bool FVoxelRegionFile::WriteChunk(FIntVector ChunkLocation, const FChunkData& ChunkData)
+{
+	TMap<FIntVector, FChunkData> Chunks;
+	Chunks.Add(ChunkLocation, ChunkData);
+	return WriteChunks(Chunks);
+}
+
+bool FVoxelRegionFile::WriteChunks(const TMap<FIntVector, FChunkData>& Chunks)
+{
+	FScopeLock Lock(&FileMutex);
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(Chunks.Num());
+	for (const auto& ChunkPair : Chunks)
+	{
+		if (!AddBlob(ChunkPair.Key, ChunkPair.Value, Blobs))
+		{
+			return false;
+		}
+	}
+	return CommitBlobs(Blobs);
+}
+
+bool FVoxelRegionFile::WriteChunks(const TMap<FIntVector, TSharedPtr<FChunkData>>& Chunks)
+{
+	/*Used by saves running off the game thread, the chunks are snapshots that are not modified anymore*/
+	FScopeLock Lock(&FileMutex);
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(Chunks.Num());
+	for (const auto& ChunkPair : Chunks)
+	{
+		if (ChunkPair.Value.IsValid() && !AddBlob(ChunkPair.Key, *ChunkPair.Value, Blobs))
+		{
+			return false;
+		}
+	}
+	return CommitBlobs(Blobs);
+}
+
+bool FVoxelRegionFile::WriteEncodedChunks(TMap<FIntVector, TArray<uint8>>& EncodedChunks)
+{
+	FScopeLock Lock(&FileMutex);
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(EncodedChunks.Num());
+	for (auto& ChunkPair : EncodedChunks)
+	{
+		if (!IsInRegion(ChunkPair.Key))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Tried to write chunk %d, %d, %d in the file of another region"), ChunkPair.Key.X, ChunkPair.Key.Y, ChunkPair.Key.Z)
+			continue;
+		}
+
+		FChunkBlob& Blob = Blobs.AddDefaulted_GetRef();
+		Blob.LocalIndex = GetLocalIndex(ChunkPair.Key);
+		Blob.CompressedBytes = MoveTemp(ChunkPair.Value);
+	}
+	return CommitBlobs(Blobs);
+}
+
+bool FVoxelRegionFile::ReadEncodedChunk(FIntVector ChunkLocation, TArray<uint8>& OutBytes)
+{
+	FScopeLock Lock(&FileMutex);
+	const auto Entry = IsInRegion(ChunkLocation) ? ChunkTable.Find(GetLocalIndex(ChunkLocation)) : nullptr;
+	if (!IsOpen() || !Entry)
+	{
+		return false;
+	}
+	return ReadBlob(*Entry, OutBytes);
+}
+
+bool FVoxelRegionFile::IsCurrentVersion() const
+{
+	FScopeLock Lock(&FileMutex);
+	return Version == FileVersion;
+}
+
+bool FVoxelRegionFile::ReadRegion(TMap<FIntVector, FChunkData>& OutRegionData)
+{
+	/*Blobs are read in file order to keep the reads sequential*/
+	FScopeLock Lock(&FileMutex);
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	TArray<TTuple<int32, FChunkEntry>> SortedEntries;
+	for (const auto& EntryPair : ChunkTable)
+	{
+		SortedEntries.Add(MakeTuple(EntryPair.Key, EntryPair.Value));
+	}
+	SortedEntries.Sort([](const TTuple<int32, FChunkEntry>& A, const TTuple<int32, FChunkEntry>& B)
+	{
+		return A.Get<1>().Offset < B.Get<1>().Offset;
+	});
+
+	TArray<uint8> CompressedBytes;
+	for (const auto& Entry : SortedEntries)
+	{
+		FChunkData ChunkData;
+		if (!ReadBlob(Entry.Get<1>(), CompressedBytes) || !DecodeChunk(CompressedBytes, Entry.Get<1>().LegacyUncompressedSize, ChunkData))
+		{
+			return false;
+		}
+		OutRegionData.Add(GetChunkLocation(Entry.Get<0>()), ChunkData);
+	}
+	return true;
+}
+
+bool FVoxelRegionFile::WriteRegion(const TMap<FIntVector, FChunkData>& RegionData)
+{
+	FScopeLock Lock(&FileMutex);
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(RegionData.Num());
+	for (const auto& ChunkPair : RegionData)
+	{
+		if (!AddBlob(ChunkPair.Key, ChunkPair.Value, Blobs))
+		{
+			return false;
+		}
+	}
+	return ReplaceContent(Blobs);
+}
+
+bool FVoxelRegionFile::Compact()
+{
+	/*The blobs are copied as they are, without being decompressed*/
+	FScopeLock Lock(&FileMutex);
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	//Blobs of the former encoding can't be copied into a file of the current version
+	if (Version < FileVersion)
+	{
+		return UpgradeFormat();
+	}
+
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(ChunkTable.Num());
+	for (const auto& EntryPair : ChunkTable)
+	{
+		FChunkBlob& Blob = Blobs.AddDefaulted_GetRef();
+		Blob.LocalIndex = EntryPair.Key;
+		if (!ReadBlob(EntryPair.Value, Blob.CompressedBytes))
+		{
+			return false;
+		}
+	}
+	return ReplaceContent(Blobs);
+}
+
+int64 FVoxelRegionFile::GetFileSize() const
+{
+	FScopeLock Lock(&FileMutex);
+	return IsOpen() ? FileHandle->Size() : 0;
+}
+
+int64 FVoxelRegionFile::GetUnusedBytes() const
+{
+	FScopeLock Lock(&FileMutex);
+	return UnusedBytes;
+}
+
+FString FVoxelRegionFile::GetRegionFilePath(const FString& WorldName, FIntVector RegionLocation)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VoxelWorlds"), WorldName, TEXT("Regions"), FString::Printf(TEXT("r.%d.%d.%d.cvr"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z));
+}
+
+bool FVoxelRegionFile::DeserializeLegacyChunk(const TArray<uint8>& Bytes, FChunkData& OutChunkData)
+{
+	FMemoryReader Reader(Bytes);
+
+	uint8 Flags = 0;
+	Reader << Flags;
+
+	uint16 PaletteCount = 0;
+	Reader << PaletteCount;
+	TArray<FVoxel> Palette;
+	Palette.SetNum(PaletteCount);
+	for (auto& Voxel : Palette)
+	{
+		FString VoxelType;
+		uint8 IsTransparent = 0;
+		uint8 IsSolid = 0;
+		Reader << VoxelType << IsTransparent << IsSolid;
+		Voxel.VoxelType = FName(*VoxelType);
+		Voxel.IsTransparent = IsTransparent != 0;
+		Voxel.IsSolid = IsSolid != 0;
+	}
+
+	if (Flags & ChunkSparseFlag)
+	{
+		int32 EditCount = 0;
+		Reader << EditCount;
+		if (Reader.IsError() || EditCount < 0 || EditCount > ChunkSize*ChunkSize*ChunkSize)
+		{
+			return false;
+		}
+
+		OutChunkData = FChunkData::SparseAdditiveChunkData();
+		OutChunkData.AdditiveVoxels.SetNum(EditCount);
+		for (int32 i = 0; i < EditCount; i++)
+		{
+			uint16 VoxelIndex = 0;
+			uint16 PaletteIndex = 0;
+			Reader << VoxelIndex << PaletteIndex;
+			//Edits are written in increasing voxel index order, which the binary search of FChunkData relies on
+			if (Reader.IsError() || PaletteIndex >= PaletteCount || VoxelIndex >= ChunkSize*ChunkSize*ChunkSize || (i > 0 && VoxelIndex <= OutChunkData.AdditiveVoxels[i-1].VoxelIndex))
+			{
+				return false;
+			}
+			OutChunkData.AdditiveVoxels[i] = FAdditiveVoxel(VoxelIndex, Palette[PaletteIndex]);
+		}
+		return true;
+	}
+
+	int32 RunCount = 0;
+	Reader << RunCount;
+	if (Reader.IsError() || RunCount < 0 || RunCount > ChunkSize*ChunkSize*ChunkSize)
+	{
+		return false;
+	}
+
+	OutChunkData.IsCompressed = false;
+	OutChunkData.IsSparse = false;
+	OutChunkData.AdditiveVoxels.Empty();
+	OutChunkData.IsAdditive = (Flags & ChunkAdditiveFlag) != 0;
+	OutChunkData.UncompressedChunkData.SetNum(ChunkSize*ChunkSize*ChunkSize);
+
+	int32 VoxelIndex = 0;
+	for (int32 i = 0; i < RunCount; i++)
+	{
+		uint16 PaletteIndex = 0;
+		uint16 RunLength = 0;
+		Reader << PaletteIndex << RunLength;
+		if (Reader.IsError() || PaletteIndex >= PaletteCount || VoxelIndex + RunLength > ChunkSize*ChunkSize*ChunkSize)
+		{
+			return false;
+		}
+
+		for (int32 j = 0; j < RunLength; j++)
+		{
+			OutChunkData.UncompressedChunkData[VoxelIndex + j] = Palette[PaletteIndex];
+		}
+		VoxelIndex += RunLength;
+	}
+
+	//Dense additive data written before edits were stored sparsely
+	OutChunkData.MakeSparse();
+
+	return VoxelIndex == ChunkSize*ChunkSize*ChunkSize;
+}
+
+bool FVoxelRegionFile::IsInRegion(FIntVector ChunkLocation) const
+{
+	const FIntVector LocalLocation = ChunkLocation - RegionSize*RegionLocation;
+	return LocalLocation.X >= 0 && LocalLocation.Y >= 0 && LocalLocation.Z >= 0 && LocalLocation.X < RegionSize && LocalLocation.Y < RegionSize && LocalLocation.Z < RegionSize;
+}
+
+int32 FVoxelRegionFile::GetLocalIndex(FIntVector ChunkLocation) const
+{
+	const FIntVector LocalLocation = ChunkLocation - RegionSize*RegionLocation;
+	return LocalLocation.X*RegionSize*RegionSize + LocalLocation.Y*RegionSize + LocalLocation.Z;
+}
+
+FIntVector FVoxelRegionFile::GetChunkLocation(int32 LocalIndex) const
+{
+	return RegionSize*RegionLocation + FIntVector(LocalIndex/(RegionSize*RegionSize), (LocalIndex/RegionSize)%RegionSize, LocalIndex%RegionSize);
+}
+
+bool FVoxelRegionFile::ReadHeaderAndTable()
+{
+	const int64 FileSize = FileHandle->Size();
+	if (FileSize < HeaderSize)
+	{
+		return false;
+	}
+
+	TArray<uint8> HeaderBytes;
+	HeaderBytes.SetNum(HeaderSize);
+	if (!FileHandle->Seek(0) || !FileHandle->Read(HeaderBytes.GetData(), HeaderSize))
+	{
+		return false;
+	}
+
+	FMemoryReader HeaderReader(HeaderBytes);
+	uint32 Magic = 0;
+	FIntVector StoredRegionLocation;
+	int32 NumberOfEntries = 0;
+	HeaderReader << Magic << Version << StoredRegionLocation.X << StoredRegionLocation.Y << StoredRegionLocation.Z << NumberOfEntries << TableOffset;
+
+	if (Magic != GetFileMagic() || Version < 1 || Version > FileVersion || StoredRegionLocation != RegionLocation || NumberOfEntries < 0 || TableOffset < HeaderSize || TableOffset + NumberOfEntries*GetTableEntrySize() > FileSize)
+	{
+		return false;
+	}
+
+	TArray<uint8> TableBytes;
+	TableBytes.SetNum(NumberOfEntries*GetTableEntrySize());
+	if (!FileHandle->Seek(TableOffset) || !FileHandle->Read(TableBytes.GetData(), TableBytes.Num()))
+	{
+		return false;
+	}
+
+	ChunkTable.Empty(NumberOfEntries);
+	int64 UsedBytes = HeaderSize + TableBytes.Num();
+	FMemoryReader TableReader(TableBytes);
+	for (int32 i = 0; i < NumberOfEntries; i++)
+	{
+		int32 LocalIndex = 0;
+		FChunkEntry Entry;
+		TableReader << LocalIndex << Entry.Offset << Entry.CompressedSize;
+		if (Version < 2)
+		{
+			TableReader << Entry.LegacyUncompressedSize;
+		}
+		if (Entry.Offset < HeaderSize || Entry.Offset + Entry.CompressedSize > FileSize)
+		{
+			return false;
+		}
+		ChunkTable.Add(LocalIndex, Entry);
+		UsedBytes += Entry.CompressedSize;
+	}
+
+	UnusedBytes = FileSize - UsedBytes;
+	return true;
+}
+
+bool FVoxelRegionFile::WriteHeader()
+{
+	TArray<uint8> HeaderBytes;
+	FMemoryWriter HeaderWriter(HeaderBytes);
+	uint32 Magic = GetFileMagic();
+	uint32 WrittenVersion = FileVersion;
+	FIntVector StoredRegionLocation = RegionLocation;
+	int32 NumberOfEntries = ChunkTable.Num();
+	HeaderWriter << Magic << WrittenVersion << StoredRegionLocation.X << StoredRegionLocation.Y << StoredRegionLocation.Z << NumberOfEntries << TableOffset;
+
+	return FileHandle->Seek(0) && FileHandle->Write(HeaderBytes.GetData(), HeaderBytes.Num()) && FileHandle->Flush();
+}
+
+bool FVoxelRegionFile::WriteTable()
+{
+	TArray<uint8> TableBytes;
+	FMemoryWriter TableWriter(TableBytes);
+	for (auto& EntryPair : ChunkTable)
+	{
+		int32 LocalIndex = EntryPair.Key;
+		TableWriter << LocalIndex << EntryPair.Value.Offset << EntryPair.Value.CompressedSize;
+	}
+
+	return FileHandle->Seek(TableOffset) && FileHandle->Write(TableBytes.GetData(), TableBytes.Num());
+}
+
+bool FVoxelRegionFile::AppendBlobs(const TArray<FChunkBlob>& Blobs)
+{
+	/*The old table stays valid until the header points to the new one, so an interrupted write loses the new chunks but never the old ones*/
+	int64 WriteOffset = FileHandle->Size();
+	if (!FileHandle->Seek(WriteOffset))
+	{
+		return false;
+	}
+
+	UnusedBytes += ChunkTable.Num()*GetTableEntrySize();
+
+	for (const auto& Blob : Blobs)
+	{
+		if (!FileHandle->Write(Blob.CompressedBytes.GetData(), Blob.CompressedBytes.Num()))
+		{
+			return false;
+		}
+
+		FChunkEntry& Entry = ChunkTable.FindOrAdd(Blob.LocalIndex);
+		UnusedBytes += Entry.CompressedSize;
+		Entry.Offset = WriteOffset;
+		Entry.CompressedSize = Blob.CompressedBytes.Num();
+		Entry.LegacyUncompressedSize = 0;
+		WriteOffset += Blob.CompressedBytes.Num();
+	}
+
+	TableOffset = WriteOffset;
+	return WriteTable() && WriteHeader();
+}
+
+bool FVoxelRegionFile::ReplaceContent(const TArray<FChunkBlob>& Blobs)
+{
+	/*The new content is written next to the file, then the file is moved to a backup, the new content moved in its place and the backup deleted
+	 *There is a complete copy of the region on disk at every step, RecoverInterruptedReplace finds it if the process stops in between
+	 */
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TemporaryFilePath = FilePath + TEXT(".tmp");
+	const FString BackupFilePath = FilePath + TEXT(".bak");
+
+	Close();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+
+	{
+		FVoxelRegionFile TemporaryFile(TemporaryFilePath, RegionLocation, Content);
+		PlatformFile.DeleteFile(*TemporaryFilePath);
+		if (!TemporaryFile.Open(true) || !TemporaryFile.AppendBlobs(Blobs))
+		{
+			PlatformFile.DeleteFile(*TemporaryFilePath);
+			Open(false);
+			return false;
+		}
+	}
+
+	//The backup is only created once the new content is complete, so a temporary file without a backup is never used by the recovery
+	const bool HadFile = PlatformFile.FileExists(*FilePath);
+	PlatformFile.DeleteFile(*BackupFilePath);
+	if (HadFile && !PlatformFile.MoveFile(*BackupFilePath, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not replace region file %s"), *FilePath)
+		PlatformFile.DeleteFile(*TemporaryFilePath);
+		Open(false);
+		return false;
+	}
+
+	if (!PlatformFile.MoveFile(*FilePath, *TemporaryFilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not replace region file %s"), *FilePath)
+		PlatformFile.DeleteFile(*TemporaryFilePath);
+		if (HadFile)
+		{
+			PlatformFile.MoveFile(*FilePath, *BackupFilePath);
+		}
+		Open(false);
+		return false;
+	}
+
+	PlatformFile.DeleteFile(*BackupFilePath);
+	return Open(false);
+}
+
+void FVoxelRegionFile::RecoverInterruptedReplace() const
+{
+	/*The steps of ReplaceContent are undone or finished depending on the files they left behind:
+	 *a backup along with the file means the new content was moved in, a backup alone means it was not, and then the temporary file is complete
+	 *a temporary file without a backup may be incomplete and is only used if there is nothing else
+	 */
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TemporaryFilePath = FilePath + TEXT(".tmp");
+	const FString BackupFilePath = FilePath + TEXT(".bak");
+
+	const bool FileExists = PlatformFile.FileExists(*FilePath);
+	const bool TemporaryFileExists = PlatformFile.FileExists(*TemporaryFilePath);
+	const bool BackupFileExists = PlatformFile.FileExists(*BackupFilePath);
+	if (!TemporaryFileExists && !BackupFileExists)
+	{
+		return;
+	}
+
+	if (BackupFileExists && !FileExists)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Recovering region file %s from an interrupted rewrite"), *FilePath)
+		if (!PlatformFile.MoveFile(*FilePath, TemporaryFileExists ? *TemporaryFilePath : *BackupFilePath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not recover region file %s"), *FilePath)
+			return;
+		}
+	}
+	else if (TemporaryFileExists && !FileExists)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Recovering region file %s from an interrupted rewrite"), *FilePath)
+		PlatformFile.MoveFile(*FilePath, *TemporaryFilePath);
+	}
+
+	PlatformFile.DeleteFile(*TemporaryFilePath);
+	PlatformFile.DeleteFile(*BackupFilePath);
+}
+
+bool FVoxelRegionFile::ReadBlob(const FChunkEntry& Entry, TArray<uint8>& OutCompressedBytes)
+{
+	OutCompressedBytes.SetNumUninitialized(Entry.CompressedSize);
+	return FileHandle->Seek(Entry.Offset) && FileHandle->Read(OutCompressedBytes.GetData(), Entry.CompressedSize);
+}
+
+bool FVoxelRegionFile::AddBlob(FIntVector ChunkLocation, const FChunkData& ChunkData, TArray<FChunkBlob>& Blobs) const
+{
+	/*Chunks of other regions are skipped, only an encoding failure is an error*/
+	if (Content != EVoxelRegionFileContent::Chunks)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Tried to write chunk data in %s, which doesn't hold chunks"), *FilePath)
+		return false;
+	}
+	if (!IsInRegion(ChunkLocation))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Tried to write chunk %d, %d, %d in the file of another region"), ChunkLocation.X, ChunkLocation.Y, ChunkLocation.Z)
+		return true;
+	}
+
+	FChunkBlob& Blob = Blobs.AddDefaulted_GetRef();
+	Blob.LocalIndex = GetLocalIndex(ChunkLocation);
+	return EncodeChunk(ChunkData, Blob);
+}
+
+bool FVoxelRegionFile::CommitBlobs(const TArray<FChunkBlob>& Blobs)
+{
+	//Files of a previous version are upgraded by their first write rather than when they are opened, so that reading an old save never rewrites it
+	if (Version < FileVersion && !UpgradeFormat())
+	{
+		return false;
+	}
+
+	if (!AppendBlobs(Blobs))
+	{
+		return false;
+	}
+
+	//Rewrites keep appending until the unused space outweighs the chunks themselves
+	if (UnusedBytes > FMath::Max<int64>(1 << 20, GetFileSize() - UnusedBytes))
+	{
+		return Compact();
+	}
+	return true;
+}
+
+bool FVoxelRegionFile::EncodeChunk(const FChunkData& ChunkData, FChunkBlob& OutBlob)
+{
+	/*The codec stores the size of the chunk before compression in the blob itself, the table gives the size of the blob*/
+	if (!FVoxelChunkCodec::Encode(ChunkData, OutBlob.CompressedBytes, BlobCompression))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not encode chunk data"))
+		return false;
+	}
+	return true;
+}
+
+bool FVoxelRegionFile::DecodeChunk(const TArray<uint8>& CompressedBytes, int32 LegacyUncompressedSize, FChunkData& OutChunkData) const
+{
+	if (Content != EVoxelRegionFileContent::Chunks)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Tried to read chunk data from %s, which doesn't hold chunks"), *FilePath)
+		return false;
+	}
+
+	if (Version >= 2)
+	{
+		return FVoxelChunkCodec::Decode(CompressedBytes, OutChunkData);
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(LegacyUncompressedSize);
+	if (!FCompression::UncompressMemory(NAME_Zlib, Bytes.GetData(), LegacyUncompressedSize, CompressedBytes.GetData(), CompressedBytes.Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not decompress chunk data"))
+		return false;
+	}
+	return DeserializeLegacyChunk(Bytes, OutChunkData);
+}
+
+bool FVoxelRegionFile::UpgradeFormat()
+{
+	/*Blobs of the former encoding can't be mixed with the new ones, so the whole file is rewritten at once*/
+	TArray<FChunkBlob> Blobs;
+	Blobs.Reserve(ChunkTable.Num());
+
+	//Only the layout of the file changes for blobs that are not chunk data
+	if (Content != EVoxelRegionFileContent::Chunks)
+	{
+		for (const auto& EntryPair : ChunkTable)
+		{
+			FChunkBlob& Blob = Blobs.AddDefaulted_GetRef();
+			Blob.LocalIndex = EntryPair.Key;
+			if (!ReadBlob(EntryPair.Value, Blob.CompressedBytes))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not upgrade region file %s"), *FilePath)
+				return false;
+			}
+		}
+		return ReplaceContent(Blobs);
+	}
+
+	TArray<uint8> CompressedBytes;
+	for (const auto& EntryPair : ChunkTable)
+	{
+		FChunkData ChunkData;
+		if (!ReadBlob(EntryPair.Value, CompressedBytes) || !DecodeChunk(CompressedBytes, EntryPair.Value.LegacyUncompressedSize, ChunkData))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not upgrade region file %s"), *FilePath)
+			return false;
+		}
+
+		FChunkBlob& Blob = Blobs.AddDefaulted_GetRef();
+		Blob.LocalIndex = EntryPair.Key;
+		if (!EncodeChunk(ChunkData, Blob))
+		{
+			return false;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Upgrading region file %s from version %d to version %d"), *FilePath, Version, FileVersion)
+	return ReplaceContent(Blobs);
+}
@@ -0,0 +1,82 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelRegionIORunnable.h"
+#include "Kismet/GameplayStatics.h"
+
+FVoxelRegionIORunnable::FVoxelRegionIORunnable()
+{
+	Thread = FRunnableThread::Create(this, TEXT("Voxel region I/O Thread"), 0, TPri_BelowNormal);
+}
+
+bool FVoxelRegionIORunnable::Init()
+{
+	return true;
+}
+
+uint32 FVoxelRegionIORunnable::Run()
+{
+	while (!bShutdown)
+	{
+		FVoxelRegionReadRequest CurrentRequest;
+		if (!RegionReadRequestsQueue.Dequeue(CurrentRequest))
+		{
+			//Nothing to do, let the other threads run instead of spinning
+			FPlatformProcess::Sleep(0.001f);
+			continue;
+		}
+
+		ReadRegion(CurrentRequest);
+		PendingReadsCount.Decrement();
+	}
+	return 0;
+}
+
+void FVoxelRegionIORunnable::Exit()
+{
+	/* Post-Run code, threaded */
+}
+
+void FVoxelRegionIORunnable::Stop()
+{
+	bShutdown = true;
+}
+
+void FVoxelRegionIORunnable::RequestRegionRead(const FVoxelRegionReadRequest& Request)
+{
+	PendingReadsCount.Increment();
+	RegionReadRequestsQueue.Enqueue(Request);
+}
+
+int32 FVoxelRegionIORunnable::GetPendingReadsCount() const
+{
+	return PendingReadsCount.GetValue();
+}
+
+void FVoxelRegionIORunnable::StartShutdown()
+{
+	RegionReadRequestsQueue.Empty();
+	bShutdown = true;
+}
+
+void FVoxelRegionIORunnable::ReadRegion(const FVoxelRegionReadRequest& Request)
+{
+	/*The region file is locked while it is read, a save of the same region on the game thread waits for the read to finish*/
+	FVoxelRegionReadResult Result;
+	Result.RegionLocation = Request.RegionLocation;
+	Result.RegionFile = Request.RegionFile;
+	Result.RegionData = MakeShared<TMap<FIntVector, FChunkData>>();
+
+	if (Request.RegionFile->Open(false))
+	{
+		Result.RegionFileRead = Request.RegionFile->ReadRegion(*Result.RegionData);
+		if (!Result.RegionFileRead)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not read region %d, %d, %d from its region file"), Request.RegionLocation.X, Request.RegionLocation.Y, Request.RegionLocation.Z)
+		}
+	}
+	else
+	{
+		Result.LegacySaveFound = UGameplayStatics::DoesSaveGameExist(Request.LegacySaveSlot, 0);
+	}
+
+	RegionReadResultsQueue.Enqueue(Result);
+}
@@ -0,0 +1,37 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelRegionSaveTask.h"
+#include "Kismet/GameplayStatics.h"
+
+void FVoxelRegionSaveTask::Run()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	Success = Chunks.Num() == 0 || WriteChunks();
+
+	//The mesh cache only saves meshing time, the save succeeds whether it could be written or not
+	if (Success && MeshCacheFile.IsValid() && ChunkMeshes.Num() > 0)
+	{
+		if (!MeshCacheFile->Open(true) || !MeshCacheFile->WriteEncodedChunks(ChunkMeshes))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not write the mesh cache of region %d, %d, %d"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+		}
+		ChunkMeshes.Empty();
+	}
+
+	WriteTime = FPlatformTime::Seconds() - StartTime;
+}
+
+bool FVoxelRegionSaveTask::WriteChunks()
+{
+	if (!RegionFile->Open(false))
+	{
+		//Creating the file of a region saved in the former format would lose the chunks that are not in the snapshot
+		LegacySaveFound = UGameplayStatics::DoesSaveGameExist(LegacySaveSlot, 0);
+		if (LegacySaveFound || !RegionFile->Open(true))
+		{
+			return false;
+		}
+	}
+
+	return RegionFile->WriteChunks(Chunks);
+}
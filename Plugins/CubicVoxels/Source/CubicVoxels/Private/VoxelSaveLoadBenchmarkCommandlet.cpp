@@ -0,0 +1,495 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelSaveLoadBenchmarkCommandlet.h"
+#include "VoxelWorld.h"
+#include "SerializationAndNetworking/RegionDataSaveGame.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "SerializationAndNetworking/VoxelWorldPack.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UVoxelSaveLoadBenchmarkCommandlet::UVoxelSaveLoadBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UVoxelSaveLoadBenchmarkCommandlet::Main(const FString& Params)
+{
+	/*Every format saves and reads back the same chunks the way the game does: region files through the save and load functions of a voxel world, the world pack one chunk per thread
+	 *The benchmark world has its own name, so that the saves of the real worlds are never touched
+	 */
+	int32 NumberOfRegions = 4;
+	int32 ChunksPerRegion = 256;
+	int32 EditsPerChunk = 64;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Regions="), NumberOfRegions);
+	FParse::Value(*Params, TEXT("ChunksPerRegion="), ChunksPerRegion);
+	FParse::Value(*Params, TEXT("EditsPerChunk="), EditsPerChunk);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	NumberOfRegions = FMath::Max(NumberOfRegions, 1);
+	EditsPerChunk = FMath::Max(EditsPerChunk, 0);
+
+	FString CsvPath;
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+	const bool MeasureSaveGame = FParse::Param(*Params, TEXT("SaveGame"));
+	const bool KeepFiles = FParse::Param(*Params, TEXT("Keep"));
+
+	UClass* WorldClass = AVoxelWorld::StaticClass();
+	FString WorldClassPath;
+	if (FParse::Value(*Params, TEXT("WorldClass="), WorldClassPath))
+	{
+		WorldClass = LoadClass<AVoxelWorld>(nullptr, *WorldClassPath);
+		if (!WorldClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load the voxel world class %s"), *WorldClassPath)
+			return 1;
+		}
+	}
+	const AVoxelWorld* DefaultWorld = WorldClass->GetDefaultObject<AVoxelWorld>();
+	const FString WorldName = TEXT("SaveLoadBenchmark");
+
+	FBenchmarkChunks SavedChunks;
+	double StartTime = FPlatformTime::Seconds();
+	GenerateChunks(SavedChunks, DefaultWorld->GetWorldGenerator(), NumberOfRegions, ChunksPerRegion, EditsPerChunk, Seed);
+	const double GenerationTime = FPlatformTime::Seconds() - StartTime;
+
+	const int32 NumberOfChunks = SavedChunks.Chunks.Num();
+	UE_LOG(LogTemp, Display, TEXT("Save/load benchmark: %d regions, %d chunks (%d of them only holding edits), %d edits per chunk, generated and edited in %f s on %d worker threads"), NumberOfRegions, NumberOfChunks, SavedChunks.AdditiveChunks, EditsPerChunk, GenerationTime, FTaskGraphInterface::Get().GetNumWorkerThreads())
+
+	TArray<FFormatResult> Results;
+	Results.Add(BenchmarkVoxelWorld(SavedChunks, WorldClass, WorldName));
+	Results.Add(BenchmarkWorldPack(SavedChunks, WorldName));
+	if (MeasureSaveGame)
+	{
+		Results.Add(BenchmarkSaveGame(SavedChunks, WorldName));
+	}
+
+	int32 Mismatches = 0;
+	for (const auto& Result : Results)
+	{
+		LogResult(Result, NumberOfChunks);
+		if (!CsvPath.IsEmpty())
+		{
+			AppendCsv(CsvPath, Result, NumberOfRegions, NumberOfChunks);
+		}
+		Mismatches += Result.Mismatches;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Save/load benchmark: peak resident memory of the process %f MB"), FPlatformMemory::GetStats().PeakUsedPhysical/(1024.0*1024.0))
+
+	if (!KeepFiles)
+	{
+		IFileManager::Get().DeleteDirectory(*FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VoxelWorlds"), WorldName), false, true);
+		UGameplayStatics::DeleteGameInSlot(WorldName + "\\WorldSaveData", 0);
+		for (const auto& RegionLocation : SavedChunks.Regions)
+		{
+			UGameplayStatics::DeleteGameInSlot(FString::Printf(TEXT("%s\\%d,%d,%d"), *WorldName, RegionLocation.X, RegionLocation.Y, RegionLocation.Z), 0);
+		}
+	}
+
+	if (Mismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Save/load benchmark: %d chunks were not read back as they were saved"), Mismatches)
+		return 1;
+	}
+	return 0;
+}
+
+void UVoxelSaveLoadBenchmarkCommandlet::GenerateChunks(FBenchmarkChunks& OutChunks, const FVoxelWorldGenerator& Generator, int32 NumberOfRegions, int32 ChunksPerRegion, int32 EditsPerChunk, int32 Seed)
+{
+	/*Regions alternate above and below the surface of the default terrain, so that the chunks are neither all air nor all stone
+	 *Edits are drawn from a random stream seeded by the chunk, the same parameters always give the same chunks whatever the number of threads
+	 */
+	constexpr int32 Layers = 8;
+	ChunksPerRegion = FMath::Clamp(ChunksPerRegion, 1, Layers*RegionSize*RegionSize);
+	const int32 AdditiveChunksPerRegion = FMath::Max(ChunksPerRegion/8, 1);
+
+	TArray<bool> IsAdditive;
+	for (int32 RegionIndex = 0; RegionIndex < NumberOfRegions; RegionIndex++)
+	{
+		const FIntVector RegionLocation = FIntVector(RegionIndex/2, 0, -(RegionIndex%2));
+		OutChunks.Regions.Add(RegionLocation);
+
+		const int32 FirstLayer = RegionLocation.Z < 0 ? RegionSize - Layers : 0;
+		for (int32 i = 0; i < ChunksPerRegion; i++)
+		{
+			const int32 Column = i/Layers;
+			OutChunks.ChunkLocations.Add(RegionSize*RegionLocation + FIntVector(Column%RegionSize, Column/RegionSize, FirstLayer + i%Layers));
+			OutChunks.RegionIndices.Add(RegionIndex);
+			IsAdditive.Add(false);
+		}
+
+		//Chunks that were edited without ever being generated, next to the generated ones
+		const int32 AdditiveLayer = RegionLocation.Z < 0 ? FirstLayer - 1 : Layers;
+		for (int32 i = 0; i < AdditiveChunksPerRegion; i++)
+		{
+			OutChunks.ChunkLocations.Add(RegionSize*RegionLocation + FIntVector(i%RegionSize, (i/RegionSize)%RegionSize, AdditiveLayer));
+			OutChunks.RegionIndices.Add(RegionIndex);
+			IsAdditive.Add(true);
+		}
+		OutChunks.AdditiveChunks += AdditiveChunksPerRegion;
+	}
+
+	const int32 NumberOfChunks = OutChunks.ChunkLocations.Num();
+	OutChunks.Chunks.SetNum(NumberOfChunks);
+
+	FVoxel PlacedVoxel;
+	PlacedVoxel.VoxelType = "Planks";
+	PlacedVoxel.IsTransparent = false;
+	PlacedVoxel.IsSolid = true;
+
+	ParallelFor(NumberOfChunks, [&OutChunks, &IsAdditive, &Generator, EditsPerChunk, Seed, PlacedVoxel](int32 i)
+	{
+		const FIntVector& ChunkLocation = OutChunks.ChunkLocations[i];
+		FRandomStream RandomStream(static_cast<int32>(HashCombine(static_cast<uint32>(Seed), GetTypeHash(ChunkLocation))));
+
+		TSharedPtr<FChunkData> ChunkDataPtr;
+		if (IsAdditive[i])
+		{
+			ChunkDataPtr = MakeShared<FChunkData>(FChunkData::SparseAdditiveChunkData());
+		}
+		else
+		{
+			ChunkDataPtr = MakeShared<FChunkData>();
+			Generator.GenerateChunk(ChunkLocation, *ChunkDataPtr);
+		}
+
+		//Half of the edits dig and the other half build, as a player would
+		for (int32 Edit = 0; Edit < EditsPerChunk; Edit++)
+		{
+			const FIntVector VoxelLocation(RandomStream.RandHelper(ChunkSize), RandomStream.RandHelper(ChunkSize), RandomStream.RandHelper(ChunkSize));
+			if (Edit%2 == 0 && !IsAdditive[i])
+			{
+				ChunkDataPtr->RemoveVoxel(VoxelLocation);
+			}
+			else
+			{
+				ChunkDataPtr->SetVoxel(VoxelLocation, PlacedVoxel);
+			}
+		}
+
+		OutChunks.Chunks[i] = ChunkDataPtr;
+	});
+}
+
+int32 UVoxelSaveLoadBenchmarkCommandlet::VerifyChunks(const FBenchmarkChunks& SavedChunks, const TMap<FIntVector, const FChunkData*>& ReadChunks)
+{
+	FThreadSafeCounter Mismatches;
+	ParallelFor(SavedChunks.ChunkLocations.Num(), [&SavedChunks, &ReadChunks, &Mismatches](int32 i)
+	{
+		const auto ReadChunk = ReadChunks.Find(SavedChunks.ChunkLocations[i]);
+		if (!ReadChunk || !*ReadChunk || !AreChunksEqual(*SavedChunks.Chunks[i], **ReadChunk))
+		{
+			Mismatches.Increment();
+		}
+	});
+	return Mismatches.GetValue();
+}
+
+bool UVoxelSaveLoadBenchmarkCommandlet::AreChunksEqual(const FChunkData& SavedChunk, const FChunkData& ReadChunk)
+{
+	/*Chunks may be read back in another layout than the one they were saved in, so every voxel is compared through GetVoxelAt, along with the properties the == operator of FVoxel ignores*/
+	if (SavedChunk.IsAdditive != ReadChunk.IsAdditive)
+	{
+		return false;
+	}
+
+	for (int32 x = 0; x < ChunkSize; x++)
+	{
+		for (int32 y = 0; y < ChunkSize; y++)
+		{
+			for (int32 z = 0; z < ChunkSize; z++)
+			{
+				const FVoxel SavedVoxel = SavedChunk.GetVoxelAt(x, y, z);
+				const FVoxel ReadVoxel = ReadChunk.GetVoxelAt(x, y, z);
+				if (SavedVoxel.VoxelType != ReadVoxel.VoxelType || SavedVoxel.IsTransparent != ReadVoxel.IsTransparent || SavedVoxel.IsSolid != ReadVoxel.IsSolid)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+UVoxelSaveLoadBenchmarkCommandlet::FFormatResult UVoxelSaveLoadBenchmarkCommandlet::BenchmarkVoxelWorld(const FBenchmarkChunks& SavedChunks, UClass* WorldClass, const FString& WorldName)
+{
+	/*The chunks are saved and read back by a voxel world spawned in a world that never begins play, through the same functions as in game
+	 *They are handed to it as the saved data of unloaded chunks, which is not timed, then SaveVoxelWorld writes them one region per worker thread
+	 *Once its regions are released from memory, every chunk is read back from its region file by FindChunkSavedData on the game thread
+	 */
+	FFormatResult Result;
+	Result.Format = TEXT("RegionFile");
+
+	for (const auto& RegionLocation : SavedChunks.Regions)
+	{
+		IFileManager::Get().Delete(*FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation), false, false, true);
+	}
+	UGameplayStatics::DeleteGameInSlot(WorldName + "\\WorldSaveData", 0);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SaveLoadBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	AVoxelWorld* VoxelWorld = World->SpawnActor<AVoxelWorld>(WorldClass);
+	if (!VoxelWorld)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Save/load benchmark: could not spawn the voxel world"))
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		return Result;
+	}
+	VoxelWorld->WorldName = WorldName;
+	VoxelWorld->LoadWorldSavedInfo();
+
+	for (int32 i = 0; i < SavedChunks.ChunkLocations.Num(); i++)
+	{
+		VoxelWorld->SetChunkSavedData(SavedChunks.ChunkLocations[i], *SavedChunks.Chunks[i]);
+	}
+
+	uint64 MemoryBefore = GetUsedMemory();
+	double StartTime = FPlatformTime::Seconds();
+	VoxelWorld->SaveVoxelWorld();
+	VoxelWorld->FlushPendingSaves();
+	Result.WriteTime = FPlatformTime::Seconds() - StartTime;
+	Result.WriteMemory = GetMemoryGrowth(MemoryBefore);
+
+	for (const auto& RegionLocation : SavedChunks.Regions)
+	{
+		Result.Bytes += FMath::Max<int64>(IFileManager::Get().FileSize(*FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation)), 0);
+	}
+
+	VoxelWorld->ReleaseSavedRegions();
+
+	MemoryBefore = GetUsedMemory();
+	StartTime = FPlatformTime::Seconds();
+	for (const auto& ChunkLocation : SavedChunks.ChunkLocations)
+	{
+		VoxelWorld->FindChunkSavedData(ChunkLocation);
+	}
+	Result.ReadTime = FPlatformTime::Seconds() - StartTime;
+	Result.ReadMemory = GetMemoryGrowth(MemoryBefore);
+
+	//The saved data of a region grows as its chunks are read, which moves the chunks read before, so they are copied once they are all read
+	TMap<FIntVector, TSharedPtr<FChunkData>> ChunksRead;
+	for (const auto& ChunkLocation : SavedChunks.ChunkLocations)
+	{
+		if (const FChunkData* ChunkSavedData = VoxelWorld->FindChunkSavedData(ChunkLocation))
+		{
+			ChunksRead.Add(ChunkLocation, MakeShared<FChunkData>(*ChunkSavedData));
+		}
+	}
+
+	TMap<FIntVector, const FChunkData*> ReadChunks;
+	for (const auto& ChunkPair : ChunksRead)
+	{
+		ReadChunks.Add(ChunkPair.Key, ChunkPair.Value.Get());
+	}
+	Result.ChunksRead = ReadChunks.Num();
+	Result.Mismatches = VerifyChunks(SavedChunks, ReadChunks);
+
+	VoxelWorld->Destroy();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return Result;
+}
+
+UVoxelSaveLoadBenchmarkCommandlet::FFormatResult UVoxelSaveLoadBenchmarkCommandlet::BenchmarkWorldPack(const FBenchmarkChunks& SavedChunks, const FString& WorldName)
+{
+	/*Chunks are encoded in parallel and appended region by region, then read back from the mapping one chunk per thread*/
+	FFormatResult Result;
+	Result.Format = TEXT("WorldPack");
+
+	const FString PackFilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VoxelWorlds"), WorldName, TEXT("Benchmark.cvp"));
+	const int32 NumberOfChunks = SavedChunks.Chunks.Num();
+
+	uint64 MemoryBefore = GetUsedMemory();
+	double StartTime = FPlatformTime::Seconds();
+	{
+		TArray<TArray<uint8>> EncodedChunks;
+		EncodedChunks.SetNum(NumberOfChunks);
+		ParallelFor(NumberOfChunks, [&SavedChunks, &EncodedChunks](int32 i)
+		{
+			FVoxelChunkCodec::Encode(*SavedChunks.Chunks[i], EncodedChunks[i], FVoxelRegionFile::BlobCompression);
+		});
+
+		TArray<TMap<FIntVector, TArray<uint8>>> EncodedRegions;
+		EncodedRegions.SetNum(SavedChunks.Regions.Num());
+		for (int32 i = 0; i < NumberOfChunks; i++)
+		{
+			const int32 RegionIndex = SavedChunks.RegionIndices[i];
+			EncodedRegions[RegionIndex].Add(SavedChunks.ChunkLocations[i], MoveTemp(EncodedChunks[i]));
+		}
+
+		FVoxelWorldPackWriter PackWriter;
+		bool Success = PackWriter.Open(PackFilePath);
+		for (int32 RegionIndex = 0; RegionIndex < SavedChunks.Regions.Num() && Success; RegionIndex++)
+		{
+			Success = PackWriter.AddRegion(SavedChunks.Regions[RegionIndex], EncodedRegions[RegionIndex]);
+		}
+		if (!Success || !PackWriter.Finish())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Save/load benchmark: could not write the world pack %s"), *PackFilePath)
+		}
+		Result.WriteMemory = GetMemoryGrowth(MemoryBefore);
+	}
+	Result.WriteTime = FPlatformTime::Seconds() - StartTime;
+	Result.Bytes = IFileManager::Get().FileSize(*PackFilePath);
+
+	FVoxelWorldPack WorldPack;
+	StartTime = FPlatformTime::Seconds();
+	WorldPack.Open(PackFilePath);
+	Result.OpenTime = FPlatformTime::Seconds() - StartTime;
+
+	TArray<TSharedPtr<FChunkData>> ChunksRead;
+	ChunksRead.SetNum(NumberOfChunks);
+
+	MemoryBefore = GetUsedMemory();
+	StartTime = FPlatformTime::Seconds();
+	ParallelFor(NumberOfChunks, [&SavedChunks, &ChunksRead, &WorldPack](int32 i)
+	{
+		auto ChunkDataPtr = MakeShared<FChunkData>();
+		if (WorldPack.ReadChunk(SavedChunks.ChunkLocations[i], *ChunkDataPtr))
+		{
+			ChunksRead[i] = ChunkDataPtr;
+		}
+	});
+	Result.ReadTime = FPlatformTime::Seconds() - StartTime;
+	Result.ReadMemory = GetMemoryGrowth(MemoryBefore);
+
+	TMap<FIntVector, const FChunkData*> ReadChunks;
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		if (ChunksRead[i].IsValid())
+		{
+			ReadChunks.Add(SavedChunks.ChunkLocations[i], ChunksRead[i].Get());
+		}
+	}
+	WorldPack.Close();
+
+	Result.ChunksRead = ReadChunks.Num();
+	Result.Mismatches = VerifyChunks(SavedChunks, ReadChunks);
+	return Result;
+}
+
+UVoxelSaveLoadBenchmarkCommandlet::FFormatResult UVoxelSaveLoadBenchmarkCommandlet::BenchmarkSaveGame(const FBenchmarkChunks& SavedChunks, const FString& WorldName)
+{
+	/*Save games are UObjects, so regions are serialized one after the other on the game thread. The copy of the chunks into the save objects is not timed*/
+	FFormatResult Result;
+	Result.Format = TEXT("SaveGame");
+
+	TArray<URegionDataSaveGame*> SaveObjects;
+	TArray<FString> SaveSlots;
+	for (const auto& RegionLocation : SavedChunks.Regions)
+	{
+		SaveObjects.Add(Cast<URegionDataSaveGame>(UGameplayStatics::CreateSaveGameObject(URegionDataSaveGame::StaticClass())));
+		SaveSlots.Add(FString::Printf(TEXT("%s\\%d,%d,%d"), *WorldName, RegionLocation.X, RegionLocation.Y, RegionLocation.Z));
+	}
+	for (int32 i = 0; i < SavedChunks.ChunkLocations.Num(); i++)
+	{
+		const int32 RegionIndex = SavedChunks.RegionIndices[i];
+		SaveObjects[RegionIndex]->RegionData.Add(SavedChunks.ChunkLocations[i], *SavedChunks.Chunks[i]);
+	}
+
+	uint64 MemoryBefore = GetUsedMemory();
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 RegionIndex = 0; RegionIndex < SaveObjects.Num(); RegionIndex++)
+	{
+		TArray<uint8> SaveBytes;
+		if (!UGameplayStatics::SaveGameToMemory(SaveObjects[RegionIndex], SaveBytes) || !UGameplayStatics::SaveDataToSlot(SaveBytes, SaveSlots[RegionIndex], 0))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Save/load benchmark: could not save slot %s"), *SaveSlots[RegionIndex])
+		}
+		Result.Bytes += SaveBytes.Num();
+	}
+	Result.WriteTime = FPlatformTime::Seconds() - StartTime;
+	Result.WriteMemory = GetMemoryGrowth(MemoryBefore);
+
+	for (auto& SaveObject : SaveObjects)
+	{
+		SaveObject->RegionData.Empty();
+	}
+
+	TMap<FIntVector, TSharedPtr<FChunkData>> ChunksRead;
+	MemoryBefore = GetUsedMemory();
+	StartTime = FPlatformTime::Seconds();
+	for (const auto& SaveSlot : SaveSlots)
+	{
+		TArray<uint8> SaveBytes;
+		const auto LoadedSaveObject = UGameplayStatics::LoadDataFromSlot(SaveSlot, 0, SaveBytes) ? Cast<URegionDataSaveGame>(UGameplayStatics::LoadGameFromMemory(SaveBytes)) : nullptr;
+		if (LoadedSaveObject)
+		{
+			for (auto& ChunkPair : LoadedSaveObject->RegionData)
+			{
+				ChunksRead.Add(ChunkPair.Key, MakeShared<FChunkData>(MoveTemp(ChunkPair.Value)));
+			}
+		}
+	}
+	Result.ReadTime = FPlatformTime::Seconds() - StartTime;
+	Result.ReadMemory = GetMemoryGrowth(MemoryBefore);
+
+	TMap<FIntVector, const FChunkData*> ReadChunks;
+	for (const auto& ChunkPair : ChunksRead)
+	{
+		ReadChunks.Add(ChunkPair.Key, ChunkPair.Value.Get());
+	}
+
+	Result.ChunksRead = ReadChunks.Num();
+	Result.Mismatches = VerifyChunks(SavedChunks, ReadChunks);
+	return Result;
+}
+
+void UVoxelSaveLoadBenchmarkCommandlet::LogResult(const FFormatResult& Result, int32 NumberOfChunks)
+{
+	const double Megabytes = Result.Bytes/(1024.0*1024.0);
+	const double WriteTime = FMath::Max(Result.WriteTime, 1e-9);
+	const double ReadTime = FMath::Max(Result.ReadTime + Result.OpenTime, 1e-9);
+	UE_LOG(LogTemp, Display, TEXT("%s: %f MB on disk, %f bytes per chunk"), *Result.Format, Megabytes, static_cast<double>(Result.Bytes)/FMath::Max(NumberOfChunks, 1))
+	UE_LOG(LogTemp, Display, TEXT("%s save: %f s, %f MB/s, %f chunks/s, resident memory grew by %f MB"), *Result.Format, Result.WriteTime, Megabytes/WriteTime, NumberOfChunks/WriteTime, Result.WriteMemory/(1024.0*1024.0))
+	UE_LOG(LogTemp, Display, TEXT("%s load: open %f ms, read %f s, %f MB/s, %f chunks/s, resident memory grew by %f MB"), *Result.Format, 1000*Result.OpenTime, Result.ReadTime, Megabytes/ReadTime, Result.ChunksRead/ReadTime, Result.ReadMemory/(1024.0*1024.0))
+	UE_LOG(LogTemp, Display, TEXT("%s verification: %d of %d chunks read back, %d mismatches"), *Result.Format, Result.ChunksRead, NumberOfChunks, Result.Mismatches)
+}
+
+void UVoxelSaveLoadBenchmarkCommandlet::AppendCsv(const FString& CsvPath, const FFormatResult& Result, int32 NumberOfRegions, int32 NumberOfChunks)
+{
+	/*One line per format and run, the header is written when the file is created*/
+	FString Lines;
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		Lines += TEXT("Date,Format,Regions,Chunks,Bytes,SaveSeconds,OpenSeconds,LoadSeconds,SaveMBPerSecond,LoadMBPerSecond,SaveChunksPerSecond,LoadChunksPerSecond,SaveMemoryMB,LoadMemoryMB,PeakMemoryMB,Mismatches\n");
+	}
+
+	const double Megabytes = Result.Bytes/(1024.0*1024.0);
+	const double WriteTime = FMath::Max(Result.WriteTime, 1e-9);
+	const double ReadTime = FMath::Max(Result.ReadTime + Result.OpenTime, 1e-9);
+	Lines += FString::Printf(TEXT("%s,%s,%d,%d,%lld,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d\n"), *FDateTime::UtcNow().ToIso8601(), *Result.Format, NumberOfRegions, NumberOfChunks, Result.Bytes,
+		Result.WriteTime, Result.OpenTime, Result.ReadTime, Megabytes/WriteTime, Megabytes/ReadTime, NumberOfChunks/WriteTime, Result.ChunksRead/ReadTime,
+		Result.WriteMemory/(1024.0*1024.0), Result.ReadMemory/(1024.0*1024.0), FPlatformMemory::GetStats().PeakUsedPhysical/(1024.0*1024.0), Result.Mismatches);
+
+	if (!FFileHelper::SaveStringToFile(Lines, *CsvPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not append the results to %s"), *CsvPath)
+	}
+}
+
+uint64 UVoxelSaveLoadBenchmarkCommandlet::GetUsedMemory()
+{
+	return FPlatformMemory::GetStats().UsedPhysical;
+}
+
+uint64 UVoxelSaveLoadBenchmarkCommandlet::GetMemoryGrowth(uint64 UsedMemoryBefore)
+{
+	const uint64 UsedMemory = GetUsedMemory();
+	return UsedMemory > UsedMemoryBefore ? UsedMemory - UsedMemoryBefore : 0;
+}
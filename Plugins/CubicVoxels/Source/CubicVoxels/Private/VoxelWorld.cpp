@@ -8,6 +8,8 @@
 #include "Chunk.h"
 #include "SerializationAndNetworking/VoxelWorldGlobalDataSaveGame.h"
 #include "SerializationAndNetworking/RegionDataSaveGame.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/Async.h"
 
 
 void AVoxelWorld::TestingFunction(APlayerController* PlayerController)
@@ -33,38 +35,51 @@ AVoxelWorld::AVoxelWorld()
 	
 	ViewDistance = 24;
 	VerticalViewDistance = 5;
-	
-	ViewLayers = TArray<TSet<FIntVector>>();
-	ViewLayers.SetNum(ViewDistance + 1);
 
-	//Initialize the list that gives the order in which chunks should be iterated
-	auto FirstViewLayer = TSet<FIntVector>();
-	FirstViewLayer.Add(FIntVector(0,0,0));
-	ViewLayers[0] = FirstViewLayer;
-	
-	for (int32 i = 0; i < ViewDistance; i++)
-	{
-		for (auto& LayerElement : ViewLayers[i])
-		{
-			for (auto& Offset : {FIntVector(1,0,0), FIntVector(-1,0,0), FIntVector(0,1,0), FIntVector(0,-1,0), FIntVector(0,0,1), FIntVector(0,0,-1)})
-			{
-				if ( abs((LayerElement + Offset).Z) < VerticalViewDistance &&  OneNorm(LayerElement + Offset) > OneNorm(LayerElement) ) //To ponder...
-				{
-					ViewLayers[i+1].Add(LayerElement + Offset);
-				}
-			}
-		}
-	}
+	UnloadingHysteresis = 2;
+	MaxChunkUnloadsPerTick = 64;
+
+	PrefetchLookaheadTime = 1.5f;
+	ViewDirectionPriorityWeight = 1.0f;
+
+	AutomaticViewDistance = false;
+	TargetFrameTimeMs = 16.6f;
+	ViewDistanceDecreaseThreshold = 1.15f;
+	ViewDistanceIncreaseThreshold = 0.8f;
+	ViewDistanceChangeInterval = 2.f;
+	FrameTimeSmoothingFactor = 0.05f;
+	MinimumViewDistance = 8;
+	MaximumViewDistance = 32;
+	SmoothedFrameTimeMs = 0;
+	TimeSinceLastViewDistanceChange = 0;
+
+	ClipmapHorizontalExtent = 0;
+	ClipmapVerticalExtent = 0;
+
+	NextLoadingTicketId = 0;
+
+	NumberOfServerGenerationThreads = 0;
+
+	RegionCacheBudgetMB = 256;
+
+	UseMeshCache = true;
+
+	UnloadedChunkCacheBudgetMB = 64;
+
+	ColumnCacheBudgetMB = 16;
+
+	JournalFlushInterval = 0.25f;
+	JournalCompactionThresholdKB = 1024;
 	
 	RootComponent = CreateDefaultSubobject<USceneComponent>("Voxel world root");
 	SetRootComponent(RootComponent);
-	
-	ChunkStates = TMap<FIntVector, EChunkState>();
-	ChunkActorsMap = TMap<FIntVector, TObjectPtr<AChunk>>();
-	NumbersOfPlayerOutsideRangeOfChunkMap = TMap<FIntVector, uint32>();
 
 	WorldGenerationFunction = &DefaultGenerateBlockAt;
 
+	WorldGenerator.VoxelFunction = &DefaultGenerateBlockAt;
+	WorldGenerator.ColumnFunction = &DefaultSurfaceHeight;
+	WorldGenerator.VoxelInColumnFunction = &DefaultGenerateBlockInColumn;
+
 	SetActorScale3D(FVector(1,1,1));
 	
 	WorldName = "MyWorld";
@@ -75,28 +90,139 @@ AVoxelWorld::AVoxelWorld()
 
 void AVoxelWorld::IterateChunkCreationNearPlayers( )
 {
-	/*Register all chunks in loading distance for loading for each managed player*/
-	for (int32 i = 0; i < ViewDistance; i++)
+	/*Register for loading the chunks entering the loading distance of each managed player
+	 *Nothing is done for a player that stays in the same chunk, so the cost of a tick doesn't depend on the view distance
+	 */
+	TArray<FIntVector> EnteringChunks;
+	
+	for (auto& CurrentPlayerThreadPair : ManagedPlayerDataMap)
 	{
-		for (const auto CurrentPlayerThreadPair : ManagedPlayerDataMap)
+		if (IsValid(CurrentPlayerThreadPair.Key) && CurrentPlayerThreadPair.Key->GetPawn())
 		{
-			if (IsValid(CurrentPlayerThreadPair.Key))
+			const auto LoadingOrigin = GetPlayerLoadingOrigin(CurrentPlayerThreadPair.Key);
+			auto& PlayerData = CurrentPlayerThreadPair.Value;
+
+			//Both the chunk references and the chunk creation are only updated when the player crosses a chunk boundary
+			if (!PlayerData.HasLoadingOrigin || PlayerData.LastLoadingOrigin != LoadingOrigin)
 			{
-				//Updating the generating thread's value for the position of the player
-				FVector PlayerPosition = CurrentPlayerThreadPair.Key->GetPawn()->GetActorLocation();
-				const auto LoadingOrigin = FloorVector(this->GetActorRotation().GetInverse().RotateVector((PlayerPosition - this->GetActorLocation())/(ChunkSize*DefaultVoxelSize*this->GetActorScale().X)));
+				UpdateChunkReferences(PlayerData, LoadingOrigin);
+			}
 
-				//Logic for generating the chunks in proximity to the player
-				for (auto& Chunk : ViewLayers[i])
+			if (!PlayerData.HasLoadingOrigin)
+			{
+				//First tick of the player, every chunk in view is entering
+				for (const auto& ViewLayer : PlayerData.ViewShells->GetViewLayers())
+				{
+					for (const auto& Chunk : ViewLayer)
+					{
+						CreateChunkAt(Chunk + LoadingOrigin);
+					}
+				}
+			}
+			else if (PlayerData.LastLoadingOrigin != LoadingOrigin)
+			{
+				EnteringChunks.Reset();
+				PlayerData.ViewShells->GetEnteringChunks(PlayerData.LastLoadingOrigin, LoadingOrigin, EnteringChunks);
+				for (const auto& Chunk : EnteringChunks)
 				{
-					CreateChunkAt(Chunk + LoadingOrigin, CurrentPlayerThreadPair.Value.ChunkGenerationOrdersQueuePtr);
+					CreateChunkAt(Chunk);
 				}
 			}
+
+			PlayerData.LastLoadingOrigin = LoadingOrigin;
+			PlayerData.HasLoadingOrigin = true;
 		}
 	}
 	
 }
 
+void AVoxelWorld::IterateChunkCreationNearTickets()
+{
+	/*Same as for the players, the chunks of a ticket are only updated when its anchor crosses a chunk boundary*/
+	TArray<FIntVector> ChangedChunks;
+
+	for (auto& TicketPair : LoadingTickets)
+	{
+		auto& Ticket = TicketPair.Value;
+
+		if (Ticket.AnchorActor.IsValid())
+		{
+			Ticket.AnchorLocation = Ticket.AnchorActor->GetActorLocation();
+		}
+		const auto LoadingOrigin = GetLoadingOriginOfLocation(Ticket.AnchorLocation);
+
+		if (!Ticket.HasLoadingOrigin)
+		{
+			for (const auto& ViewLayer : Ticket.Shells->GetViewLayers())
+			{
+				for (const auto& Chunk : ViewLayer)
+				{
+					AddChunkReference(Chunk + LoadingOrigin);
+					CreateChunkAt(Chunk + LoadingOrigin, Ticket.Level);
+				}
+			}
+		}
+		else if (Ticket.LastLoadingOrigin != LoadingOrigin)
+		{
+			ChangedChunks.Reset();
+			Ticket.Shells->GetEnteringChunks(Ticket.LastLoadingOrigin, LoadingOrigin, ChangedChunks);
+			for (const auto& Chunk : ChangedChunks)
+			{
+				AddChunkReference(Chunk);
+				CreateChunkAt(Chunk, Ticket.Level);
+			}
+
+			ChangedChunks.Reset();
+			Ticket.Shells->GetLeavingChunks(Ticket.LastLoadingOrigin, LoadingOrigin, ChangedChunks);
+			for (const auto& Chunk : ChangedChunks)
+			{
+				RemoveChunkReference(Chunk);
+			}
+		}
+
+		Ticket.LastLoadingOrigin = LoadingOrigin;
+		Ticket.HasLoadingOrigin = true;
+	}
+}
+
+int32 AVoxelWorld::AddChunkLoadingTicket(AActor* AnchorActor, FVector AnchorLocation, int32 Radius, float Priority, EChunkLoadingLevel Level)
+{
+	/*The chunks of the ticket are requested on the next tick*/
+	FChunkLoadingTicket NewTicket;
+	NewTicket.AnchorActor = AnchorActor;
+	NewTicket.AnchorLocation = IsValid(AnchorActor) ? AnchorActor->GetActorLocation() : AnchorLocation;
+	NewTicket.Radius = FMath::Max(0, Radius);
+	NewTicket.Priority = Priority;
+	NewTicket.Level = Level;
+	NewTicket.Shells = GetViewShells(NewTicket.Radius, NewTicket.Radius + 1);
+
+	const int32 TicketId = NextLoadingTicketId++;
+	LoadingTickets.Add(TicketId, NewTicket);
+	return TicketId;
+}
+
+void AVoxelWorld::RemoveChunkLoadingTicket(int32 TicketId)
+{
+	/*Release every chunk of the ticket, those that nobody else references go through the unloading budget*/
+	FChunkLoadingTicket RemovedTicket;
+	if (!LoadingTickets.RemoveAndCopyValue(TicketId, RemovedTicket))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Tried to remove a chunk loading ticket that does not exist"))
+		return;
+	}
+
+	if (RemovedTicket.HasLoadingOrigin)
+	{
+		for (const auto& ViewLayer : RemovedTicket.Shells->GetViewLayers())
+		{
+			for (const auto& Chunk : ViewLayer)
+			{
+				RemoveChunkReference(Chunk + RemovedTicket.LastLoadingOrigin);
+			}
+		}
+	}
+}
+
 void AVoxelWorld::IterateGeneratedChunkLoadingAndSidesGeneration()
 {
 	
@@ -104,19 +230,54 @@ void AVoxelWorld::IterateGeneratedChunkLoadingAndSidesGeneration()
 	{
 		TTuple<FIntVector, TSharedPtr<FChunkData>> DataToLoad;
 		GeneratedChunksToLoadInGame.Dequeue(DataToLoad);
-		GeneratedChunksToLoadByDistanceToNearestPlayer.Add(DataToLoad);
+		GeneratedChunksToLoadByPriority.Add(MakeTuple(0.f, DataToLoad));
+	}
+
+	//Compute the priority of each chunk once, with the anchors of this tick
+	for (auto& PrioritizedData : GeneratedChunksToLoadByPriority)
+	{
+		PrioritizedData.Get<0>() = FChunkLoadingPriority::GetPriority(LoadingAnchors, PrioritizedData.Get<1>().Key);
 	}
 	
-	GeneratedChunksToLoadByDistanceToNearestPlayer.Sort([this](const TTuple<FIntVector, TSharedPtr<FChunkData>>& A,const TTuple<FIntVector, TSharedPtr<FChunkData>>& B) {
-		return DistanceToNearestPlayer(A.Key) < DistanceToNearestPlayer(B.Key); // sort the pre-cooked chunks by distance to player
+	GeneratedChunksToLoadByPriority.Sort([](const TTuple<float, TTuple<FIntVector, TSharedPtr<FChunkData>>>& A, const TTuple<float, TTuple<FIntVector, TSharedPtr<FChunkData>>>& B) {
+		return A.Get<0>() < B.Get<0>(); // sort the pre-cooked chunks by priority for the players
 	});
 	
 
 	
-	//Load the chunks which have been pre-cooked asynchronously, in the order of distance to the player
-	for (int32 Index = 0; Index < GeneratedChunksToLoadByDistanceToNearestPlayer.Num(); Index++)
+	//Load the chunks which have been pre-cooked asynchronously, in the order of priority
+	for (int32 Index = 0; Index < GeneratedChunksToLoadByPriority.Num(); Index++)
 	{
-		const TTuple<FIntVector, TSharedPtr<FChunkData>> DataToLoad = GeneratedChunksToLoadByDistanceToNearestPlayer[Index];
+		const TTuple<FIntVector, TSharedPtr<FChunkData>> DataToLoad = GeneratedChunksToLoadByPriority[Index].Get<1>();
+
+		//Drop the chunks that left every player's view while they were being generated
+		const auto ChunkState = ChunkStates.Find(DataToLoad.Key);
+		if (!ChunkState || *ChunkState != EChunkState::Loading)
+		{
+			if (ChunkState && *ChunkState == EChunkState::Unloading)
+			{
+				ChunkStates.Remove(DataToLoad.Key);
+				ChunkPipeline.OnChunkRemoved(DataToLoad.Key);
+				DataOnlyOrdersInFlight.Remove(DataToLoad.Key);
+			}
+			continue;
+		}
+
+		//Data-only chunks are kept without an actor, unless a mesh was requested while their data was generated
+		if (const auto MeshRequested = DataOnlyOrdersInFlight.Find(DataToLoad.Key))
+		{
+			if (*MeshRequested)
+			{
+				RequestChunkMeshing(DataToLoad.Key, DataToLoad.Value);
+			}
+			else
+			{
+				DataOnlyChunks.Add(DataToLoad.Key, DataToLoad.Value);
+				ChunkStates.Add(DataToLoad.Key, EChunkState::Loaded);
+			}
+			DataOnlyOrdersInFlight.Remove(DataToLoad.Key);
+			continue;
+		}
 		
 		//Spawn the chunk actor
 		const TObjectPtr<AChunk> RecentlyGeneratedChunk = GetWorld()->SpawnActor<AChunk>();
@@ -130,80 +291,39 @@ void AVoxelWorld::IterateGeneratedChunkLoadingAndSidesGeneration()
 		RecentlyGeneratedChunk->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform);
 		
 		ChunkStates.Add(DataToLoad.Key, EChunkState::Loaded);
-		ChunkActorsMap.Add(MakeTuple(DataToLoad.Key, RecentlyGeneratedChunk));
+		ChunkActorsMap.Add(DataToLoad.Key, RecentlyGeneratedChunk);
+
+		//The neighbour handles are the only map lookups a chunk's neighbours cost, every later cross-chunk access goes through them
+		for (int32 i = 0; i < 6; i++)
+		{
+			if (const auto NeighbourActor = ChunkActorsMap.Find(DataToLoad.Key + FChunkPipeline::Directions[i]))
+			{
+				RecentlyGeneratedChunk->LinkNeighbour(i, *NeighbourActor);
+			}
+		}
 
 		//Replicate the chunk
 		//TODO: Write code that serializes the chunk's geometry data and finds all players close enough to this chunk to stream it to them
 
-		//If any neighbouring chunk is loaded, compute asynchronously the chunk's corresponding side mesh data
-		const FIntVector Directions[6] = {
-			FIntVector(1,0,0),
-			FIntVector(0,1,0),
-			FIntVector(-1,0,0),
-			FIntVector(0,-1,0),
-			FIntVector(0,0,1),
-			FIntVector(0,0,-1)							
-		};
-
-		const int32 OppositeDirections[6] = {
-			2,
-			3,
-			0,
-			1,
-			5,
-			4							
-		};
-			
-		//logic to start the generation of chunk sides if possible
-		for (int32 i = 0; i<6; i++)
+		ChunkPipeline.OnChunkGenerated(DataToLoad.Key);
+
+		//Start the meshing of the sides shared with every neighbour that is generated too, each side is only claimed once
+		for (const int32 i : ChunkPipeline.ClaimReadySideMeshings(DataToLoad.Key))
 		{
-			const auto StatePtr = ChunkStates.Find(DataToLoad.Key + Directions[i]);
-			if (StatePtr && *StatePtr == EChunkState::Loaded)
+			const auto NeighbourLocation = DataToLoad.Key + FChunkPipeline::Directions[i];
+			const auto NeighbourActor = RecentlyGeneratedChunk->Neighbours[i];
+			if (!IsValid(NeighbourActor))
 			{
-				const auto ActorPtr = ChunkActorsMap.Find(DataToLoad.Key + Directions[i]);
-				TSharedPtr<FChunkData> NeighborChunkDataPtr;
-				
-				if ( ActorPtr && IsValid(*ActorPtr))
-				{
-					NeighborChunkDataPtr = (*ActorPtr)->BlocksDataPtr;
-				}
-				else
-				{
-					NeighborChunkDataPtr = nullptr;
-					UE_LOG(LogTemp, Error, TEXT("Some chunk was marked as loaded but had no corresponding actor"))
-				}
-					
-				const auto NearestPlayer = NearestPlayerToChunk(DataToLoad.Key);
-				if (const auto NearestPlayerData = ManagedPlayerDataMap.Find(NearestPlayer))
-				{
-	
-					const auto PlayerWorkOrdersQueuePtr = NearestPlayerData->ChunkSidesMeshingOrdersQueuePtr;
-							
-					auto ChunkSidesGenerationOrder_1 = FChunkThreadedWorkOrderBase();
-					ChunkSidesGenerationOrder_1.ChunkLocation = DataToLoad.Key;
-					ChunkSidesGenerationOrder_1.DirectionIndex = i;
-					ChunkSidesGenerationOrder_1.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
-					ChunkSidesGenerationOrder_1.TargetChunkDataPtr = (RecentlyGeneratedChunk->BlocksDataPtr);
-					ChunkSidesGenerationOrder_1.NeighboringChunkDataPtr = NeighborChunkDataPtr;
-					ChunkSidesGenerationOrder_1.OrderType = EChunkThreadedWorkOrderType::GeneratingExistingChunksSides;
-					PlayerWorkOrdersQueuePtr->Enqueue(ChunkSidesGenerationOrder_1);
-
-					auto ChunkSidesGenerationOrder_2 = FChunkThreadedWorkOrderBase();
-					ChunkSidesGenerationOrder_2.ChunkLocation = DataToLoad.Key + Directions[i];
-					ChunkSidesGenerationOrder_2.DirectionIndex = OppositeDirections[i];
-					ChunkSidesGenerationOrder_2.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
-					ChunkSidesGenerationOrder_2.TargetChunkDataPtr = NeighborChunkDataPtr;
-					ChunkSidesGenerationOrder_2.NeighboringChunkDataPtr = (RecentlyGeneratedChunk->BlocksDataPtr);
-					ChunkSidesGenerationOrder_2.OrderType = EChunkThreadedWorkOrderType::GeneratingExistingChunksSides;
-					PlayerWorkOrdersQueuePtr->Enqueue(ChunkSidesGenerationOrder_2);
-				}
-						
-					
+				UE_LOG(LogTemp, Error, TEXT("Some chunk was marked as generated but had no corresponding actor"))
+				continue;
 			}
-				
+			const TSharedPtr<FChunkData> NeighborChunkDataPtr = NeighbourActor->BlocksDataPtr;
+
+			RequestSideMeshing(DataToLoad.Key, i, RecentlyGeneratedChunk->BlocksDataPtr, NeighborChunkDataPtr);
+			RequestSideMeshing(NeighbourLocation, FChunkPipeline::OppositeDirections[i], NeighborChunkDataPtr, RecentlyGeneratedChunk->BlocksDataPtr);
 		}
 	}
-	GeneratedChunksToLoadByDistanceToNearestPlayer.Empty();
+	GeneratedChunksToLoadByPriority.Empty();
 }
 
 void AVoxelWorld::IterateChunkMeshing()
@@ -224,14 +344,16 @@ void AVoxelWorld::IterateChunkMeshing()
 				if (ChunkActor && IsValid(*ChunkActor))
 				{
 					(*ChunkActor)->AddQuads(DataToLoad->Geometry);
-					(*ChunkActor)->RenderChunk(DefaultVoxelSize);
 					if (DataToLoad->DirectionIndex >= 0 && DataToLoad->DirectionIndex < 6)
 					{
 						(*ChunkActor)->IsSideGeometryLoaded[DataToLoad->DirectionIndex] = true;
+						ChunkPipeline.OnSideGeometryReceived(DataToLoad->ChunkLocation, DataToLoad->DirectionIndex);
 					}
 					else
 					{
 						(*ChunkActor)->IsInsideGeometryLoaded = true;
+						(*ChunkActor)->IsMeshCached = DataToLoad->FromCache;
+						ChunkPipeline.OnInsideGeometryReceived(DataToLoad->ChunkLocation, DataToLoad->FromCache);
 					}
 					
 				}
@@ -246,202 +368,1011 @@ void AVoxelWorld::IterateChunkMeshing()
 				ChunkGeometryToBeLoadedLater.Enqueue(DataToLoad);
 			}
 		}
-	}
+	}
+
+	while(!ChunkGeometryToBeLoadedLater.IsEmpty())
+	{
+		TSharedPtr<FChunkGeometry> DataToLoad;
+		ChunkGeometryToBeLoadedLater.Dequeue(DataToLoad);
+		ChunkQuadsToLoad.Enqueue(DataToLoad);
+	}
+
+	//Every chunk which received geometry this tick is rendered once, however many pieces of geometry it received
+	for (const auto& ChunkToUpload : ChunkPipeline.ConsumeChunksToUpload())
+	{
+		if (const auto ChunkActor = GetActorOfLoadedChunk(ChunkToUpload))
+		{
+			ChunkActor->RenderChunk(DefaultVoxelSize);
+			ChunkPipeline.OnChunkUploaded(ChunkToUpload);
+		}
+	}
+}
+
+void AVoxelWorld::UpdateChunkReferences(const FVoxelWorldManagedPlayerData& PlayerData, FIntVector NewLoadingOrigin)
+{
+	/*A player references every chunk within its unloading distance, the chunks it stops referencing are queued for unloading if nobody else references them*/
+	TArray<FIntVector> ChangedChunks;
+
+	if (PlayerData.HasLoadingOrigin)
+	{
+		PlayerData.RetainingShells->GetEnteringChunks(PlayerData.LastLoadingOrigin, NewLoadingOrigin, ChangedChunks);
+	}
+	else
+	{
+		for (const auto& RetainingLayer : PlayerData.RetainingShells->GetViewLayers())
+		{
+			for (const auto& Chunk : RetainingLayer)
+			{
+				ChangedChunks.Add(Chunk + NewLoadingOrigin);
+			}
+		}
+	}
+
+	for (const auto& Chunk : ChangedChunks)
+	{
+		AddChunkReference(Chunk);
+	}
+
+	if (PlayerData.HasLoadingOrigin)
+	{
+		ChangedChunks.Reset();
+		PlayerData.RetainingShells->GetLeavingChunks(PlayerData.LastLoadingOrigin, NewLoadingOrigin, ChangedChunks);
+		for (const auto& Chunk : ChangedChunks)
+		{
+			RemoveChunkReference(Chunk);
+		}
+	}
+}
+
+void AVoxelWorld::AddChunkReference(FIntVector ChunkLocation)
+{
+	auto& ReferenceCount = ChunkReferenceCounts.FindOrAdd(ChunkLocation);
+	if (ReferenceCount == 0)
+	{
+		LoadedRegions.Pin(GetRegionOfChunk(ChunkLocation));
+		ColumnReferenceCounts.FindOrAdd(FIntPoint(ChunkLocation.X, ChunkLocation.Y)) += 1;
+	}
+	ReferenceCount += 1;
+}
+
+void AVoxelWorld::RemoveChunkReference(FIntVector ChunkLocation)
+{
+	if (const auto ReferenceCount = ChunkReferenceCounts.Find(ChunkLocation))
+	{
+		*ReferenceCount -= 1;
+		if (*ReferenceCount == 0)
+		{
+			ChunkReferenceCounts.Remove(ChunkLocation);
+			LoadedRegions.Unpin(GetRegionOfChunk(ChunkLocation));
+			RemoveColumnReference(FIntPoint(ChunkLocation.X, ChunkLocation.Y));
+			if (ChunkStates.Contains(ChunkLocation))
+			{
+				ChunksToUnload.Enqueue(ChunkLocation);
+			}
+		}
+	}
+}
+
+void AVoxelWorld::RemoveColumnReference(FIntPoint ColumnLocation)
+{
+	/*A chunk of the column generated after the column left every view adds it back, it is then evicted with the budget*/
+	if (const auto ReferenceCount = ColumnReferenceCounts.Find(ColumnLocation))
+	{
+		*ReferenceCount -= 1;
+		if (*ReferenceCount == 0)
+		{
+			ColumnReferenceCounts.Remove(ColumnLocation);
+			if (ColumnCache.IsValid())
+			{
+				ColumnCache->Remove(ColumnLocation);
+			}
+		}
+	}
+}
+
+void AVoxelWorld::IterateChunkUnloading()
+{
+	/*Unload the chunks that no player references anymore, within the per-tick budget*/
+	int32 NumberOfUnloadedChunks = 0;
+	FIntVector ChunkLocation;
+	
+	while (NumberOfUnloadedChunks < MaxChunkUnloadsPerTick && ChunksToUnload.Dequeue(ChunkLocation))
+	{
+		//The chunk may have entered a player's view again since it was queued
+		if (ChunkReferenceCounts.Contains(ChunkLocation))
+		{
+			continue;
+		}
+
+		if (const auto ChunkState = ChunkStates.Find(ChunkLocation))
+		{
+			if (*ChunkState == EChunkState::Loading)
+			{
+				*ChunkState = EChunkState::Unloading;
+			}
+			else if (*ChunkState == EChunkState::Loaded)
+			{
+				UnloadChunk(ChunkLocation);
+				NumberOfUnloadedChunks += 1;
+			}
+			else if (*ChunkState == EChunkState::PendingRegion)
+			{
+				//Nothing was sent for it yet, it is skipped when its region arrives
+				ChunkStates.Remove(ChunkLocation);
+			}
+		}
+	}
+	
+}
+
+void AVoxelWorld::UnloadChunk(FIntVector ChunkLocation)
+{
+	/*Destroy a chunk actor, its edits that were not saved yet are kept with its region's data
+	 *The chunk is kept in the cache of unloaded chunks and the mesh of a saved chunk is cached on disk
+	 */
+	if (const auto DataOnlyChunkData = DataOnlyChunks.Find(ChunkLocation))
+	{
+		if (ChunksToSave.Contains(ChunkLocation))
+		{
+			SetChunkSavedData(ChunkLocation, **DataOnlyChunkData);
+		}
+		EncodeUnloadedChunk(ChunkLocation, *DataOnlyChunkData, nullptr);
+		DataOnlyChunks.Remove(ChunkLocation);
+	}
+
+	const auto ChunkActor = ChunkActorsMap.Find(ChunkLocation);
+	if (ChunkActor && IsValid(*ChunkActor))
+	{
+		if (ChunksToSave.Contains(ChunkLocation) && (*ChunkActor)->BlocksDataPtr.IsValid())
+		{
+			SetChunkSavedData(ChunkLocation, *(*ChunkActor)->BlocksDataPtr);
+		}
+		if ((*ChunkActor)->BlocksDataPtr.IsValid())
+		{
+			EncodeUnloadedChunk(ChunkLocation, (*ChunkActor)->BlocksDataPtr, *ChunkActor);
+		}
+		(*ChunkActor)->UnlinkNeighbours();
+		(*ChunkActor)->Destroy();
+	}
+	
+	ChunkActorsMap.Remove(ChunkLocation);
+	ChunkStates.Remove(ChunkLocation);
+	ChunkPipeline.OnChunkRemoved(ChunkLocation);
+}
+
+
+bool AVoxelWorld::IsChunkLoaded(FIntVector ChunkLocation)
+{
+	/*Tests if a chunk is marked as loaded. A true return value doesn't necessarily mean its chunk data is finished loading*/
+	if (ChunkStates.Contains(ChunkLocation))
+	{
+		return (ChunkStates[ChunkLocation] == EChunkState::Loaded);
+	}
+	else
+	{
+		return false;
+	}
+}
+
+TMap<FIntVector, FChunkData>* AVoxelWorld::GetRegionSavedData(FIntVector ChunkRegionLocation)
+{
+	/*Get the saved data of a given region that is in memory, the chunks of its region file are only read when they are accessed through FindChunkSavedData*/
+
+	if (const auto LoadedRegionData = LoadedRegions.Find(ChunkRegionLocation))
+	{
+		return LoadedRegionData;
+	}
+	else if (GetRegionFile(ChunkRegionLocation, false))
+	{
+		return &LoadedRegions.FindOrAdd(ChunkRegionLocation);
+	}
+	else
+	{
+		return nullptr;
+	}
+	
+}
+
+FChunkData* AVoxelWorld::FindChunkSavedData(FIntVector ChunkLocation)
+{
+	/*Get the saved data of a chunk, only this chunk is read from its region file if it is not in memory yet*/
+	const auto RegionLocation = GetRegionOfChunk(ChunkLocation);
+	if (RegionsInMemory.Contains(RegionLocation))
+	{
+		const auto LoadedRegionData = LoadedRegions.Find(RegionLocation);
+		return LoadedRegionData ? LoadedRegionData->Find(ChunkLocation) : nullptr;
+	}
+
+	const auto RegionSavedData = GetRegionSavedData(RegionLocation);
+	if (!RegionSavedData)
+	{
+		return nullptr;
+	}
+
+	if (const auto ChunkSavedData = RegionSavedData->Find(ChunkLocation))
+	{
+		return ChunkSavedData;
+	}
+
+	const auto RegionFile = GetRegionFile(RegionLocation, false);
+	if (RegionFile && RegionFile->Contains(ChunkLocation))
+	{
+		FChunkData ChunkSavedData;
+		if (RegionFile->ReadChunk(ChunkLocation, ChunkSavedData))
+		{
+			return &RegionSavedData->Add(ChunkLocation, ChunkSavedData);
+		}
+		UE_LOG(LogTemp, Error, TEXT("Could not read chunk %d, %d, %d from its region file"), ChunkLocation.X, ChunkLocation.Y, ChunkLocation.Z)
+	}
+	return nullptr;
+}
+
+FVoxelRegionFile* AVoxelWorld::GetRegionFile(FIntVector RegionLocation, bool CreateIfMissing)
+{
+	/*Open the file of a region, a region saved in the former format is converted the first time it is accessed
+	 *Regions that were never saved are known from the world save and don't cost any disk access
+	 */
+	//The file of a region being read on the region I/O thread is already in the map, it is opened by whichever thread gets there first
+	const auto ExistingRegionFile = RegionFiles.Find(RegionLocation);
+	if (ExistingRegionFile && (*ExistingRegionFile)->IsOpen())
+	{
+		return ExistingRegionFile->Get();
+	}
+
+	if (!CreateIfMissing && !WorldSavedInfo->SavedRegions.Contains(RegionLocation))
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<FVoxelRegionFile> RegionFile = ExistingRegionFile ? *ExistingRegionFile : MakeShared<FVoxelRegionFile>(FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation), RegionLocation);
+	if (!RegionFile->Open(false) && !ConvertLegacyRegionSave(RegionLocation, *RegionFile))
+	{
+		if (!CreateIfMissing || !RegionFile->Open(true))
+		{
+			return nullptr;
+		}
+	}
+
+	RegionFiles.Add(RegionLocation, RegionFile);
+	return RegionFile.Get();
+}
+
+bool AVoxelWorld::ConvertLegacyRegionSave(FIntVector RegionLocation, FVoxelRegionFile& RegionFile)
+{
+	/*Write the chunks of a region saved as a URegionDataSaveGame into its region file, the old save is left in place*/
+	const FString& RegionSaveSlot = GetRegionName(RegionLocation);
+	if (!UGameplayStatics::DoesSaveGameExist(RegionSaveSlot, 0))
+	{
+		return false;
+	}
+
+	const auto RegionDataSaveObjectPtr = Cast<URegionDataSaveGame>(UGameplayStatics::LoadGameFromSlot(RegionSaveSlot, 0));
+	if (!RegionDataSaveObjectPtr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Encountered invalid save data while converting a region"))
+		return false;
+	}
+
+	if (!RegionFile.Open(true) || !RegionFile.WriteRegion(RegionDataSaveObjectPtr->RegionData))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not convert region %d, %d, %d to a region file"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Converted region %d, %d, %d to a region file, %d chunks"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z, RegionFile.Num())
+	return true;
+}
+
+TSharedPtr<FVoxelRegionFile> AVoxelWorld::FindOrAddRegionFile(FIntVector RegionLocation)
+{
+	/*The file is not opened here, it is opened by the thread that first reads or writes it*/
+	TSharedPtr<FVoxelRegionFile>& RegionFile = RegionFiles.FindOrAdd(RegionLocation);
+	if (!RegionFile.IsValid())
+	{
+		RegionFile = MakeShared<FVoxelRegionFile>(FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation), RegionLocation);
+	}
+	return RegionFile;
+}
+
+TSharedPtr<FVoxelRegionFile> AVoxelWorld::FindMeshCacheFile(FIntVector RegionLocation, bool CreateIfMissing)
+{
+	/*Whether a region has a mesh cache on disk is checked once, so that meshing orders don't try to open a file that doesn't exist*/
+	if (!UseMeshCache)
+	{
+		return nullptr;
+	}
+
+	if (const auto MeshCacheFile = MeshCacheFiles.Find(RegionLocation))
+	{
+		if (MeshCacheFile->IsValid() || !CreateIfMissing)
+		{
+			return *MeshCacheFile;
+		}
+	}
+
+	const FString MeshCacheFilePath = FVoxelChunkMeshCache::GetMeshCacheFilePath(WorldName, RegionLocation);
+	TSharedPtr<FVoxelRegionFile> MeshCacheFile;
+	if (CreateIfMissing || FPlatformFileManager::Get().GetPlatformFile().FileExists(*MeshCacheFilePath))
+	{
+		MeshCacheFile = MakeShared<FVoxelRegionFile>(MeshCacheFilePath, RegionLocation, EVoxelRegionFileContent::ChunkMeshes);
+	}
+	MeshCacheFiles.Add(RegionLocation, MeshCacheFile);
+	return MeshCacheFile;
+}
+
+bool AVoxelWorld::IsInBaseWorldPack(FIntVector ChunkLocation) const
+{
+	return BaseWorldPackFile.IsValid() && BaseWorldPackFile->Contains(ChunkLocation);
+}
+
+void AVoxelWorld::RequestWorldPackChunk(FIntVector ChunkLocation, TSharedPtr<FChunkData> AdditiveChunkDataPtr, bool ComputeGeometry)
+{
+	/*The chunk is decoded on a generation thread straight from the mapped pack, the state of the chunk is set by the caller*/
+	auto ChunkLoadingOrder = FChunkThreadedWorkOrderBase();
+	ChunkLoadingOrder.Generator = GetWorldGenerator();
+	ChunkLoadingOrder.TargetChunkDataPtr = AdditiveChunkDataPtr;
+	ChunkLoadingOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
+	ChunkLoadingOrder.GeneratedChunkGeometryToLoadQueuePtr = ComputeGeometry ? &ChunkQuadsToLoad : nullptr;
+	ChunkLoadingOrder.ChunkLocation = ChunkLocation;
+	ChunkLoadingOrder.OrderType = EChunkThreadedWorkOrderType::LoadingFromWorldPack;
+	ChunkLoadingOrder.WorldPack = BaseWorldPackFile;
+	GenerationScheduler.EnqueueOrder(ChunkLoadingOrder);
+}
+
+bool AVoxelWorld::IsLoadedFromSavedData(FIntVector ChunkLocation)
+{
+	/*Chunks whose saved data is complete are loaded without being generated, a chunk is only unloaded once its region's saved data is in memory*/
+	const auto RegionSavedData = LoadedRegions.Peek(GetRegionOfChunk(ChunkLocation));
+	const auto ChunkSavedData = RegionSavedData ? RegionSavedData->Find(ChunkLocation) : nullptr;
+	return ChunkSavedData && !ChunkSavedData->IsAdditive;
+}
+
+void AVoxelWorld::EncodeUnloadedChunk(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkData, const AChunk* ChunkActor)
+{
+	/*The data of an unloaded chunk is not modified anymore, so it is hashed and encoded on a worker thread
+	 *Only the chunks that are reloaded from their saved data can use a cached mesh, the others are generated again
+	 */
+	const bool HasInsideGeometry = ChunkActor && ChunkActor->IsInsideGeometryLoaded;
+	const bool LoadedFromSavedData = IsLoadedFromSavedData(ChunkLocation);
+
+	FEncodedUnloadedChunk EncodedChunk;
+	EncodedChunk.ChunkLocation = ChunkLocation;
+	EncodedChunk.KeepInMemory = UnloadedChunkCacheBudgetMB > 0;
+	EncodedChunk.WriteMeshCache = UseMeshCache && HasInsideGeometry && !ChunkActor->IsMeshCached && LoadedFromSavedData;
+	if (!EncodedChunk.KeepInMemory && !EncodedChunk.WriteMeshCache)
+	{
+		return;
+	}
+
+	TSharedPtr<TMap<FIntVector4, FVoxel>> InsideQuads;
+	if (HasInsideGeometry)
+	{
+		InsideQuads = MakeShared<TMap<FIntVector4, FVoxel>>();
+		FVoxelChunkMeshCache::GetInsideQuads(ChunkActor->GetQuads(), *InsideQuads);
+	}
+
+	if (EncodedChunk.KeepInMemory)
+	{
+		EncodedChunk.Sequence = UnloadedChunks.Add(ChunkLocation, ChunkData, InsideQuads, !LoadedFromSavedData && !IsInBaseWorldPack(ChunkLocation));
+	}
+
+	auto EncodedUnloadedChunksPtr = &EncodedUnloadedChunks;
+	UnloadedChunkEncodingTasks.Add(Async(EAsyncExecution::ThreadPool, [EncodedChunk = MoveTemp(EncodedChunk), ChunkData, InsideQuads, EncodedUnloadedChunksPtr]() mutable
+	{
+		if (EncodedChunk.KeepInMemory && !FVoxelChunkCodec::Encode(*ChunkData, EncodedChunk.EncodedChunkData))
+		{
+			EncodedChunk.EncodedChunkData.Empty();
+		}
+		if (InsideQuads.IsValid())
+		{
+			//The hash is only needed to validate the mesh cache on disk
+			const uint32 DataHash = EncodedChunk.WriteMeshCache ? FVoxelChunkMeshCache::HashChunkData(*ChunkData) : 0;
+			FVoxelChunkMeshCache::Encode(DataHash, *InsideQuads, EncodedChunk.EncodedInsideQuads);
+		}
+		EncodedUnloadedChunksPtr->Enqueue(MoveTemp(EncodedChunk));
+	}));
+}
+
+void AVoxelWorld::IterateUnloadedChunkEncoding()
+{
+	/*Collect the chunks encoded since the last call, then evict the oldest unloaded chunks beyond the budget
+	 *A newer mesh of a chunk replaces the one that is waiting for the next save
+	 */
+	FEncodedUnloadedChunk EncodedChunk;
+	while (EncodedUnloadedChunks.Dequeue(EncodedChunk))
+	{
+		if (EncodedChunk.WriteMeshCache && EncodedChunk.EncodedInsideQuads.Num() > 0)
+		{
+			PendingChunkMeshes.FindOrAdd(GetRegionOfChunk(EncodedChunk.ChunkLocation)).Add(EncodedChunk.ChunkLocation, EncodedChunk.EncodedInsideQuads);
+		}
+
+		if (EncodedChunk.KeepInMemory)
+		{
+			if (EncodedChunk.EncodedChunkData.Num() > 0)
+			{
+				UnloadedChunks.SetEncoded(EncodedChunk.ChunkLocation, EncodedChunk.Sequence, MoveTemp(EncodedChunk.EncodedChunkData), MoveTemp(EncodedChunk.EncodedInsideQuads));
+			}
+			else
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not encode unloaded chunk %d, %d, %d"), EncodedChunk.ChunkLocation.X, EncodedChunk.ChunkLocation.Y, EncodedChunk.ChunkLocation.Z)
+				UnloadedChunks.Invalidate(EncodedChunk.ChunkLocation);
+			}
+		}
+	}
+
+	UnloadedChunkEncodingTasks.RemoveAll([](const TFuture<void>& EncodingTaskFuture)
+	{
+		return EncodingTaskFuture.IsReady();
+	});
+
+	UnloadedChunks.Evict(static_cast<int64>(UnloadedChunkCacheBudgetMB) << 20);
+}
+
+void AVoxelWorld::RequestUnloadedChunk(FIntVector ChunkLocation, EChunkLoadingLevel Level, FUnloadedChunk& UnloadedChunk)
+{
+	/*A chunk kept in the cache of unloaded chunks is at least as recent as its saved data, so it is neither generated nor meshed again
+	 *Data-only chunks are decoded right away, the others are decoded and get their geometry on the generation threads
+	 */
+	if (Level == EChunkLoadingLevel::DataOnly)
+	{
+		TSharedPtr<FChunkData> ChunkDataPtr = UnloadedChunk.ChunkData;
+		if (!ChunkDataPtr.IsValid())
+		{
+			ChunkDataPtr = MakeShared<FChunkData>();
+			if (!FVoxelChunkCodec::Decode(UnloadedChunk.EncodedChunkData, *ChunkDataPtr))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not decode unloaded chunk %d, %d, %d, loading it again"), ChunkLocation.X, ChunkLocation.Y, ChunkLocation.Z)
+				CreateChunkAt(ChunkLocation, Level);
+				return;
+			}
+		}
+		DataOnlyChunks.Add(ChunkLocation, ChunkDataPtr);
+		ChunkStates.Add(ChunkLocation, EChunkState::Loaded);
+		return;
+	}
+
+	ChunkStates.Add(ChunkLocation, EChunkState::Loading);
+	ChunkPipeline.OnChunkRequested(ChunkLocation, IsInFrontOfNearestAnchor(ChunkLocation));
+
+	auto ChunkLoadingOrder = FChunkThreadedWorkOrderBase();
+	ChunkLoadingOrder.Generator = GetWorldGenerator();
+	ChunkLoadingOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
+	ChunkLoadingOrder.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
+	ChunkLoadingOrder.ChunkLocation = ChunkLocation;
+	ChunkLoadingOrder.OrderType = EChunkThreadedWorkOrderType::LoadingUnloadedChunk;
+	ChunkLoadingOrder.UnloadedChunk = MakeShared<FUnloadedChunk>(MoveTemp(UnloadedChunk));
+	GenerationScheduler.EnqueueOrder(ChunkLoadingOrder);
+}
+
+bool AVoxelWorld::IsRegionInMemory(FIntVector RegionLocation) const
+{
+	/*A region that was never saved has nothing to read*/
+	return RegionsInMemory.Contains(RegionLocation) || !WorldSavedInfo->SavedRegions.Contains(RegionLocation);
+}
+
+void AVoxelWorld::WaitForRegion(FIntVector ChunkLocation, EChunkLoadingLevel Level)
+{
+	/*Park a chunk until the saved data of its region is in memory, the read of the region is only requested by the first chunk waiting for it*/
+	const auto RegionLocation = GetRegionOfChunk(ChunkLocation);
+	
+	ChunkStates.Add(ChunkLocation, EChunkState::PendingRegion);
+
+	if (const auto WaitingChunks = PendingRegionChunks.Find(RegionLocation))
+	{
+		auto& WaitingLevel = WaitingChunks->FindOrAdd(ChunkLocation, Level);
+		WaitingLevel = FMath::Max(WaitingLevel, Level);
+		return;
+	}
+
+	PendingRegionChunks.Add(RegionLocation).Add(ChunkLocation, Level);
+
+	FVoxelRegionReadRequest Request;
+	Request.RegionLocation = RegionLocation;
+	Request.RegionFile = FindOrAddRegionFile(RegionLocation);
+	Request.LegacySaveSlot = GetRegionName(RegionLocation);
+	RegionIORunnable->RequestRegionRead(Request);
+}
+
+void AVoxelWorld::IterateRegionLoading()
+{
+	/*Bring the regions read on the region I/O thread into memory and create the chunks that were waiting for them
+	 *Chunks that were edited or unloaded with edits while their region was being read keep their data in memory, which is more recent
+	 */
+	FVoxelRegionReadResult ReadResult;
+	while (RegionIORunnable->RegionReadResultsQueue.Dequeue(ReadResult))
+	{
+		auto& RegionSavedData = LoadedRegions.FindOrAdd(ReadResult.RegionLocation);
+
+		if (ReadResult.RegionFileRead)
+		{
+			for (const auto& ChunkPair : *ReadResult.RegionData)
+			{
+				if (!RegionSavedData.Contains(ChunkPair.Key))
+				{
+					RegionSavedData.Add(ChunkPair.Key, ChunkPair.Value);
+				}
+			}
+		}
+		else if (ReadResult.LegacySaveFound)
+		{
+			//The former format can only be read on the game thread, this happens once per region
+			if (GetRegionFile(ReadResult.RegionLocation, false))
+			{
+				for (const auto& ChunkLocation : ReadResult.RegionFile->GetChunkLocations())
+				{
+					FindChunkSavedData(ChunkLocation);
+				}
+			}
+		}
+		else if (!ReadResult.RegionFile->IsOpen())
+		{
+			//There is nothing on disk for this region, its file is created on the next save
+			RegionFiles.Remove(ReadResult.RegionLocation);
+		}
 
-	while(!ChunkGeometryToBeLoadedLater.IsEmpty())
-	{
-		TSharedPtr<FChunkGeometry> DataToLoad;
-		ChunkGeometryToBeLoadedLater.Dequeue(DataToLoad);
-		ChunkQuadsToLoad.Enqueue(DataToLoad);
-	}
-}
+		RegionsInMemory.Add(ReadResult.RegionLocation);
 
-void AVoxelWorld::IterateChunkUnloading()
-{
-	/*Unload all chunks beyond loading distance*/
-	for (const auto CurrentPair : ManagedPlayerDataMap)
-	{
-		if (IsValid(CurrentPair.Key))
+		TMap<FIntVector, EChunkLoadingLevel> WaitingChunks;
+		PendingRegionChunks.RemoveAndCopyValue(ReadResult.RegionLocation, WaitingChunks);
+		for (const auto& WaitingChunkPair : WaitingChunks)
 		{
-			const auto LoadingOrigin =	FIntVector(this->GetActorRotation().GetInverse().RotateVector((CurrentPair.Key->GetPawn()->GetActorLocation() - this->GetActorLocation())/(ChunkSize*DefaultVoxelSize*this->GetActorScale().X)));
-	
-			for (auto& RegisteredChunkState : ChunkStates)
+			//Chunks that left every view while they were waiting were removed from the states
+			const auto ChunkState = ChunkStates.Find(WaitingChunkPair.Key);
+			if (ChunkState && *ChunkState == EChunkState::PendingRegion)
 			{
-				if (RegisteredChunkState.Value == EChunkState::Loaded && !ChunksToSave.Contains(RegisteredChunkState.Key) && OneNorm(RegisteredChunkState.Key - LoadingOrigin) > ViewDistance + 2 )
-				{
-					ChunkStates[RegisteredChunkState.Key] = EChunkState::Unloading;
-					if (NumbersOfPlayerOutsideRangeOfChunkMap.Contains(RegisteredChunkState.Key))
-					{
-						NumbersOfPlayerOutsideRangeOfChunkMap[RegisteredChunkState.Key] += 1;
-					}
-					else
-					{
-						NumbersOfPlayerOutsideRangeOfChunkMap.Add(RegisteredChunkState.Key, 1);
-					}
-				}
+				ChunkStates.Remove(WaitingChunkPair.Key);
+				CreateChunkAt(WaitingChunkPair.Key, WaitingChunkPair.Value);
 			}
 		}
 	}
-	for (auto& ChunkUnloadingScore : NumbersOfPlayerOutsideRangeOfChunkMap)
+}
+
+void AVoxelWorld::ConvertLegacyRegionSaves()
+{
+	int32 NumberOfRegions = 0;
+	for (const auto& RegionLocation : WorldSavedInfo->SavedRegions)
 	{
-		if (ChunkUnloadingScore.Value == ManagedPlayerDataMap.Num())
+		if (GetRegionFile(RegionLocation, false))
 		{
-			ChunkStates.Remove(ChunkUnloadingScore.Key);
-			ChunkActorsMap[ChunkUnloadingScore.Key]->Destroy();
+			NumberOfRegions += 1;
 		}
 	}
-	NumbersOfPlayerOutsideRangeOfChunkMap.Empty();
-	
+	UE_LOG(LogTemp, Display, TEXT("%d saved regions are available as region files"), NumberOfRegions)
 }
 
-
-bool AVoxelWorld::IsChunkLoaded(FIntVector ChunkLocation)
+void AVoxelWorld::SetChunkSavedData(FIntVector ChunkLocation, FChunkData NewData) 
 {
-	/*Tests if a chunk is marked as loaded. A true return value doesn't necessarily mean its chunk data is finished loading*/
-	if (ChunkStates.Contains(ChunkLocation))
+	/*Sets the saved data of a chunk in memory, it is written to its region file on the next save*/
+
+	if (const auto RegionSavedData = GetRegionSavedData(GetRegionOfChunk(ChunkLocation)))
 	{
-		return (ChunkStates[ChunkLocation] == EChunkState::Loaded);
+		RegionSavedData->Add(ChunkLocation, NewData);
 	}
 	else
 	{
-		return false;
+		LoadedRegions.FindOrAdd(GetRegionOfChunk(ChunkLocation)).Add(ChunkLocation, NewData);
 	}
+
+	RegisterChunkForSaving(ChunkLocation);
 }
 
-TMap<FIntVector, FChunkData>* AVoxelWorld::GetRegionSavedData(FIntVector ChunkRegionLocation)
+void AVoxelWorld::RegisterChunkForSaving(FIntVector3 ChunkLocation)
 {
-	/*Get the saved data of a given region */
+	/*Mark a chunk as needing to be updated in the save file on the next save*/
+	ChunksToSave.Add(ChunkLocation);
+	RegionsToSave.Add(GetRegionOfChunk(ChunkLocation));
+	WorldSavedInfo->SavedRegions.Add(GetRegionOfChunk(ChunkLocation));
+}
 
-	if (const auto LoadedRegionData = LoadedRegions.Find(ChunkRegionLocation))
+void AVoxelWorld::SaveVoxelWorld() 
+{
+	/*Take a snapshot of every chunk that has been marked as needing to be saved and write it on worker threads, one task per region
+	 *Loaded chunks are shared with the snapshot rather than copied, they are copied only if they are edited before the save is done
+	 */
+	if (RegionSavesInFlight > 0)
 	{
-		return LoadedRegionData;
+		SaveRequestedWhileSaving = true;
+		return;
 	}
-	else
+
+	SaveStartTime = FPlatformTime::Seconds();
+	SaveFailed = false;
+	WorldSaveInFlight = true;
+
+	UGameplayStatics::AsyncSaveGameToSlot(WorldSavedInfo, WorldName + "\\WorldSaveData", 0 );
+
+	//The edits made from now on go to a new journal segment, the older ones are covered by this save
+	JournalSegmentOfSave = EditJournal.IsOpen() ? EditJournal.Rotate() : INDEX_NONE;
+
+	TMap<FIntVector, TSharedPtr<FVoxelRegionSaveTask>> RegionSaveTasks;
+	for (const auto& CurrentChunk : ChunksToSave)
 	{
-		const FString& RegionSaveSlot = GetRegionName(ChunkRegionLocation);
-		if (UGameplayStatics::DoesSaveGameExist(RegionSaveSlot, 0))
+		TSharedPtr<FChunkData> ChunkDataPtr;
+		
+		const auto ChunkObjectPtr = ChunkActorsMap.Find(CurrentChunk);
+		if (ChunkObjectPtr && IsValid(*ChunkObjectPtr) && (*ChunkObjectPtr)->BlocksDataPtr.IsValid())
 		{
-			if (auto RegionDataSaveObjectPtr = Cast<URegionDataSaveGame>(UGameplayStatics::LoadGameFromSlot(RegionSaveSlot, 0)))
-			{
-				LoadedRegions.Add(ChunkRegionLocation, (RegionDataSaveObjectPtr->RegionData));
-				return &(RegionDataSaveObjectPtr->RegionData);
-			}
-			else
+			ChunkDataPtr = (*ChunkObjectPtr)->BlocksDataPtr;
+			ChunkDataInSaveSnapshot.Add(ChunkDataPtr.Get());
+		}
+		else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(CurrentChunk))
+		{
+			ChunkDataPtr = *DataOnlyChunkData;
+			ChunkDataInSaveSnapshot.Add(ChunkDataPtr.Get());
+		}
+		else if (const auto LoadedRegionData = LoadedRegions.Find(GetRegionOfChunk(CurrentChunk)))
+		{
+			//Unloaded chunks are stored by value, they are small and few so they are copied
+			if (const auto ChunkSavedData = LoadedRegionData->Find(CurrentChunk))
 			{
-				return nullptr;
+				ChunkDataPtr = MakeShared<FChunkData>(*ChunkSavedData);
 			}
 		}
-		else
+
+		if (!ChunkDataPtr.IsValid())
 		{
-			return nullptr;
+			continue;
+		}
+
+		const auto CurrentRegion = GetRegionOfChunk(CurrentChunk);
+		auto& SaveTask = RegionSaveTasks.FindOrAdd(CurrentRegion);
+		if (!SaveTask.IsValid())
+		{
+			SaveTask = MakeShared<FVoxelRegionSaveTask>();
+			SaveTask->RegionLocation = CurrentRegion;
+			SaveTask->RegionFile = FindOrAddRegionFile(CurrentRegion);
+			SaveTask->LegacySaveSlot = GetRegionName(CurrentRegion);
 		}
+		SaveTask->Chunks.Add(CurrentChunk, ChunkDataPtr);
 	}
-	
-}
 
+	//The meshes cached since the last save are written along with the chunks of their region
+	IterateUnloadedChunkEncoding();
+	for (auto& PendingMeshesPair : PendingChunkMeshes)
+	{
+		auto& SaveTask = RegionSaveTasks.FindOrAdd(PendingMeshesPair.Key);
+		if (!SaveTask.IsValid())
+		{
+			SaveTask = MakeShared<FVoxelRegionSaveTask>();
+			SaveTask->RegionLocation = PendingMeshesPair.Key;
+			SaveTask->RegionFile = FindOrAddRegionFile(PendingMeshesPair.Key);
+			SaveTask->LegacySaveSlot = GetRegionName(PendingMeshesPair.Key);
+		}
+		SaveTask->MeshCacheFile = FindMeshCacheFile(PendingMeshesPair.Key, true);
+		SaveTask->ChunkMeshes = MoveTemp(PendingMeshesPair.Value);
+	}
+	PendingChunkMeshes.Empty();
+
+	UE_LOG(LogTemp, Display, TEXT("Saving %d chunks in %d regions, snapshot taken in %f ms"), ChunksToSave.Num(), RegionSaveTasks.Num(), 1000*(FPlatformTime::Seconds() - SaveStartTime))
 
+	ChunksToSave.Empty();
+	RegionsToSave.Empty();
 
-void AVoxelWorld::SetChunkSavedData(FIntVector ChunkLocation, FChunkData NewData) 
+	for (const auto& RegionSaveTaskPair : RegionSaveTasks)
+	{
+		DispatchRegionSave(RegionSaveTaskPair.Value);
+	}
+
+	if (RegionSavesInFlight == 0)
+	{
+		WorldSaveInFlight = false;
+		EditJournal.DeleteSegmentsBefore(JournalSegmentOfSave);
+		OnVoxelWorldSaved.Broadcast(true);
+	}
+}
+
+void AVoxelWorld::IterateRegionCacheEviction()
 {
-	/*Sets the data of a chunk on the save file directly*/
+	/*Evict the least recently used regions while the region cache is over its budget
+	 *The dirty chunks of a region are written back first and the region is only evicted on a later tick once the write is done, so that it can't be read back from disk before its chunks are written
+	 *Regions whose read is in flight are kept, their waiting chunks need them
+	 */
+	TArray<FIntVector> Candidates;
+	LoadedRegions.GetEvictionCandidates(static_cast<int64>(RegionCacheBudgetMB) << 20, Candidates);
 
-	if (const auto LoadedRegionData = LoadedRegions.Find(GetRegionOfChunk(ChunkLocation)))
+	//A region written back while a world save is running could be written after a newer snapshot of the same region, and write-backs would keep delaying a save waiting for them to finish
+	const bool CanWriteBack = !IsSaving();
+	
+	for (const auto& RegionLocation : Candidates)
 	{
-		if (const auto CurrentChunkData = LoadedRegionData->Find(ChunkLocation))
+		if (PendingRegionChunks.Contains(RegionLocation) || RegionWritesInFlight.Contains(RegionLocation))
 		{
-			CurrentChunkData->CompressedChunkData = NewData.CompressedChunkData;
+			continue;
 		}
-	}
 
-	else
-	{
-		const FString& RegionSaveSlot = GetRegionName(GetRegionOfChunk(ChunkLocation));
-		if (UGameplayStatics::DoesSaveGameExist(RegionSaveSlot, 0))
+		const auto RegionSavedData = LoadedRegions.Peek(RegionLocation);
+		
+		//Chunks that are loaded are saved from their own data, which is more recent
+		TSharedPtr<FVoxelRegionSaveTask> WriteBackTask;
+		for (const auto& ChunkPair : *RegionSavedData)
 		{
-			if (auto RegionDataSaveObject = Cast<URegionDataSaveGame>(UGameplayStatics::LoadGameFromSlot( RegionSaveSlot, 0)))
+			if (ChunksToSave.Contains(ChunkPair.Key) && !ChunkActorsMap.Contains(ChunkPair.Key) && !DataOnlyChunks.Contains(ChunkPair.Key))
 			{
-				LoadedRegions.Add(GetRegionOfChunk(ChunkLocation), (RegionDataSaveObject->RegionData));
-				if (const auto CurrentChunkData = LoadedRegionData->Find(ChunkLocation))
+				if (!WriteBackTask.IsValid())
 				{
-					CurrentChunkData->CompressedChunkData = NewData.CompressedChunkData;
+					WriteBackTask = MakeShared<FVoxelRegionSaveTask>();
+					WriteBackTask->RegionLocation = RegionLocation;
+					WriteBackTask->RegionFile = FindOrAddRegionFile(RegionLocation);
+					WriteBackTask->LegacySaveSlot = GetRegionName(RegionLocation);
 				}
+				WriteBackTask->Chunks.Add(ChunkPair.Key, MakeShared<FChunkData>(ChunkPair.Value));
 			}
-			else
+		}
+
+		if (WriteBackTask.IsValid())
+		{
+			if (CanWriteBack)
 			{
-				UE_LOG(LogTemp,Error, TEXT("Encountered invalid save data while loading a region"))
+				for (const auto& ChunkPair : WriteBackTask->Chunks)
+				{
+					ChunksToSave.Remove(ChunkPair.Key);
+				}
+				DispatchRegionSave(WriteBackTask);
+				LoadedRegions.RecordWriteBack();
 			}
+			continue;
 		}
-		else
+
+		RemoveRegionFromMemory(RegionLocation);
+		LoadedRegions.RecordEviction();
+	}
+}
+
+void AVoxelWorld::ReleaseSavedRegions()
+{
+	/*Regions with chunks waiting to be saved, being written or being read are kept*/
+	TArray<FIntVector> Candidates;
+	LoadedRegions.GetEvictionCandidates(0, Candidates);
+
+	for (const auto& RegionLocation : Candidates)
+	{
+		if (!RegionsToSave.Contains(RegionLocation) && !PendingRegionChunks.Contains(RegionLocation) && !RegionWritesInFlight.Contains(RegionLocation))
 		{
-			auto NewRegion =  TMap<FIntVector, FChunkData>();
-			NewRegion.Add(ChunkLocation, NewData);
-			LoadedRegions.Add(GetRegionOfChunk(ChunkLocation), NewRegion);
+			RemoveRegionFromMemory(RegionLocation);
 		}
 	}
+}
 
-	
+void AVoxelWorld::RemoveRegionFromMemory(FIntVector RegionLocation)
+{
+	LoadedRegions.Remove(RegionLocation);
+	RegionsInMemory.Remove(RegionLocation);
+	RegionFiles.Remove(RegionLocation);
+	MeshCacheFiles.Remove(RegionLocation);
+}
 
-	RegisterChunkForSaving(ChunkLocation);
+bool AVoxelWorld::IsSaving() const
+{
+	/*A save requested while write-backs are in flight only starts once they are done, it is already reported*/
+	return WorldSaveInFlight || SaveRequestedWhileSaving;
 }
 
-void AVoxelWorld::RegisterChunkForSaving(FIntVector3 ChunkLocation)
+void AVoxelWorld::DispatchRegionSave(TSharedPtr<FVoxelRegionSaveTask> SaveTask)
 {
-	/*Mark a chunk as needing to be updated in the save file on the next save*/
-	ChunksToSave.Add(ChunkLocation);
-	RegionsToSave.Add(GetRegionOfChunk(ChunkLocation));
-	WorldSavedInfo->SavedRegions.Add(GetRegionOfChunk(ChunkLocation));
+	RegionSavesInFlight += 1;
+	RegionWritesInFlight.FindOrAdd(SaveTask->RegionLocation) += 1;
+	
+	auto CompletedRegionSavesPtr = &CompletedRegionSaves;
+	SaveTasksInFlight.Add(Async(EAsyncExecution::ThreadPool, [SaveTask, CompletedRegionSavesPtr]()
+	{
+		SaveTask->Run();
+		CompletedRegionSavesPtr->Enqueue(SaveTask);
+	}));
 }
 
-void AVoxelWorld::SaveVoxelWorld() 
+void AVoxelWorld::IterateChunkMeshWriting()
 {
-	/*Overwrite the save data of every chunk that has been marked as needing to be saved with their current data in the game*/
+	/*Meshes are not written while a save runs, the save takes them all and would otherwise wait for these writes to finish
+	 *A region that is being written keeps its meshes until its write is done, so that an older mesh of a chunk can't be written after a newer one
+	 */
+	if (IsSaving())
+	{
+		return;
+	}
+
+	int32 NumberOfPendingMeshes = 0;
+	for (const auto& PendingMeshesPair : PendingChunkMeshes)
+	{
+		NumberOfPendingMeshes += PendingMeshesPair.Value.Num();
+	}
+
+	const bool WriteEveryRegion = NumberOfPendingMeshes > MaxPendingChunkMeshes;
+	for (auto PendingMeshesIterator = PendingChunkMeshes.CreateIterator(); PendingMeshesIterator; ++PendingMeshesIterator)
+	{
+		if ((WriteEveryRegion || PendingMeshesIterator->Value.Num() >= ChunkMeshWriteBatchSize) && !RegionWritesInFlight.Contains(PendingMeshesIterator->Key))
+		{
+			DispatchChunkMeshWrite(PendingMeshesIterator->Key, MoveTemp(PendingMeshesIterator->Value));
+			PendingMeshesIterator.RemoveCurrent();
+		}
+	}
+}
 
-	UGameplayStatics::SaveGameToSlot(WorldSavedInfo, WorldName + "\\WorldSaveData", 0 );
+void AVoxelWorld::DispatchChunkMeshWrite(FIntVector RegionLocation, TMap<FIntVector, TArray<uint8>>&& ChunkMeshes)
+{
+	/*A save task without chunks, it only writes the mesh cache file of the region*/
+	const auto MeshWriteTask = MakeShared<FVoxelRegionSaveTask>();
+	MeshWriteTask->RegionLocation = RegionLocation;
+	MeshWriteTask->MeshCacheFile = FindMeshCacheFile(RegionLocation, true);
+	MeshWriteTask->ChunkMeshes = MoveTemp(ChunkMeshes);
+	DispatchRegionSave(MeshWriteTask);
+}
 
-	//iterate over the regions to save 
-	for (auto& CurrentRegionToSave : RegionsToSave) 
+void AVoxelWorld::IterateSaveCompletion()
+{
+	/*Handle the regions whose save is done, the save is complete once the last one comes back
+	 *The chunks of a region that could not be written are registered for saving again, unless they were edited since the snapshot
+	 */
+	TSharedPtr<FVoxelRegionSaveTask> SaveTask;
+	while (CompletedRegionSaves.Dequeue(SaveTask))
 	{
-		TMap<FIntVector, FChunkData> CurrentRegionData = TMap<FIntVector, FChunkData>();
+		RegionSavesInFlight -= 1;
+		if (const auto WritesInFlight = RegionWritesInFlight.Find(SaveTask->RegionLocation))
+		{
+			*WritesInFlight -= 1;
+			if (*WritesInFlight <= 0)
+			{
+				RegionWritesInFlight.Remove(SaveTask->RegionLocation);
+			}
+		}
 
-		if (auto RegionSaveData = GetRegionSavedData(CurrentRegionToSave))
+		//The former format can only be converted on the game thread, the region is written again once it has been converted
+		if (SaveTask->LegacySaveFound && GetRegionFile(SaveTask->RegionLocation, false))
 		{
-			CurrentRegionData = *RegionSaveData;
+			SaveTask->LegacySaveFound = false;
+			DispatchRegionSave(SaveTask);
+			continue;
 		}
 
-		for(int32 x = 0; x < RegionSize; x++)
+		if (!SaveTask->Success)
 		{
-			for(int32 y = 0; y < RegionSize; y++)
+			UE_LOG(LogTemp, Error, TEXT("Could not save region %d, %d, %d"), SaveTask->RegionLocation.X, SaveTask->RegionLocation.Y, SaveTask->RegionLocation.Z)
+			SaveFailed = true;
+			
+			for (const auto& ChunkPair : SaveTask->Chunks)
 			{
-				for(int32 z = 0; z < RegionSize; z++)
+				if (ChunksToSave.Contains(ChunkPair.Key))
 				{
-					auto const CurrentChunk = FIntVector(RegionSize*CurrentRegionToSave.X + x, RegionSize*CurrentRegionToSave.Y + y, RegionSize*CurrentRegionToSave.Z + z);
-					
-					if (ChunksToSave.Contains(CurrentChunk)) //for every chunk in the region, check if the chunk must be saved
-					{
-						if (auto ChunkObjectPtr = ChunkActorsMap.Find(CurrentChunk))
-						{
-							if (IsValid(*ChunkObjectPtr))
-							{
-								CurrentRegionData.Add(CurrentChunk, *((*ChunkObjectPtr)->BlocksDataPtr) );
-							}
-						}
-					}
-					
+					continue;
+				}
+				
+				if (ChunkActorsMap.Contains(ChunkPair.Key) || DataOnlyChunks.Contains(ChunkPair.Key))
+				{
+					RegisterChunkForSaving(ChunkPair.Key);
+				}
+				else
+				{
+					SetChunkSavedData(ChunkPair.Key, *ChunkPair.Value);
 				}
 			}
 		}
 
-		//save the region at hand
-		auto SaveObject = Cast<URegionDataSaveGame>(UGameplayStatics::CreateSaveGameObject(URegionDataSaveGame::StaticClass()));
+		if (RegionSavesInFlight == 0)
+		{
+			ChunkDataInSaveSnapshot.Empty();
+			SaveTasksInFlight.Empty();
 
-		SaveObject->RegionData = CurrentRegionData;
+			//Write-backs of evicted regions are not reported as world saves
+			if (WorldSaveInFlight)
+			{
+				WorldSaveInFlight = false;
+				UE_LOG(LogTemp, Display, TEXT("World saved in %f ms"), 1000*(FPlatformTime::Seconds() - SaveStartTime))
 
-		const FString& RegionSaveSlot = GetRegionName(CurrentRegionToSave);
-		UGameplayStatics::SaveGameToSlot(SaveObject,RegionSaveSlot , 0 );
-		
+				//The journal is kept when a region could not be written, its edits are replayed if the game stops before the next save
+				if (!SaveFailed)
+				{
+					EditJournal.DeleteSegmentsBefore(JournalSegmentOfSave);
+				}
+				OnVoxelWorldSaved.Broadcast(!SaveFailed);
+			}
+
+			if (SaveRequestedWhileSaving)
+			{
+				SaveRequestedWhileSaving = false;
+				SaveVoxelWorld();
+			}
+		}
 	}
+}
 
-	ChunksToSave.Empty();
+void AVoxelWorld::JournalEdit(FVector BlockWorldLocation, FVoxel NewVoxel)
+{
+	/*The previous voxel is only looked up in chunks that are in memory, journaling an edit never reads from disk*/
+	if (IsReplayingJournal || !EditJournal.IsOpen())
+	{
+		return;
+	}
+
+	FVoxelEdit Edit;
+	Edit.VoxelLocation = FloorVector((BlockWorldLocation - this->GetActorLocation())/DefaultVoxelSize);
+	Edit.NewVoxel = NewVoxel;
+
+	const auto AffectedChunkLocation = FloorVector((BlockWorldLocation - this->GetActorLocation())/(DefaultVoxelSize*ChunkSize*this->GetActorScale().X));
+	const auto BlockLocationInChunk = Edit.VoxelLocation - AffectedChunkLocation*ChunkSize;
+
+	TSharedPtr<FChunkData> ChunkDataPtr;
+	if (const auto ChunkPtr = GetActorOfLoadedChunk(AffectedChunkLocation))
+	{
+		ChunkDataPtr = ChunkPtr->BlocksDataPtr;
+	}
+	else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(AffectedChunkLocation))
+	{
+		ChunkDataPtr = *DataOnlyChunkData;
+	}
+
+	if (ChunkDataPtr.IsValid())
+	{
+		Edit.OldVoxel = ChunkDataPtr->GetVoxelAt(BlockLocationInChunk);
+		Edit.OldVoxelKnown = true;
+	}
+
+	EditJournal.Append(Edit);
+}
+
+void AVoxelWorld::ReplayEditJournal()
+{
+	/*Apply the edits that were journaled but not saved, they are saved again on the next save like any other edit
+	 *This happens before any chunk is loaded, so the edits go to the saved data of their chunks
+	 */
+	TArray<FVoxelEdit> Edits;
+	if (!EditJournal.ReadEdits(Edits))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Some segments of the edit journal could not be read"))
+	}
+	if (Edits.Num() == 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	IsReplayingJournal = true;
+	for (const auto& Edit : Edits)
+	{
+		SetBlockAt(this->GetActorLocation() + DefaultVoxelSize*(FVector(Edit.VoxelLocation) + FVector(0.5)), Edit.NewVoxel);
+	}
+	IsReplayingJournal = false;
+
+	UE_LOG(LogTemp, Display, TEXT("Replayed %d edits from the edit journal in %f ms"), Edits.Num(), 1000*(FPlatformTime::Seconds() - StartTime))
+}
+
+void AVoxelWorld::IterateEditJournal(float DeltaTime)
+{
+	/*Edits are written in small batches on a worker thread, and folded into the region files by a save once the journal has grown enough*/
+	TimeSinceJournalFlush += DeltaTime;
+	if (TimeSinceJournalFlush >= JournalFlushInterval && EditJournal.NeedsFlush() && (!JournalFlushTask.IsValid() || JournalFlushTask.IsReady()))
+	{
+		TimeSinceJournalFlush = 0;
+		auto EditJournalPtr = &EditJournal;
+		JournalFlushTask = Async(EAsyncExecution::ThreadPool, [EditJournalPtr]()
+		{
+			return EditJournalPtr->Flush();
+		});
+	}
+
+	if (!IsSaving() && ChunksToSave.Num() > 0 && EditJournal.GetCurrentSegmentBytes() > (static_cast<int64>(JournalCompactionThresholdKB) << 10))
+	{
+		SaveVoxelWorld();
+	}
+}
+
+void AVoxelWorld::FlushPendingSaves()
+{
+	while (RegionSavesInFlight > 0)
+	{
+		for (auto& SaveTaskFuture : SaveTasksInFlight)
+		{
+			SaveTaskFuture.Wait();
+		}
+		IterateSaveCompletion();
+	}
+}
+
+void AVoxelWorld::MakeChunkDataWritable(TSharedPtr<FChunkData>& ChunkDataPtr)
+{
+	/*Copy-on-write, the save keeps the data as it was when its snapshot was taken*/
+	if (ChunkDataPtr.IsValid() && ChunkDataInSaveSnapshot.Contains(ChunkDataPtr.Get()))
+	{
+		ChunkDataPtr = MakeShared<FChunkData>(*ChunkDataPtr);
+	}
 }
 
 void AVoxelWorld::DestroyBlockAt(FVector BlockWorldLocation)
@@ -450,6 +1381,8 @@ void AVoxelWorld::DestroyBlockAt(FVector BlockWorldLocation)
 	 * In multiplayer, this function should be multicasted.
 	 */
 	
+	JournalEdit(BlockWorldLocation, FVoxel());
+	
 	//Check if the chunk affected by the edit is loaded
 	const auto AffectedChunkLocation = FloorVector((BlockWorldLocation - this->GetActorLocation())/(DefaultVoxelSize*ChunkSize*this->GetActorScale().X) );
 	
@@ -457,8 +1390,16 @@ void AVoxelWorld::DestroyBlockAt(FVector BlockWorldLocation)
 	{
 		ChunkPtr->DestroyBlockAt(BlockWorldLocation); 
 	}
+	else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(AffectedChunkLocation))
+	{
+		MakeChunkDataWritable(*DataOnlyChunkData);
+		(*DataOnlyChunkData)->RemoveVoxel(FloorVector((BlockWorldLocation-this->GetActorLocation())/DefaultVoxelSize) - AffectedChunkLocation*ChunkSize);
+	}
 	else
 	{
+		//The copy kept since the chunk was unloaded doesn't have the edit
+		UnloadedChunks.Invalidate(AffectedChunkLocation);
+		
 		const auto RegionDataPtr = GetRegionSavedData(GetRegionOfChunk(AffectedChunkLocation));
 		
 		//compute the block's location in the chunk
@@ -468,18 +1409,17 @@ void AVoxelWorld::DestroyBlockAt(FVector BlockWorldLocation)
 		if (RegionDataPtr)
 		{
 			
-			if (LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)].Contains(AffectedChunkLocation))
+			if (const auto ChunkSavedData = FindChunkSavedData(AffectedChunkLocation))
 			{
 				//GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Yellow, TEXT("Destroying block by editing saved data on an existing chunk"));	
-				LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)][AffectedChunkLocation].RemoveVoxel(BlockLocationInChunk);
+				ChunkSavedData->RemoveVoxel(BlockLocationInChunk);
 			}
 			else
 			{
 				
 				//Create additive data to account for the voxel removal
-				FChunkData AdditiveChunkData = FChunkData::EmptyChunkData(false);
+				FChunkData AdditiveChunkData = FChunkData::SparseAdditiveChunkData();
 				AdditiveChunkData.SetVoxel(BlockLocationInChunk, FVoxel());
-				AdditiveChunkData.IsAdditive = true;
 				UE_LOG(LogTemp, Display, TEXT("IsAdditive variable is set to %hs on chunk data"), AdditiveChunkData.IsAdditive ? "True" : "False")
 				//Add the data to the region, which is guaranteed to be currently loaded since we called GetRegionSavedData earlier in the function
 				RegionDataPtr->Add(AffectedChunkLocation, AdditiveChunkData);
@@ -491,15 +1431,14 @@ void AVoxelWorld::DestroyBlockAt(FVector BlockWorldLocation)
 		{
 
 			//Create additive data to account for the voxel removal
-			FChunkData AdditiveChunkData = FChunkData::EmptyChunkData(false);
+			FChunkData AdditiveChunkData = FChunkData::SparseAdditiveChunkData();
 			AdditiveChunkData.SetVoxel(BlockLocationInChunk, FVoxel());
-			AdditiveChunkData.IsAdditive = true;
 			UE_LOG(LogTemp, Display, TEXT("IsAdditive variable is set to %hs on chunk data"), AdditiveChunkData.IsAdditive ? "True" : "False")
 
 			//Define the new region and add it to loaded regions so that it may be saved on world saving
 			auto NewRegion =  TMap<FIntVector, FChunkData>();
 			NewRegion.Add(AffectedChunkLocation, AdditiveChunkData);
-			LoadedRegions.Add(GetRegionOfChunk(AffectedChunkLocation), NewRegion);
+			LoadedRegions.FindOrAdd(GetRegionOfChunk(AffectedChunkLocation)).Append(NewRegion);
 			UE_LOG(LogTemp, Display, TEXT("IsAdditive variable is set to %hs in region data"), NewRegion[AffectedChunkLocation].IsAdditive ? "True" : "False")
 		}
 	}
@@ -513,6 +1452,8 @@ void AVoxelWorld::SetBlockAt(FVector BlockWorldLocation, FVoxel Block)
 	 * In multiplayer, this function should be multicasted.
 	 */
 	
+	JournalEdit(BlockWorldLocation, Block);
+	
 	//Check if the chunk affected by the edit is loaded
 	const auto AffectedChunkLocation = FloorVector((BlockWorldLocation - this->GetActorLocation())/(DefaultVoxelSize*ChunkSize*this->GetActorScale().X));
 	
@@ -520,8 +1461,16 @@ void AVoxelWorld::SetBlockAt(FVector BlockWorldLocation, FVoxel Block)
 	{
 		ChunkPtr->SetBlockAt(BlockWorldLocation, Block); 
 	}
+	else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(AffectedChunkLocation))
+	{
+		MakeChunkDataWritable(*DataOnlyChunkData);
+		(*DataOnlyChunkData)->SetVoxel(FloorVector((BlockWorldLocation-this->GetActorLocation())/DefaultVoxelSize) - AffectedChunkLocation*ChunkSize, Block);
+	}
 	else
 	{
+		//The copy kept since the chunk was unloaded doesn't have the edit
+		UnloadedChunks.Invalidate(AffectedChunkLocation);
+
 		const auto RegionDataPtr = GetRegionSavedData(GetRegionOfChunk(AffectedChunkLocation));
 
 		const auto BlockLocationInChunk = FloorVector((BlockWorldLocation-this->GetActorLocation())/DefaultVoxelSize) - AffectedChunkLocation*ChunkSize;
@@ -530,16 +1479,15 @@ void AVoxelWorld::SetBlockAt(FVector BlockWorldLocation, FVoxel Block)
 		if (RegionDataPtr)
 		{
 			
-			if (LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)].Contains(AffectedChunkLocation))
+			if (const auto ChunkSavedData = FindChunkSavedData(AffectedChunkLocation))
 			{
-				LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)][AffectedChunkLocation].SetVoxel(BlockLocationInChunk, Block);
+				ChunkSavedData->SetVoxel(BlockLocationInChunk, Block);
 			}
 			else
 			{
 
 				//Create additive data to account for the voxel removal
-				FChunkData AdditiveChunkData = FChunkData::EmptyChunkData(false);
-				AdditiveChunkData.IsAdditive = true;
+				FChunkData AdditiveChunkData = FChunkData::SparseAdditiveChunkData();
 				AdditiveChunkData.SetVoxel(BlockLocationInChunk, Block);
 				
 				//Add the data to the region, which is guaranteed to be currently loaded since we called GetRegionSavedData earlier in the function
@@ -550,15 +1498,14 @@ void AVoxelWorld::SetBlockAt(FVector BlockWorldLocation, FVoxel Block)
 		{
 			
 			//Create additive data to account for the voxel removal
-			FChunkData AdditiveChunkData = FChunkData::EmptyChunkData(false);
+			FChunkData AdditiveChunkData = FChunkData::SparseAdditiveChunkData();
 			
-			AdditiveChunkData.IsAdditive = true;
 			AdditiveChunkData.SetVoxel(BlockLocationInChunk, Block);
 			
 			//Define the new region and add it to loaded regions so that it may be saved on world saving
 			auto NewRegion =  TMap<FIntVector, FChunkData>();
 			NewRegion.Add(AffectedChunkLocation, AdditiveChunkData);
-			LoadedRegions.Add(GetRegionOfChunk(AffectedChunkLocation), NewRegion);
+			LoadedRegions.FindOrAdd(GetRegionOfChunk(AffectedChunkLocation)).Append(NewRegion);
 			
 		}
 	}
@@ -574,18 +1521,40 @@ FVoxel AVoxelWorld::GetBlockAt(FVector BlockWorldLocation)
 	{
 		return ChunkPtr->GetBlockAt(BlockWorldLocation); 
 	}
+	else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(AffectedChunkLocation))
+	{
+		return (*DataOnlyChunkData)->GetVoxelAt(FloorVector((BlockWorldLocation-this->GetActorLocation())/DefaultVoxelSize) - AffectedChunkLocation*ChunkSize);
+	}
 	else
 	{
 		const auto RegionDataPtr = GetRegionSavedData(GetRegionOfChunk(AffectedChunkLocation));
 
 		const auto BlockLocationInChunk = FloorVector((BlockWorldLocation-this->GetActorLocation())/DefaultVoxelSize) - AffectedChunkLocation*ChunkSize;
+
+		//Chunks that were not saved whole are read from the world pack with their saved edits on top, as they are when they are loaded
+		const auto ChunkSavedData = RegionDataPtr ? FindChunkSavedData(AffectedChunkLocation) : nullptr;
+		if ((!ChunkSavedData || ChunkSavedData->IsAdditive) && IsInBaseWorldPack(AffectedChunkLocation))
+		{
+			if (const auto CachedChunkData = UnloadedChunks.FindChunkData(AffectedChunkLocation))
+			{
+				return CachedChunkData->GetVoxelAt(BlockLocationInChunk);
+			}
+
+			//The chunk is kept in the cache of unloaded chunks, so that the next queries and its next load don't decode it again. Edits made to it invalidate it
+			const auto PackChunkData = ResolveWorldPackChunk(AffectedChunkLocation, GetWorldGenerator(), *BaseWorldPackFile, ChunkSavedData);
+			if (UnloadedChunkCacheBudgetMB > 0)
+			{
+				UnloadedChunks.Add(AffectedChunkLocation, PackChunkData, nullptr, false);
+			}
+			return PackChunkData->GetVoxelAt(BlockLocationInChunk);
+		}
 		
 		if (RegionDataPtr)
 		{
 			
-			if (LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)].Contains(AffectedChunkLocation))
+			if (ChunkSavedData)
 			{
-				return LoadedRegions[GetRegionOfChunk(AffectedChunkLocation)][AffectedChunkLocation].GetVoxelAt(BlockLocationInChunk);
+				return ChunkSavedData->GetVoxelAt(BlockLocationInChunk);
 			}
 			else
 			{
@@ -609,18 +1578,11 @@ void AVoxelWorld::AddManagedPlayer(APlayerController* PlayerToAdd)
 
 	if (NetworkMode !=  EVoxelWorldNetworkMode::ClientOnly && HasAuthority())
 	{
-		FVoxelWorldManagedPlayerData CurrentPlayerData;
-		if (WorldGenerationThreads.Num() == 0)
+		//On a server every player shares the same pool of threads, orders are balanced between them by the scheduler
+		if (GenerationScheduler.GetNumberOfThreads() == 0)
 		{
-			ServerThreadsSetup(1);
+			ServerThreadsSetup();
 		}
-		CurrentPlayerData.PlayerWorldGenerationThread = WorldGenerationThreads[CurrentGenerationThreadIndex];
-		CurrentPlayerData.ChunkGenerationOrdersQueuePtr = CurrentPlayerData.PlayerWorldGenerationThread->GetGenerationOrdersQueue();
-
-		//Separating chunk insides and sides generation into different threads might get rid of some stutters
-		CurrentPlayerData.PlayerChunkSidesGenerationThread = CurrentPlayerData.PlayerWorldGenerationThread;
-		CurrentPlayerData.ChunkSidesMeshingOrdersQueuePtr = CurrentPlayerData.PlayerChunkSidesGenerationThread->GetGenerationOrdersQueue();
-		
 
 		/*if (NetworkMode == EVoxelWorldNetworkMode::ServerSendsFullGeometry)
 		{
@@ -629,32 +1591,22 @@ void AVoxelWorld::AddManagedPlayer(APlayerController* PlayerToAdd)
 			PlayerDataStreamer->OwningPlayerController = PlayerToAdd;
 			CurrentPlayerData.PlayerDataStreamer = PlayerDataStreamer;
 		}*/
-
-		ManagedPlayerDataMap.Add(PlayerToAdd, CurrentPlayerData);
-		CurrentGenerationThreadIndex = CurrentGenerationThreadIndex + 1 % NumberOfWorldGenerationThreads;
-		UE_LOG(LogTemp, Display, TEXT("Finished adding managed player"));
 	}
 	else
 	{
-		
-		const auto CurrentPlayerWorldGenerationRunnable = new FVoxelWorldGenerationRunnable;
-	
-		FVoxelWorldManagedPlayerData CurrentPlayerData;
-		CurrentPlayerData.PlayerWorldGenerationThread = CurrentPlayerWorldGenerationRunnable;
-		CurrentPlayerData.ChunkGenerationOrdersQueuePtr = CurrentPlayerData.PlayerWorldGenerationThread->GetGenerationOrdersQueue();
-
-		//Separating chunk insides and sides generation into different threads might get rid of some stutters
-		const auto CurrentPlayerChunkSidesGenerationRunnable = new FVoxelWorldGenerationRunnable;
-		CurrentPlayerData.PlayerChunkSidesGenerationThread = CurrentPlayerChunkSidesGenerationRunnable;
-		CurrentPlayerData.ChunkSidesMeshingOrdersQueuePtr = CurrentPlayerData.PlayerChunkSidesGenerationThread->GetGenerationOrdersQueue();
-
-		ManagedPlayerDataMap.Add(PlayerToAdd, CurrentPlayerData);
+		//Separating chunk insides and sides generation into different threads might get rid of some stutters, so each local player brings two threads
+		GenerationScheduler.AddThreads(2);
 	}
 
+	FVoxelWorldManagedPlayerData CurrentPlayerData;
+	SetPlayerViewShells(CurrentPlayerData, ViewDistance, VerticalViewDistance);
+	ManagedPlayerDataMap.Add(PlayerToAdd, CurrentPlayerData);
+	UE_LOG(LogTemp, Display, TEXT("Finished adding managed player"));
+
 	int32 PlayerIndex = 0;
 	while (PlayerIDs.FindKey(PlayerIndex))
 	{
-		PlayerIndex = PlayerIndex + 1 % 10000000;
+		PlayerIndex = (PlayerIndex + 1) % 10000000;
 	}
 	PlayerIDs.Add(PlayerToAdd, PlayerIndex);
 	
@@ -664,7 +1616,17 @@ FVoxel AVoxelWorld::DefaultGenerateBlockAt(FVector Position)
 {
 	//Default world generation function
 	
-	if ((Position.Z < 10000*FMath::PerlinNoise2D(FVector2d(Position.X, Position.Y)/10000 ) ) )
+	return DefaultGenerateBlockInColumn(Position, DefaultSurfaceHeight(FVector2D(Position.X, Position.Y)));
+}
+
+float AVoxelWorld::DefaultSurfaceHeight(FVector2D ColumnPosition)
+{
+	return 10000*FMath::PerlinNoise2D(ColumnPosition/10000);
+}
+
+FVoxel AVoxelWorld::DefaultGenerateBlockInColumn(FVector Position, float SurfaceHeight)
+{
+	if (Position.Z < SurfaceHeight)
 	{
 		FVoxel Temp;
 		Temp.VoxelType = "Stone";
@@ -693,18 +1655,107 @@ FVoxel AVoxelWorld::DefaultGenerateBlockAt(FVector Position)
 
 
 
-void AVoxelWorld::CreateChunkAt(FIntVector ChunkLocation,
-                                TQueue<FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* OrdersQueuePtr)
-{
-	if (!ChunkStates.Contains( ChunkLocation ))
+bool AVoxelWorld::DefaultClassifyUniformChunk(FIntVector ChunkLocation, const FVoxelChunkColumn* Column, FVoxel& OutVoxel)
+{
+	/*Voxels are stone below the surface of their column, and water below -2500 or air above it
+	 *A chunk entirely below the lowest surface of its column is stone, one entirely above the highest surface is water or air if it is entirely on one side of the water level
+	 */
+	if (!Column)
+	{
+		return false;
+	}
+
+	const FVector Bottom = FVoxelWorldGenerator::GetVoxelPosition(ChunkLocation, 0, 0, 0);
+	const FVector Top = FVoxelWorldGenerator::GetVoxelPosition(ChunkLocation, 0, 0, ChunkSize - 1);
+	if (Top.Z < Column->MinValue)
+	{
+		OutVoxel = DefaultGenerateBlockInColumn(Top, Column->MinValue);
+		return true;
+	}
+	if (Bottom.Z >= Column->MaxValue && (Top.Z < -2500 || Bottom.Z >= -2500))
+	{
+		OutVoxel = DefaultGenerateBlockInColumn(Top, Column->MaxValue);
+		return true;
+	}
+	return false;
+}
+
+
+void AVoxelWorld::CreateChunkAt(FIntVector ChunkLocation, EChunkLoadingLevel Level)
+{
+	//The region stays needed for the chunk's edits to be saved, so the cache is only used once it is in memory
+	if (UnloadedChunkCacheBudgetMB > 0 && !ChunkStates.Contains(ChunkLocation) && IsRegionInMemory(GetRegionOfChunk(ChunkLocation)))
+	{
+		FUnloadedChunk UnloadedChunk;
+		if (UnloadedChunks.Take(ChunkLocation, UnloadedChunk))
+		{
+			RequestUnloadedChunk(ChunkLocation, Level, UnloadedChunk);
+			return;
+		}
+	}
+
+	if (const auto ChunkState = ChunkStates.Find(ChunkLocation))
+	{
+		//A chunk still waiting for its region is created at the highest level it was requested at once the region arrives
+		if (*ChunkState == EChunkState::PendingRegion)
+		{
+			WaitForRegion(ChunkLocation, Level);
+			return;
+		}
+
+		//A chunk whose generation is still in flight is kept instead of being dropped on arrival
+		if (*ChunkState == EChunkState::Unloading)
+		{
+			*ChunkState = EChunkState::Loading;
+		}
+
+		//A chunk that was only loaded as data gets its actor and mesh when a mesh is requested
+		if (Level == EChunkLoadingLevel::FullMesh)
+		{
+			if (const auto MeshRequested = DataOnlyOrdersInFlight.Find(ChunkLocation))
+			{
+				*MeshRequested = true;
+			}
+			else if (const auto DataOnlyChunkData = DataOnlyChunks.Find(ChunkLocation))
+			{
+				const TSharedPtr<FChunkData> ChunkDataPtr = *DataOnlyChunkData;
+				DataOnlyChunks.Remove(ChunkLocation);
+				*ChunkState = EChunkState::Loading;
+				RequestChunkMeshing(ChunkLocation, ChunkDataPtr);
+			}
+		}
+	}
+	else if (!IsRegionInMemory(GetRegionOfChunk(ChunkLocation)))
+	{
+		WaitForRegion(ChunkLocation, Level);
+	}
+	else if (Level == EChunkLoadingLevel::DataOnly)
+	{
+		RequestChunkDataOnly(ChunkLocation);
+	}
+	else
 	{
 				
 		ChunkStates.Add(ChunkLocation, EChunkState::Loading);
+		ChunkPipeline.OnChunkRequested(ChunkLocation, IsInFrontOfNearestAnchor(ChunkLocation));
 		if (const auto RegionSavedData = GetRegionSavedData(GetRegionOfChunk(ChunkLocation) ))
 		{
-			if (const auto ChunkSavedData = RegionSavedData->Find(ChunkLocation))
+			if (const auto ChunkSavedData = FindChunkSavedData(ChunkLocation))
 			{
-				const TSharedPtr<FChunkData> ChunkVoxelDataPtr(ChunkSavedData);
+				const TSharedPtr<FChunkData> ChunkVoxelDataPtr = MakeShared<FChunkData>(*ChunkSavedData);
+
+				//Edits saved on top of a chunk of the world pack are applied to the pack's chunk instead of the generated one
+				if (ChunkVoxelDataPtr->IsAdditive && IsInBaseWorldPack(ChunkLocation))
+				{
+					RequestWorldPackChunk(ChunkLocation, ChunkVoxelDataPtr, true);
+					return;
+				}
+
+				if (!ChunkVoxelDataPtr->IsAdditive && LoadUniformChunkWithoutMeshing(ChunkLocation, ChunkVoxelDataPtr))
+				{
+					return;
+				}
+
 				auto ChunkGenerationOrder = FChunkThreadedWorkOrderBase();
 							
 				ChunkGenerationOrder.TargetChunkDataPtr = ChunkVoxelDataPtr;
@@ -715,40 +1766,143 @@ void AVoxelWorld::CreateChunkAt(FIntVector ChunkLocation,
 				if (ChunkVoxelDataPtr->IsAdditive)
 				{
 					ChunkGenerationOrder.OrderType = EChunkThreadedWorkOrderType::GeneratingAndMeshingWithAdditiveData;
-					ChunkGenerationOrder.GenerationFunction = WorldGenerationFunction;
+					ChunkGenerationOrder.Generator = GetWorldGenerator();
 				}
 				else
 				{
 					ChunkGenerationOrder.OrderType = EChunkThreadedWorkOrderType::MeshingFromData;
+					ChunkGenerationOrder.MeshCacheFile = FindMeshCacheFile(GetRegionOfChunk(ChunkLocation), false);
 				}
 							
-				OrdersQueuePtr->Enqueue(ChunkGenerationOrder);
+				GenerationScheduler.EnqueueOrder(ChunkGenerationOrder);
 
 			}
+			else if (IsInBaseWorldPack(ChunkLocation))
+			{
+				RequestWorldPackChunk(ChunkLocation, nullptr, true);
+			}
 			else
 			{
 				auto ChunkGenerationOrder = FChunkThreadedWorkOrderBase();
 		
-				ChunkGenerationOrder.GenerationFunction = WorldGenerationFunction;
+				ChunkGenerationOrder.Generator = GetWorldGenerator();
 				ChunkGenerationOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
 				ChunkGenerationOrder.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
 				ChunkGenerationOrder.ChunkLocation = ChunkLocation;
 				ChunkGenerationOrder.OrderType = EChunkThreadedWorkOrderType::GenerationAndMeshing;
-				OrdersQueuePtr->Enqueue(ChunkGenerationOrder);
+				GenerationScheduler.EnqueueOrder(ChunkGenerationOrder);
 			}
 		}
+		else if (IsInBaseWorldPack(ChunkLocation))
+		{
+			RequestWorldPackChunk(ChunkLocation, nullptr, true);
+		}
 		else
 		{
 			auto ChunkGenerationOrder = FChunkThreadedWorkOrderBase();
 					
-			ChunkGenerationOrder.GenerationFunction = WorldGenerationFunction;
+			ChunkGenerationOrder.Generator = GetWorldGenerator();
 			ChunkGenerationOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
 			ChunkGenerationOrder.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
 			ChunkGenerationOrder.ChunkLocation = ChunkLocation;
 			ChunkGenerationOrder.OrderType = EChunkThreadedWorkOrderType::GenerationAndMeshing;
-			OrdersQueuePtr->Enqueue(ChunkGenerationOrder);
+			GenerationScheduler.EnqueueOrder(ChunkGenerationOrder);
+		}
+	}
+}
+
+void AVoxelWorld::RequestChunkMeshing(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkDataPtr)
+{
+	/*Mesh a chunk whose data is already in memory, its actor is spawned when the order comes back*/
+	ChunkPipeline.OnChunkRequested(ChunkLocation, IsInFrontOfNearestAnchor(ChunkLocation));
+
+	if (LoadUniformChunkWithoutMeshing(ChunkLocation, ChunkDataPtr))
+	{
+		return;
+	}
+
+	auto ChunkMeshingOrder = FChunkThreadedWorkOrderBase();
+	ChunkMeshingOrder.TargetChunkDataPtr = ChunkDataPtr;
+	ChunkMeshingOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
+	ChunkMeshingOrder.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
+	ChunkMeshingOrder.ChunkLocation = ChunkLocation;
+	ChunkMeshingOrder.OrderType = EChunkThreadedWorkOrderType::MeshingFromData;
+	ChunkMeshingOrder.MeshCacheFile = FindMeshCacheFile(GetRegionOfChunk(ChunkLocation), false);
+	GenerationScheduler.EnqueueOrder(ChunkMeshingOrder);
+}
+
+void AVoxelWorld::RequestSideMeshing(FIntVector ChunkLocation, int32 DirectionIndex, TSharedPtr<FChunkData> ChunkDataPtr, TSharedPtr<FChunkData> NeighbourChunkDataPtr)
+{
+	/*A side that can't have any face is marked as meshed right away instead of taking a worker thread*/
+	if (HasNoSideFaces(*ChunkDataPtr, *NeighbourChunkDataPtr))
+	{
+		auto SideGeometry = MakeShared<FChunkGeometry>();
+		SideGeometry->ChunkLocation = ChunkLocation;
+		SideGeometry->DirectionIndex = DirectionIndex;
+		ChunkQuadsToLoad.Enqueue(SideGeometry);
+		return;
+	}
+
+	auto ChunkSidesGenerationOrder = FChunkThreadedWorkOrderBase();
+	ChunkSidesGenerationOrder.ChunkLocation = ChunkLocation;
+	ChunkSidesGenerationOrder.DirectionIndex = DirectionIndex;
+	ChunkSidesGenerationOrder.GeneratedChunkGeometryToLoadQueuePtr = &ChunkQuadsToLoad;
+	ChunkSidesGenerationOrder.TargetChunkDataPtr = ChunkDataPtr;
+	ChunkSidesGenerationOrder.NeighboringChunkDataPtr = NeighbourChunkDataPtr;
+	ChunkSidesGenerationOrder.OrderType = EChunkThreadedWorkOrderType::GeneratingExistingChunksSides;
+	GenerationScheduler.EnqueueOrder(ChunkSidesGenerationOrder);
+}
+
+bool AVoxelWorld::LoadUniformChunkWithoutMeshing(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkDataPtr)
+{
+	FVoxel UniformVoxel;
+	if (!ChunkDataPtr.IsValid() || !ChunkDataPtr->IsUniform(UniformVoxel))
+	{
+		return false;
+	}
+
+	auto InsideGeometry = MakeShared<FChunkGeometry>();
+	InsideGeometry->ChunkLocation = ChunkLocation;
+	InsideGeometry->DirectionIndex = -1;
+	ChunkQuadsToLoad.Enqueue(InsideGeometry);
+	GeneratedChunksToLoadInGame.Enqueue(MakeTuple(ChunkLocation, ChunkDataPtr));
+	return true;
+}
+
+void AVoxelWorld::RequestChunkDataOnly(FIntVector ChunkLocation)
+{
+	/*Load the voxel data of a chunk without spawning its actor nor meshing it
+	 *Saved chunks are available right away, the others are decoded from the world pack or generated on the generation threads
+	 */
+	TSharedPtr<FChunkData> AdditiveChunkDataPtr;
+
+	if (const auto ChunkSavedData = FindChunkSavedData(ChunkLocation))
+	{
+		if (!ChunkSavedData->IsAdditive)
+		{
+			DataOnlyChunks.Add(ChunkLocation, MakeShared<FChunkData>(*ChunkSavedData));
+			ChunkStates.Add(ChunkLocation, EChunkState::Loaded);
+			return;
 		}
+		AdditiveChunkDataPtr = MakeShared<FChunkData>(*ChunkSavedData);
 	}
+
+	ChunkStates.Add(ChunkLocation, EChunkState::Loading);
+	DataOnlyOrdersInFlight.Add(ChunkLocation, false);
+
+	if (IsInBaseWorldPack(ChunkLocation))
+	{
+		RequestWorldPackChunk(ChunkLocation, AdditiveChunkDataPtr, false);
+		return;
+	}
+
+	auto ChunkGenerationOrder = FChunkThreadedWorkOrderBase();
+	ChunkGenerationOrder.Generator = GetWorldGenerator();
+	ChunkGenerationOrder.TargetChunkDataPtr = AdditiveChunkDataPtr;
+	ChunkGenerationOrder.OutputChunkDataQueuePtr = &GeneratedChunksToLoadInGame;
+	ChunkGenerationOrder.ChunkLocation = ChunkLocation;
+	ChunkGenerationOrder.OrderType = EChunkThreadedWorkOrderType::GenerationOnly;
+	GenerationScheduler.EnqueueOrder(ChunkGenerationOrder);
 }
 
 TObjectPtr<AChunk> AVoxelWorld::GetActorOfLoadedChunk(FIntVector ChunkLocation)
@@ -761,7 +1915,8 @@ TObjectPtr<AChunk> AVoxelWorld::GetActorOfLoadedChunk(FIntVector ChunkLocation)
 			{
 				return *ChunkActor;
 			}
-			else
+			//Data-only chunks are loaded without an actor
+			else if (!DataOnlyChunks.Contains(ChunkLocation))
 			{
 				UE_LOG(LogTemp, Error, TEXT("Some chunk was marked as loaded but had no corresponding actor"))
 			}
@@ -781,34 +1936,79 @@ FIntVector AVoxelWorld::GetRegionOfChunk(FIntVector ChunkCoordinates)
 	return FIntVector(RegionX, RegionY, RegionZ);
 }
 
-void AVoxelWorld::UpdatePlayerPositionsOnThreads()
+void AVoxelWorld::UpdateLoadingAnchors()
 {
+	/*Snapshot the position, velocity and view direction of every managed player*/
+	LoadingAnchors.Reset();
 	
-	if (!ManagedPlayerDataMap.IsEmpty())
+	for (const auto& CurrentPlayerThreadPair : ManagedPlayerDataMap)
 	{
-		PlayerPositionsUpdateOnThreadsMutex.Lock();
-		
-		for (const auto CurrentPlayerThreadPair : ManagedPlayerDataMap)
+		//TODO: Find out why player controller is sometimes not valid
+		if (IsValid(CurrentPlayerThreadPair.Key) && CurrentPlayerThreadPair.Key->GetPawn())
 		{
-			//TODO: Find out why player controller is sometimes not valid
-			if (IsValid(CurrentPlayerThreadPair.Key))
-			{
-				if (const auto PlayerIDPtr = PlayerIDs.Find(CurrentPlayerThreadPair.Key))
-				{
-					FVector PlayerPosition = CurrentPlayerThreadPair.Key->GetPawn()->GetActorLocation();
-					const auto LoadingOrigin = FloorVector(this->GetActorRotation().GetInverse().RotateVector((PlayerPosition - this->GetActorLocation())/(ChunkSize*DefaultVoxelSize*this->GetActorScale().X)));
-					CurrentPlayerThreadPair.Value.PlayerWorldGenerationThread->ManagedPlayersPositionsMap.Add( *PlayerIDPtr, LoadingOrigin);
-				}
-				
-			}
-			
+			LoadingAnchors.Add(GetPlayerLoadingAnchor(CurrentPlayerThreadPair.Key));
 		}
-		
-		PlayerPositionsUpdateOnThreadsMutex.Unlock();
+	}
+
+	//Tickets are anchors without velocity nor view direction, scaled by their priority
+	for (const auto& TicketPair : LoadingTickets)
+	{
+		const auto& Ticket = TicketPair.Value;
 
+		FChunkLoadingAnchor TicketAnchor;
+		TicketAnchor.Position = this->GetActorRotation().GetInverse().RotateVector((Ticket.AnchorLocation - this->GetActorLocation())/(ChunkSize*DefaultVoxelSize*this->GetActorScale().X));
+		TicketAnchor.PriorityScale = Ticket.Priority;
+		LoadingAnchors.Add(TicketAnchor);
 	}
-	
 
+	//Every thread knows every player, so that orders shared by several players are prioritized for the nearest one
+	if (!LoadingAnchors.IsEmpty())
+	{
+		GenerationScheduler.UpdateLoadingAnchors(LoadingAnchors);
+	}
+}
+
+FIntVector AVoxelWorld::GetPlayerLoadingOrigin(APlayerController* Player) const
+{
+	/*Get the chunk in which the player's pawn is, in the coordinates of the voxel world*/
+	return GetLoadingOriginOfLocation(Player->GetPawn()->GetActorLocation());
+}
+
+FIntVector AVoxelWorld::GetLoadingOriginOfLocation(FVector WorldLocation) const
+{
+	return FloorVector(this->GetActorRotation().GetInverse().RotateVector((WorldLocation - this->GetActorLocation())/(ChunkSize*DefaultVoxelSize*this->GetActorScale().X)));
+}
+
+FChunkLoadingAnchor AVoxelWorld::GetPlayerLoadingAnchor(APlayerController* Player) const
+{
+	/*Express the pawn's movement and the camera direction in chunk units, in the coordinates of the voxel world*/
+	const FRotator InverseWorldRotation = this->GetActorRotation().GetInverse();
+	const double ChunkWorldSize = ChunkSize*DefaultVoxelSize*this->GetActorScale().X;
+	const APawn* Pawn = Player->GetPawn();
+
+	FChunkLoadingAnchor Result;
+	Result.Position = InverseWorldRotation.RotateVector((Pawn->GetActorLocation() - this->GetActorLocation())/ChunkWorldSize);
+	Result.Velocity = InverseWorldRotation.RotateVector(Pawn->GetVelocity()/ChunkWorldSize);
+	Result.Forward = InverseWorldRotation.RotateVector(Player->GetControlRotation().Vector());
+	Result.LookaheadTime = PrefetchLookaheadTime;
+	Result.ViewDirectionWeight = ViewDirectionPriorityWeight;
+	return Result;
+}
+
+bool AVoxelWorld::IsInFrontOfNearestAnchor(FIntVector ChunkLocation) const
+{
+	const FChunkLoadingAnchor* NearestAnchor = nullptr;
+	double MinimumSquaredDistance = 0;
+	for (const auto& Anchor : LoadingAnchors)
+	{
+		const double SquaredDistance = FVector::DistSquared(Anchor.Position, FVector(ChunkLocation));
+		if (!NearestAnchor || SquaredDistance < MinimumSquaredDistance)
+		{
+			NearestAnchor = &Anchor;
+			MinimumSquaredDistance = SquaredDistance;
+		}
+	}
+	return NearestAnchor && FChunkLoadingPriority::IsInFront(*NearestAnchor, ChunkLocation);
 }
 
 int32 AVoxelWorld::DistanceToNearestPlayer(FIntVector ChunkLocation)
@@ -863,25 +2063,227 @@ FString AVoxelWorld::GetRegionName(FIntVector RegionLocation)
 	return RegionCoordinates;
 }
 
-void AVoxelWorld::ServerThreadsSetup(int32 NumberOfThreads)
+void AVoxelWorld::ServerThreadsSetup()
 {
-	NumberOfWorldGenerationThreads = NumberOfThreads;
-	WorldGenerationThreads.SetNum(NumberOfWorldGenerationThreads);
-	for (int32 i = 0; i < NumberOfWorldGenerationThreads; i++)
+	int32 NumberOfThreads = NumberOfServerGenerationThreads;
+	if (NumberOfThreads <= 0)
 	{
-		WorldGenerationThreads[i] = new FVoxelWorldGenerationRunnable;
+		//Leave a core for the game thread and one for the render thread
+		NumberOfThreads = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 2);
 	}
-	CurrentGenerationThreadIndex = 0;
+	GenerationScheduler.AddThreads(NumberOfThreads);
 
 	ManagedPlayerDataMap = TMap<TObjectPtr<APlayerController>, FVoxelWorldManagedPlayerData>();
 }
 
 
+void AVoxelWorld::SetupChunkLoadingTables()
+{
+	/*Size the clipmaps from the view distances*/
+	EnsureClipmapExtent(ViewDistance + UnloadingHysteresis, VerticalViewDistance + UnloadingHysteresis);
+}
+
+void AVoxelWorld::EnsureClipmapExtent(int32 HorizontalDistance, int32 VerticalDistance)
+{
+	/*The clipmaps must fit every chunk kept around a player, they only grow so that a shrinking view distance doesn't rehash them*/
+	if (HorizontalDistance <= ClipmapHorizontalExtent && VerticalDistance <= ClipmapVerticalExtent)
+	{
+		return;
+	}
+
+	ClipmapHorizontalExtent = FMath::Max(ClipmapHorizontalExtent, HorizontalDistance);
+	ClipmapVerticalExtent = FMath::Max(ClipmapVerticalExtent, VerticalDistance);
+
+	ChunkStates.SetExtent(ClipmapHorizontalExtent, ClipmapVerticalExtent);
+	ChunkActorsMap.SetExtent(ClipmapHorizontalExtent, ClipmapVerticalExtent);
+	ChunkReferenceCounts.SetExtent(ClipmapHorizontalExtent, ClipmapVerticalExtent);
+	DataOnlyChunks.SetExtent(ClipmapHorizontalExtent, ClipmapVerticalExtent);
+}
+
+TSharedPtr<FChunkViewShells> AVoxelWorld::GetViewShells(int32 HorizontalDistance, int32 VerticalDistance)
+{
+	const auto Key = FIntPoint(HorizontalDistance, VerticalDistance);
+	if (const auto CachedShells = ViewShellsCache.Find(Key))
+	{
+		return *CachedShells;
+	}
+	return ViewShellsCache.Add(Key, MakeShared<FChunkViewShells>(HorizontalDistance, VerticalDistance));
+}
+
+void AVoxelWorld::SetPlayerViewShells(FVoxelWorldManagedPlayerData& PlayerData, int32 NewViewDistance, int32 NewVerticalViewDistance)
+{
+	/*Switch a player to new view distances
+	 *Around the unchanged loading origin, the chunks only in the new view are created nearest first and the chunks only in the old unloading distance are released to the unloading budget
+	 */
+	const auto NewViewShells = GetViewShells(NewViewDistance, NewVerticalViewDistance);
+	const auto NewRetainingShells = GetViewShells(NewViewDistance + UnloadingHysteresis, NewVerticalViewDistance + UnloadingHysteresis);
+
+	EnsureClipmapExtent(NewViewDistance + UnloadingHysteresis, NewVerticalViewDistance + UnloadingHysteresis);
+
+	if (PlayerData.HasLoadingOrigin)
+	{
+		const auto LoadingOrigin = PlayerData.LastLoadingOrigin;
+		TArray<FIntVector> ChangedChunks;
+
+		NewRetainingShells->GetChunksNotInView(*PlayerData.RetainingShells, LoadingOrigin, ChangedChunks);
+		for (const auto& Chunk : ChangedChunks)
+		{
+			AddChunkReference(Chunk);
+		}
+
+		ChangedChunks.Reset();
+		PlayerData.RetainingShells->GetChunksNotInView(*NewRetainingShells, LoadingOrigin, ChangedChunks);
+		for (const auto& Chunk : ChangedChunks)
+		{
+			RemoveChunkReference(Chunk);
+		}
+
+		ChangedChunks.Reset();
+		NewViewShells->GetChunksNotInView(*PlayerData.ViewShells, LoadingOrigin, ChangedChunks);
+		for (const auto& Chunk : ChangedChunks)
+		{
+			CreateChunkAt(Chunk);
+		}
+	}
+
+	PlayerData.ViewDistance = NewViewDistance;
+	PlayerData.VerticalViewDistance = NewVerticalViewDistance;
+	PlayerData.ViewShells = NewViewShells;
+	PlayerData.RetainingShells = NewRetainingShells;
+}
+
+void AVoxelWorld::SetViewDistance(int32 NewViewDistance, int32 NewVerticalViewDistance)
+{
+	ViewDistance = FMath::Max(1, NewViewDistance);
+	VerticalViewDistance = FMath::Max(1, NewVerticalViewDistance);
+
+	for (auto& PlayerDataPair : ManagedPlayerDataMap)
+	{
+		if (PlayerDataPair.Value.ViewDistance != ViewDistance || PlayerDataPair.Value.VerticalViewDistance != VerticalViewDistance)
+		{
+			SetPlayerViewShells(PlayerDataPair.Value, ViewDistance, VerticalViewDistance);
+		}
+	}
+}
+
+void AVoxelWorld::SetPlayerViewDistance(APlayerController* Player, int32 NewViewDistance, int32 NewVerticalViewDistance)
+{
+	if (const auto PlayerData = ManagedPlayerDataMap.Find(Player))
+	{
+		NewViewDistance = FMath::Max(1, NewViewDistance);
+		NewVerticalViewDistance = FMath::Max(1, NewVerticalViewDistance);
+		
+		if (PlayerData->ViewDistance != NewViewDistance || PlayerData->VerticalViewDistance != NewVerticalViewDistance)
+		{
+			SetPlayerViewShells(*PlayerData, NewViewDistance, NewVerticalViewDistance);
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Tried to change the view distance of a player that is not managed by the voxel world"))
+	}
+}
+
+void AVoxelWorld::UpdateViewDistanceGovernor(float DeltaTime)
+{
+	/*Moves the view distance of every player one chunk at a time from its own distance, and waits between changes so that the loading and unloading they cause can settle
+	 *A distance is only moved towards the range between MinimumViewDistance and MaximumViewDistance, a player given a distance outside of it keeps it in the other direction
+	 *The distance given to players that join moves along with them
+	 */
+	const float FrameTimeMs = 1000*DeltaTime;
+	SmoothedFrameTimeMs = SmoothedFrameTimeMs <= 0 ? FrameTimeMs : FMath::Lerp(SmoothedFrameTimeMs, FrameTimeMs, FrameTimeSmoothingFactor);
+	TimeSinceLastViewDistanceChange += DeltaTime;
+
+	if (!AutomaticViewDistance || TimeSinceLastViewDistanceChange < ViewDistanceChangeInterval)
+	{
+		return;
+	}
+
+	int32 Step = 0;
+	if (SmoothedFrameTimeMs > ViewDistanceDecreaseThreshold*TargetFrameTimeMs)
+	{
+		Step = -1;
+	}
+	else if (SmoothedFrameTimeMs < ViewDistanceIncreaseThreshold*TargetFrameTimeMs)
+	{
+		Step = 1;
+	}
+	else
+	{
+		return;
+	}
+
+	const auto CanStep = [this, Step](int32 Distance)
+	{
+		return Step < 0 ? Distance > MinimumViewDistance : Distance < MaximumViewDistance;
+	};
+
+	bool Changed = false;
+	for (auto& PlayerDataPair : ManagedPlayerDataMap)
+	{
+		auto& PlayerData = PlayerDataPair.Value;
+		if (CanStep(PlayerData.ViewDistance))
+		{
+			SetPlayerViewShells(PlayerData, PlayerData.ViewDistance + Step, PlayerData.VerticalViewDistance);
+			Changed = true;
+		}
+	}
+
+	if (CanStep(ViewDistance))
+	{
+		ViewDistance += Step;
+		Changed = true;
+	}
+
+	if (Changed)
+	{
+		TimeSinceLastViewDistanceChange = 0;
+	}
+}
+
 // Called when the game starts or when spawned
 void AVoxelWorld::BeginPlay()
 {
 	Super::BeginPlay();
+
+	SetupChunkLoadingTables();
+
+	RegionIORunnable = new FVoxelRegionIORunnable;
 	
+	LoadWorldSavedInfo();
+
+	if (!BaseWorldPack.IsEmpty())
+	{
+		BaseWorldPackFile = MakeShared<FVoxelWorldPack>();
+		if (!BaseWorldPackFile->Open(FVoxelWorldPack::GetPackFilePath(BaseWorldPack)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not open the world pack %s, the world is generated instead"), *BaseWorldPack)
+			BaseWorldPackFile.Reset();
+		}
+	}
+
+	if (ColumnCacheBudgetMB > 0)
+	{
+		ColumnCache = MakeShared<FVoxelColumnCache>(static_cast<int64>(ColumnCacheBudgetMB) << 20);
+	}
+
+	//Edits that were not saved before the game stopped are recovered from the journal
+	if (EditJournal.Open(FVoxelEditJournal::GetJournalDirectory(WorldName)))
+	{
+		ReplayEditJournal();
+	}
+
+	//If the game is single-player, the player around which the world is generated is automatically registered
+	//On a server, players must be added as they join
+	if (NetworkMode == EVoxelWorldNetworkMode::ClientOnly)
+	{
+		AddManagedPlayer(GetWorld()->GetFirstPlayerController());
+		
+	}
+}
+
+void AVoxelWorld::LoadWorldSavedInfo()
+{
 	//Creates the main world save file
 	 if (UGameplayStatics::DoesSaveGameExist(WorldName + "\\WorldSaveData", 0))
 	 {
@@ -898,42 +2300,48 @@ void AVoxelWorld::BeginPlay()
 	 {
 		WorldSavedInfo = Cast<UVoxelWorldGlobalDataSaveGame>(UGameplayStatics::CreateSaveGameObject(UVoxelWorldGlobalDataSaveGame::StaticClass()));
 	}
-
-	//If the game is single-player, the player around which the world is generated is automatically registered
-	//On a server, players must be added as they join
-	if (NetworkMode == EVoxelWorldNetworkMode::ClientOnly)
-	{
-		AddManagedPlayer(GetWorld()->GetFirstPlayerController());
-		
-	}
 }
 
 void AVoxelWorld::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 	
-	TSet<FVoxelWorldGenerationRunnable*> VoxelWorldGenerationRunnables;
+	GenerationScheduler.Shutdown();
 
-	for (const auto CurrentPair : ManagedPlayerDataMap )
+	for (auto& EncodingTaskFuture : UnloadedChunkEncodingTasks)
 	{
-		VoxelWorldGenerationRunnables.Add(CurrentPair.Value.PlayerWorldGenerationThread);
-		VoxelWorldGenerationRunnables.Add(CurrentPair.Value.PlayerChunkSidesGenerationThread);
+		EncodingTaskFuture.Wait();
 	}
-	
-	for (auto CurrentThread : VoxelWorldGenerationRunnables )
+	UnloadedChunkEncodingTasks.Empty();
+	UnloadedChunks.Empty();
+
+	FlushPendingSaves();
+
+	if (JournalFlushTask.IsValid())
 	{
-		
-		ThreadShutdownMutex.Lock();
-		CurrentThread->StartShutdown();
-		bool IsThreadValid = CurrentThread->Thread != nullptr;
-		ThreadShutdownMutex.Unlock();
-		
-		if (IsThreadValid)
+		JournalFlushTask.Wait();
+	}
+	EditJournal.Close();
+
+	if (RegionIORunnable)
+	{
+		RegionIORunnable->StartShutdown();
+		if (RegionIORunnable->Thread != nullptr)
 		{
-			CurrentThread->Thread->WaitForCompletion();
+			RegionIORunnable->Thread->WaitForCompletion();
+			delete RegionIORunnable->Thread;
 		}
-		
+		delete RegionIORunnable;
+		RegionIORunnable = nullptr;
 	}
+
+	RegionFiles.Empty();
+	MeshCacheFiles.Empty();
+	BaseWorldPackFile.Reset();
+
+	//Orders still in flight keep their own reference to the cache
+	ColumnCache.Reset();
+	ColumnReferenceCounts.Empty();
 }
 
 
@@ -942,21 +2350,79 @@ void AVoxelWorld::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	IterateSaveCompletion();
+
+	IterateEditJournal(DeltaTime);
+
 	if (IsEnabled)
 	{
-		UpdatePlayerPositionsOnThreads();
+		UpdateViewDistanceGovernor(DeltaTime);
+		
+		UpdateLoadingAnchors();
 	
 		IterateChunkCreationNearPlayers();
 
+		IterateChunkCreationNearTickets();
+
+		IterateRegionLoading();
+
 		IterateGeneratedChunkLoadingAndSidesGeneration();
 	
 		IterateChunkMeshing();
 	
 		IterateChunkUnloading();
+
+		IterateUnloadedChunkEncoding();
+
+		IterateChunkMeshWriting();
+
+		IterateRegionCacheEviction();
 	}
 	
 }
 
+FVoxelWorldGenerator AVoxelWorld::GetWorldGenerator() const
+{
+	/*A world that replaces WorldGenerationFunction without touching WorldGenerator keeps being generated with its own function*/
+	if (WorldGenerator.IsBatched() && (!WorldGenerator.VoxelFunction || WorldGenerator.VoxelFunction == WorldGenerationFunction))
+	{
+		FVoxelWorldGenerator Generator = WorldGenerator;
+		Generator.ColumnCache = ColumnCache;
+
+		//The default classification only holds for the default terrain, a world that replaces its column functions would get chunks of the wrong voxel
+		if (!Generator.UniformChunkFunction && !Generator.ChunkFunction && Generator.ColumnFunction == &DefaultSurfaceHeight && Generator.VoxelInColumnFunction == &DefaultGenerateBlockInColumn)
+		{
+			Generator.UniformChunkFunction = &DefaultClassifyUniformChunk;
+		}
+		return Generator;
+	}
+	return FVoxelWorldGenerator::FromVoxelFunction(WorldGenerationFunction);
+}
+
+void AVoxelWorld::LogChunkPipelineStats()
+{
+	ChunkPipeline.LogStats();
+	GenerationScheduler.LogStats();
+}
+
+void AVoxelWorld::LogRegionCacheStats()
+{
+	LoadedRegions.LogStats();
+}
+
+void AVoxelWorld::LogUnloadedChunkCacheStats()
+{
+	UnloadedChunks.LogStats();
+}
+
+void AVoxelWorld::LogColumnCacheStats()
+{
+	if (ColumnCache.IsValid())
+	{
+		ColumnCache->LogStats();
+	}
+}
+
 int32 AVoxelWorld::OneNorm(FIntVector Vector)
 {
 	return abs(Vector.X) + abs(Vector.Y) + abs(Vector.Z);
@@ -0,0 +1,425 @@
+﻿// .cpp
+#include "VoxelWorldBenchmarkCommandlet.h"
+#include "VoxelWorld.h"
+#include "Enums.h"
+#include "ChunkLoading/ChunkClipmap.h"
+#include "ChunkLoading/ChunkViewShells.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "SerializationAndNetworking/VoxelRegionCache.h"
+#include "ThreadedWorldGeneration/ChunkPipeline.h"
+#include "ThreadedWorldGeneration/VoxelColumnCache.h"
+#include "ThreadedWorldGeneration/VoxelNoise.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
+
+UVoxelWorldBenchmarkCommandlet::UVoxelWorldBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UVoxelWorldBenchmarkCommandlet::Main(const FString& Params)
+{
+	/*The benchmarks only read the class defaults of the world, no world is spawned*/
+	int32 NumberOfChunks = 256;
+	int32 NumberOfSamples = 1048576;
+	FParse::Value(*Params, TEXT("Chunks="), NumberOfChunks);
+	FParse::Value(*Params, TEXT("Samples="), NumberOfSamples);
+
+	bool RunCodec = FParse::Param(*Params, TEXT("Codec"));
+	bool RunStateStorage = FParse::Param(*Params, TEXT("StateStorage"));
+	bool RunGeneration = FParse::Param(*Params, TEXT("Generation"));
+	bool RunNoise = FParse::Param(*Params, TEXT("Noise"));
+	if (!RunCodec && !RunStateStorage && !RunGeneration && !RunNoise)
+	{
+		RunCodec = RunStateStorage = RunGeneration = RunNoise = true;
+	}
+
+	UClass* WorldClass = AVoxelWorld::StaticClass();
+	FString WorldClassPath;
+	if (FParse::Value(*Params, TEXT("WorldClass="), WorldClassPath))
+	{
+		WorldClass = LoadClass<AVoxelWorld>(nullptr, *WorldClassPath);
+		if (!WorldClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load the voxel world class %s"), *WorldClassPath)
+			return 1;
+		}
+	}
+	const AVoxelWorld* DefaultWorld = WorldClass->GetDefaultObject<AVoxelWorld>();
+
+	int32 Mismatches = 0;
+	if (RunCodec)
+	{
+		Mismatches += BenchmarkChunkCodec(DefaultWorld, NumberOfChunks);
+	}
+	if (RunStateStorage)
+	{
+		Mismatches += BenchmarkChunkStateStorage(DefaultWorld);
+	}
+	if (RunGeneration)
+	{
+		Mismatches += BenchmarkWorldGeneration(DefaultWorld, NumberOfChunks);
+	}
+	if (RunNoise)
+	{
+		Mismatches += BenchmarkNoise(NumberOfSamples);
+	}
+
+	if (Mismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Voxel world benchmark: %d mismatches"), Mismatches)
+		return 1;
+	}
+	return 0;
+}
+
+int32 UVoxelWorldBenchmarkCommandlet::BenchmarkChunkCodec(const AVoxelWorld* DefaultWorld, int32 NumberOfChunks)
+{
+	/*Every encoding is measured with every compression on the same chunks, the sizes are compared to the chunks' data in memory
+	 *Encodings that can't represent a chunk are skipped for that chunk, the automatic choice applies to all of them
+	 */
+	NumberOfChunks = FMath::Max(NumberOfChunks, 1);
+
+	const FVoxelWorldGenerator Generator = DefaultWorld->GetWorldGenerator();
+	TArray<TSharedPtr<FChunkData>> Chunks;
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		const auto ChunkLocation = FIntVector(i % 8 - 4, (i / 8) % 8 - 4, i / 64 - 2);
+		const auto ChunkDataPtr = MakeShared<FChunkData>();
+		Generator.GenerateChunk(ChunkLocation, *ChunkDataPtr);
+		Chunks.Add(ChunkDataPtr);
+	}
+
+	int64 InMemoryBytes = 0;
+	for (const auto& ChunkDataPtr : Chunks)
+	{
+		InMemoryBytes += FVoxelRegionCache::GetChunkDataBytes(*ChunkDataPtr);
+	}
+	const double InMemoryMegabytes = InMemoryBytes/(1024.0*1024.0);
+	UE_LOG(LogTemp, Display, TEXT("Chunk codec benchmark on %d chunks generated around the origin, %f MB in memory"), Chunks.Num(), InMemoryMegabytes)
+
+	int32 TotalMismatches = 0;
+
+	//The last encoding index stands for the automatic choice of FVoxelChunkCodec::Encode
+	constexpr int32 NumberOfEncodings = static_cast<int32>(EVoxelChunkEncoding::Num);
+	for (int32 CompressionIndex = 0; CompressionIndex < static_cast<int32>(EVoxelChunkCompression::Num); CompressionIndex++)
+	{
+		const auto Compression = static_cast<EVoxelChunkCompression>(CompressionIndex);
+		for (int32 EncodingIndex = 0; EncodingIndex <= NumberOfEncodings; EncodingIndex++)
+		{
+			const bool IsAutomatic = EncodingIndex == NumberOfEncodings;
+			const auto Encoding = static_cast<EVoxelChunkEncoding>(EncodingIndex);
+
+			TArray<TArray<uint8>> EncodedChunks;
+			EncodedChunks.SetNum(Chunks.Num());
+			TArray<bool> Encoded;
+			Encoded.Init(false, Chunks.Num());
+
+			int32 EncodingCounts[NumberOfEncodings] = {};
+			int32 NumberOfEncodedChunks = 0;
+			int64 EncodedBytes = 0;
+			int64 SourceBytes = 0;
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Chunks.Num(); i++)
+			{
+				Encoded[i] = IsAutomatic ? FVoxelChunkCodec::Encode(*Chunks[i], EncodedChunks[i], Compression) : FVoxelChunkCodec::EncodeAs(*Chunks[i], Encoding, EncodedChunks[i], Compression);
+			}
+			const double EncodeTime = FPlatformTime::Seconds() - StartTime;
+
+			for (int32 i = 0; i < Chunks.Num(); i++)
+			{
+				if (Encoded[i])
+				{
+					NumberOfEncodedChunks += 1;
+					EncodedBytes += EncodedChunks[i].Num();
+					SourceBytes += FVoxelRegionCache::GetChunkDataBytes(*Chunks[i]);
+					EncodingCounts[static_cast<int32>(FVoxelChunkCodec::GetEncoding(EncodedChunks[i]))] += 1;
+				}
+			}
+
+			if (NumberOfEncodedChunks == 0)
+			{
+				continue;
+			}
+
+			int32 Mismatches = 0;
+			FChunkData DecodedChunk;
+			StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Chunks.Num(); i++)
+			{
+				if (Encoded[i] && !FVoxelChunkCodec::Decode(EncodedChunks[i], DecodedChunk))
+				{
+					Mismatches += 1;
+				}
+			}
+			const double DecodeTime = FPlatformTime::Seconds() - StartTime;
+
+			//The round trip is checked outside of the timed loop
+			for (int32 i = 0; i < Chunks.Num() && IsAutomatic; i++)
+			{
+				if (FVoxelChunkCodec::Decode(EncodedChunks[i], DecodedChunk))
+				{
+					for (int32 VoxelIndex = 0; VoxelIndex < ChunkSize*ChunkSize*ChunkSize; VoxelIndex++)
+					{
+						const auto VoxelLocation = FIntVector(VoxelIndex/(ChunkSize*ChunkSize), (VoxelIndex/ChunkSize)%ChunkSize, VoxelIndex%ChunkSize);
+						if (!(DecodedChunk.GetVoxelAt(VoxelLocation) == Chunks[i]->GetVoxelAt(VoxelLocation)))
+						{
+							Mismatches += 1;
+							break;
+						}
+					}
+				}
+			}
+
+			const double SourceMegabytes = SourceBytes/(1024.0*1024.0);
+			const FString EncodingName = IsAutomatic ? FString::Printf(TEXT("Automatic (%d uniform, %d runs, %d packed, %d edits)"), EncodingCounts[0], EncodingCounts[1], EncodingCounts[2], EncodingCounts[3]) : FString(FVoxelChunkCodec::GetEncodingName(Encoding));
+			UE_LOG(LogTemp, Display, TEXT("Chunk codec %s + %s: %d chunks, %f KB, ratio %f, %f bytes per chunk, encode %f MB/s, decode %f MB/s"), *EncodingName, FVoxelChunkCodec::GetCompressionName(Compression), NumberOfEncodedChunks, EncodedBytes/1024.0, static_cast<double>(SourceBytes)/FMath::Max<int64>(EncodedBytes, 1), static_cast<double>(EncodedBytes)/NumberOfEncodedChunks, SourceMegabytes/FMath::Max(EncodeTime, 1e-9), SourceMegabytes/FMath::Max(DecodeTime, 1e-9))
+			if (Mismatches > 0)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Chunk codec %s + %s: %d chunks were not decoded back to their original voxels"), *EncodingName, FVoxelChunkCodec::GetCompressionName(Compression), Mismatches)
+			}
+			TotalMismatches += Mismatches;
+		}
+	}
+	return TotalMismatches;
+}
+
+int32 UVoxelWorldBenchmarkCommandlet::BenchmarkChunkStateStorage(const AVoxelWorld* DefaultWorld)
+{
+	/*Replays the lookups of a tick on both containers: a state check for every chunk in view and a probe of its six neighbours
+	 *A far away player is loaded first, so that every chunk in view of the origin collides with one of its chunks and goes to the fallback of the clipmap
+	 *The far away player then leaves, the chunks in view of the origin must have moved into their slots before the timed ticks. Both containers must agree on every lookup
+	 */
+	constexpr int32 NumberOfTicks = 20;
+
+	const FIntVector Origin = FIntVector(0,0,0);
+	const int32 ViewDistance = DefaultWorld->ViewDistance;
+	const int32 VerticalViewDistance = DefaultWorld->VerticalViewDistance;
+
+	//A multiple of every clipmap size up to 1024 chunks
+	const FIntVector FarOrigin = FIntVector(1024, 1024, 0);
+
+	TMap<FIntVector, EChunkState> HashMapStates;
+	TChunkClipmap<EChunkState> ClipmapStates;
+	ClipmapStates.SetExtent(ViewDistance + DefaultWorld->UnloadingHysteresis, VerticalViewDistance + DefaultWorld->UnloadingHysteresis);
+
+	const auto BenchmarkViewShells = MakeShared<FChunkViewShells>(ViewDistance, VerticalViewDistance);
+	for (const FIntVector& PlayerOrigin : {FarOrigin, Origin})
+	{
+		for (const auto& ViewLayer : BenchmarkViewShells->GetViewLayers())
+		{
+			for (const auto& Chunk : ViewLayer)
+			{
+				HashMapStates.Add(Chunk + PlayerOrigin, EChunkState::Loaded);
+				ClipmapStates.Add(Chunk + PlayerOrigin, EChunkState::Loaded);
+			}
+		}
+	}
+
+	auto SimulateTick = [BenchmarkViewShells, Origin](auto& States)
+	{
+		int32 NumberOfLoadedNeighbours = 0;
+		for (const auto& ViewLayer : BenchmarkViewShells->GetViewLayers())
+		{
+			for (const auto& Chunk : ViewLayer)
+			{
+				const auto State = States.Find(Chunk + Origin);
+				if (State && *State == EChunkState::Loaded)
+				{
+					for (int32 i = 0; i < 6; i++)
+					{
+						NumberOfLoadedNeighbours += States.Contains(Chunk + Origin + FChunkPipeline::Directions[i]) ? 1 : 0;
+					}
+				}
+			}
+		}
+		return NumberOfLoadedNeighbours;
+	};
+
+	int32 Mismatches = 0;
+	const int32 CollidingChunks = ClipmapStates.NumInFallback();
+	if (SimulateTick(HashMapStates) != SimulateTick(ClipmapStates))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Chunk state storage benchmark: the clipmap doesn't find the same chunks as the hash map while %d of them are in its fallback"), CollidingChunks)
+		Mismatches += 1;
+	}
+
+	for (const auto& ViewLayer : BenchmarkViewShells->GetViewLayers())
+	{
+		for (const auto& Chunk : ViewLayer)
+		{
+			HashMapStates.Remove(Chunk + FarOrigin);
+			ClipmapStates.Remove(Chunk + FarOrigin);
+		}
+	}
+	if (ClipmapStates.NumInFallback() > 0 || ClipmapStates.Num() != HashMapStates.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Chunk state storage benchmark: %d chunks were left in the fallback of the clipmap after the far away player left, the clipmap holds %d chunks instead of %d"), ClipmapStates.NumInFallback(), ClipmapStates.Num(), HashMapStates.Num())
+		Mismatches += 1;
+	}
+
+	int32 HashMapChecksum = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfTicks; i++)
+	{
+		HashMapChecksum += SimulateTick(HashMapStates);
+	}
+	const double HashMapTimePerTick = 1000*(FPlatformTime::Seconds() - StartTime)/NumberOfTicks;
+
+	int32 ClipmapChecksum = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfTicks; i++)
+	{
+		ClipmapChecksum += SimulateTick(ClipmapStates);
+	}
+	const double ClipmapTimePerTick = 1000*(FPlatformTime::Seconds() - StartTime)/NumberOfTicks;
+
+	UE_LOG(LogTemp, Display, TEXT("Chunk state storage benchmark on %d chunks: TMap %f ms per tick, clipmap %f ms per tick (%d in fallback, %d while the far away player was loaded), speedup %f, checksums %d %d"), HashMapStates.Num(), HashMapTimePerTick, ClipmapTimePerTick, ClipmapStates.NumInFallback(), CollidingChunks, ClipmapTimePerTick > 0 ? HashMapTimePerTick/ClipmapTimePerTick : 0, HashMapChecksum, ClipmapChecksum)
+	if (HashMapChecksum != ClipmapChecksum)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Chunk state storage benchmark: the checksums of the hash map and the clipmap differ"))
+		Mismatches += 1;
+	}
+	return Mismatches;
+}
+
+int32 UVoxelWorldBenchmarkCommandlet::BenchmarkWorldGeneration(const AVoxelWorld* DefaultWorld, int32 NumberOfChunks)
+{
+	/*Both generators fill the same chunks around the surface of the origin on the calling thread, the chunks must come out identical
+	 *Chunks are stacked by 64 around the origin, the batched generator gets a column cache of the world's budget so that the chunks above the first layer reuse its columns as in game
+	 */
+	NumberOfChunks = FMath::Max(NumberOfChunks, 1);
+	const FVoxelWorldGenerator PerVoxelGenerator = FVoxelWorldGenerator::FromVoxelFunction(DefaultWorld->WorldGenerationFunction);
+	FVoxelWorldGenerator BatchedGenerator = DefaultWorld->GetWorldGenerator();
+	if (BatchedGenerator.IsBatched() && DefaultWorld->ColumnCacheBudgetMB > 0)
+	{
+		BatchedGenerator.ColumnCache = MakeShared<FVoxelColumnCache>(static_cast<int64>(DefaultWorld->ColumnCacheBudgetMB) << 20);
+	}
+
+	TArray<FIntVector> ChunkLocations;
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		ChunkLocations.Add(FIntVector(i % 8 - 4, (i / 8) % 8 - 4, i / 64 - 2));
+	}
+
+	TArray<FChunkData> PerVoxelChunks;
+	PerVoxelChunks.SetNum(NumberOfChunks);
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		PerVoxelGenerator.GenerateChunk(ChunkLocations[i], PerVoxelChunks[i]);
+	}
+	const double PerVoxelTime = FPlatformTime::Seconds() - StartTime;
+
+	TArray<FChunkData> BatchedChunks;
+	BatchedChunks.SetNum(NumberOfChunks);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		BatchedGenerator.GenerateChunk(ChunkLocations[i], BatchedChunks[i]);
+	}
+	const double BatchedTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 Mismatches = 0;
+	int32 UniformChunks = 0;
+	for (int32 i = 0; i < NumberOfChunks; i++)
+	{
+		FVoxel UniformVoxel;
+		UniformChunks += BatchedChunks[i].IsUniform(UniformVoxel) ? 1 : 0;
+		for (int32 VoxelIndex = 0; VoxelIndex < ChunkSize*ChunkSize*ChunkSize; VoxelIndex++)
+		{
+			const FIntVector VoxelLocation(VoxelIndex/(ChunkSize*ChunkSize), (VoxelIndex/ChunkSize)%ChunkSize, VoxelIndex%ChunkSize);
+			const FVoxel PerVoxelVoxel = PerVoxelChunks[i].GetVoxelAt(VoxelLocation);
+			const FVoxel BatchedVoxel = BatchedChunks[i].GetVoxelAt(VoxelLocation);
+			if (PerVoxelVoxel != BatchedVoxel || PerVoxelVoxel.IsTransparent != BatchedVoxel.IsTransparent || PerVoxelVoxel.IsSolid != BatchedVoxel.IsSolid)
+			{
+				Mismatches++;
+				break;
+			}
+		}
+	}
+
+	if (BatchedGenerator.ColumnCache.IsValid())
+	{
+		BatchedGenerator.ColumnCache->LogStats();
+	}
+	UE_LOG(LogTemp, Display, TEXT("World generation benchmark on %d chunks, %d classified as uniform: per voxel %f ms per chunk, %s %f ms per chunk, speedup %f, %d chunks differ"), NumberOfChunks, UniformChunks, 1000*PerVoxelTime/NumberOfChunks, BatchedGenerator.ChunkFunction ? TEXT("whole chunk") : BatchedGenerator.IsBatched() ? TEXT("per column") : TEXT("per voxel (the world has no batched generator)"), 1000*BatchedTime/NumberOfChunks, BatchedTime > 0 ? PerVoxelTime/BatchedTime : 0, Mismatches)
+	if (Mismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("World generation benchmark: %d chunks of the generator differ from the per voxel function"), Mismatches)
+	}
+	return Mismatches;
+}
+
+int32 UVoxelWorldBenchmarkCommandlet::BenchmarkNoise(int32 NumberOfSamples)
+{
+	/*Every noise is evaluated on the same random coordinates by both paths, FMath::PerlinNoise2D that the default terrain uses is the baseline*/
+	NumberOfSamples = FMath::Max(NumberOfSamples, 4);
+
+	FRandomStream RandomStream(0);
+	TArray<float> X;
+	TArray<float> Y;
+	X.SetNumUninitialized(NumberOfSamples);
+	Y.SetNumUninitialized(NumberOfSamples);
+	for (int32 i = 0; i < NumberOfSamples; i++)
+	{
+		X[i] = RandomStream.FRandRange(-1000, 1000);
+		Y[i] = RandomStream.FRandRange(-1000, 1000);
+	}
+
+	float Checksum = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumberOfSamples; i++)
+	{
+		Checksum += FMath::PerlinNoise2D(FVector2D(X[i], Y[i]));
+	}
+	const double BaselineTime = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-9);
+	UE_LOG(LogTemp, Display, TEXT("Noise benchmark on %d samples: FMath::PerlinNoise2D %f Msamples/s (checksum %f)"), NumberOfSamples, NumberOfSamples/BaselineTime/1e6, Checksum)
+
+	TArray<TTuple<FString, FVoxelNoiseSettings>> Noises;
+	const TCHAR* TypeNames[] = {TEXT("Perlin"), TEXT("Simplex"), TEXT("Value"), TEXT("Cellular")};
+	for (int32 Type = 0; Type < 4; Type++)
+	{
+		FVoxelNoiseSettings Settings;
+		Settings.Type = static_cast<EVoxelNoiseType>(Type);
+		Settings.Frequency = 0.05f;
+		Noises.Add(MakeTuple(FString(TypeNames[Type]), Settings));
+	}
+	FVoxelNoiseSettings FBmSettings;
+	FBmSettings.Fractal = EVoxelNoiseFractal::FBm;
+	FBmSettings.Frequency = 0.05f;
+	FBmSettings.Octaves = 4;
+	Noises.Add(MakeTuple(FString(TEXT("Perlin FBm, 4 octaves")), FBmSettings));
+	FVoxelNoiseSettings RidgedSettings = FBmSettings;
+	RidgedSettings.Type = EVoxelNoiseType::Simplex;
+	RidgedSettings.Fractal = EVoxelNoiseFractal::Ridged;
+	Noises.Add(MakeTuple(FString(TEXT("Simplex ridged, 4 octaves")), RidgedSettings));
+
+	TArray<float> ScalarValues;
+	TArray<float> VectorValues;
+	ScalarValues.SetNumUninitialized(NumberOfSamples);
+	VectorValues.SetNumUninitialized(NumberOfSamples);
+	int32 Mismatches = 0;
+	for (const auto& Noise : Noises)
+	{
+		StartTime = FPlatformTime::Seconds();
+		FVoxelNoise::Evaluate2DScalar(Noise.Value, X.GetData(), Y.GetData(), ScalarValues.GetData(), NumberOfSamples);
+		const double ScalarTime = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-9);
+
+		StartTime = FPlatformTime::Seconds();
+		FVoxelNoise::Evaluate2D(Noise.Value, X.GetData(), Y.GetData(), VectorValues.GetData(), NumberOfSamples);
+		const double VectorTime = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-9);
+
+		const bool Identical = FMemory::Memcmp(ScalarValues.GetData(), VectorValues.GetData(), NumberOfSamples*sizeof(float)) == 0;
+		UE_LOG(LogTemp, Display, TEXT("%s: scalar %f Msamples/s, vector %f Msamples/s, speedup %f, %s"), *Noise.Key, NumberOfSamples/ScalarTime/1e6, NumberOfSamples/VectorTime/1e6, ScalarTime/VectorTime, Identical ? TEXT("bit-identical") : TEXT("PATHS DIFFER"))
+		if (!Identical)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Noise benchmark: the scalar and vector paths of %s give different values"), *Noise.Key)
+			Mismatches += 1;
+		}
+	}
+	return Mismatches;
+}
@@ -0,0 +1,82 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/VoxelWorldGenerationScheduler.h"
+#include "ThreadedWorldGeneration/FVoxelWorldGenerationRunnable.h"
+
+FVoxelWorldGenerationScheduler::~FVoxelWorldGenerationScheduler()
+{
+	Shutdown();
+}
+
+void FVoxelWorldGenerationScheduler::AddThreads(int32 NumberOfThreads)
+{
+	for (int32 i = 0; i < NumberOfThreads; i++)
+	{
+		GenerationThreads.Add(new FVoxelWorldGenerationRunnable);
+	}
+}
+
+int32 FVoxelWorldGenerationScheduler::GetNumberOfThreads() const
+{
+	return GenerationThreads.Num();
+}
+
+void FVoxelWorldGenerationScheduler::EnqueueOrder(const FChunkThreadedWorkOrderBase& Order)
+{
+	/*The live cost of a thread is the sum of the costs of the orders it has been given and not finished yet*/
+	if (GenerationThreads.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("A chunk order was issued before any generation thread was started"))
+		return;
+	}
+
+	FVoxelWorldGenerationRunnable* LeastLoadedThread = GenerationThreads[0];
+	int32 LowestPendingCost = LeastLoadedThread->GetPendingOrdersCost();
+
+	for (int32 i = 1; i < GenerationThreads.Num(); i++)
+	{
+		const int32 PendingCost = GenerationThreads[i]->GetPendingOrdersCost();
+		if (PendingCost < LowestPendingCost)
+		{
+			LowestPendingCost = PendingCost;
+			LeastLoadedThread = GenerationThreads[i];
+		}
+	}
+
+	LeastLoadedThread->AddOrder(Order);
+}
+
+void FVoxelWorldGenerationScheduler::UpdateLoadingAnchors(const TArray<FChunkLoadingAnchor>& Anchors)
+{
+	for (const auto CurrentThread : GenerationThreads)
+	{
+		CurrentThread->SetLoadingAnchors(Anchors);
+	}
+}
+
+void FVoxelWorldGenerationScheduler::Shutdown()
+{
+	for (const auto CurrentThread : GenerationThreads)
+	{
+		CurrentThread->StartShutdown();
+	}
+
+	for (const auto CurrentThread : GenerationThreads)
+	{
+		if (CurrentThread->Thread != nullptr)
+		{
+			CurrentThread->Thread->WaitForCompletion();
+			delete CurrentThread->Thread;
+		}
+		delete CurrentThread;
+	}
+
+	GenerationThreads.Empty();
+}
+
+void FVoxelWorldGenerationScheduler::LogStats() const
+{
+	for (int32 i = 0; i < GenerationThreads.Num(); i++)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Generation thread %d: %d orders pending with a cost of %d, %d orders completed"), i, GenerationThreads[i]->GetPendingOrdersCount(), GenerationThreads[i]->GetPendingOrdersCost(), GenerationThreads[i]->GetCompletedOrdersCount());
+	}
+}
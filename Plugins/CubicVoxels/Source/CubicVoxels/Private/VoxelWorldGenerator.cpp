@@ -0,0 +1,81 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
+#include "GlobalPluginParameters.h"
+
+void FVoxelWorldGenerator::GenerateChunk(FIntVector ChunkLocation, FChunkData& OutChunkData) const
+{
+	/*The column pass gives the same voxels as the per-voxel function it replaces as long as the voxel is classified with the value of its own column, the positions are computed the same way
+	 *Chunks the generator proves uniform from the bounds of their column are classified without generating a single voxel, which takes a cache lookup once the column is known
+	 */
+	TSharedPtr<const FVoxelChunkColumn> Column;
+	if (!ChunkFunction && ColumnFunction && VoxelInColumnFunction)
+	{
+		const FIntPoint ColumnLocation(ChunkLocation.X, ChunkLocation.Y);
+		Column = ColumnCache.IsValid() ? ColumnCache->FindOrCompute(ColumnLocation, ColumnFunction) : FVoxelColumnCache::ComputeColumn(ColumnLocation, ColumnFunction);
+	}
+
+	FVoxel UniformVoxel;
+	if (UniformChunkFunction && (*UniformChunkFunction)(ChunkLocation, Column.Get(), UniformVoxel))
+	{
+		OutChunkData = FChunkData::UniformChunkData(UniformVoxel);
+		return;
+	}
+
+	if (ChunkFunction)
+	{
+		(*ChunkFunction)(ChunkLocation, OutChunkData);
+		return;
+	}
+
+	if (Column.IsValid())
+	{
+		for (int32 x = 0; x < ChunkSize; x++)
+		{
+			for (int32 y = 0; y < ChunkSize; y++)
+			{
+				const float ColumnValue = Column->Values[x*ChunkSize + y];
+				for (int32 z = 0; z < ChunkSize; z++)
+				{
+					OutChunkData.SetVoxel(x, y, z, (*VoxelInColumnFunction)(GetVoxelPosition(ChunkLocation, x, y, z), ColumnValue));
+				}
+			}
+		}
+		return;
+	}
+
+	if (VoxelFunction)
+	{
+		for (int32 x = 0; x < ChunkSize; x++)
+		{
+			for (int32 y = 0; y < ChunkSize; y++)
+			{
+				for (int32 z = 0; z < ChunkSize; z++)
+				{
+					OutChunkData.SetVoxel(x, y, z, (*VoxelFunction)(GetVoxelPosition(ChunkLocation, x, y, z)));
+				}
+			}
+		}
+	}
+}
+
+bool FVoxelWorldGenerator::IsBatched() const
+{
+	return ChunkFunction || (ColumnFunction && VoxelInColumnFunction);
+}
+
+bool FVoxelWorldGenerator::IsValid() const
+{
+	return IsBatched() || VoxelFunction;
+}
+
+FVoxelWorldGenerator FVoxelWorldGenerator::FromVoxelFunction(FVoxel (*InVoxelFunction) (FVector))
+{
+	FVoxelWorldGenerator Generator;
+	Generator.VoxelFunction = InVoxelFunction;
+	return Generator;
+}
+
+FVector FVoxelWorldGenerator::GetVoxelPosition(FIntVector ChunkLocation, int32 x, int32 y, int32 z)
+{
+	return DefaultVoxelSize*FVector(x + ChunkSize*ChunkLocation.X, y + ChunkSize*ChunkLocation.Y, z + ChunkSize*ChunkLocation.Z);
+}
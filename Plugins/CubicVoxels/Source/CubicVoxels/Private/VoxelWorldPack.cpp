@@ -0,0 +1,413 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelWorldPack.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "GlobalPluginParameters.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+FVoxelWorldPack::~FVoxelWorldPack()
+{
+	Close();
+}
+
+bool FVoxelWorldPack::Open(const FString& InFilePath)
+{
+	/*Only the header is read, the indices and the blobs are paged in by the OS when they are first accessed*/
+	Close();
+	FilePath = InFilePath;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FilePath))
+	{
+		return false;
+	}
+
+	MappedFileHandle.Reset(PlatformFile.OpenMapped(*FilePath));
+	if (MappedFileHandle)
+	{
+		MappedFileRegion.Reset(MappedFileHandle->MapRegion(0, MappedFileHandle->GetFileSize()));
+	}
+
+	if (MappedFileRegion)
+	{
+		Data = MappedFileRegion->GetMappedPtr();
+		DataSize = MappedFileRegion->GetMappedSize();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("World pack %s can't be memory-mapped on this platform, it is read whole instead"), *FilePath)
+		MappedFileHandle.Reset();
+		if (!FFileHelper::LoadFileToArray(FileBytes, *FilePath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not read world pack %s"), *FilePath)
+			return false;
+		}
+		Data = FileBytes.GetData();
+		DataSize = FileBytes.Num();
+	}
+
+	if (!ReadHeader())
+	{
+		UE_LOG(LogTemp, Error, TEXT("World pack %s is corrupted"), *FilePath)
+		Close();
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Opened world pack %s: %d regions, %d chunks"), *FilePath, NumberOfRegions, NumberOfChunks)
+	return true;
+}
+
+void FVoxelWorldPack::Close()
+{
+	//The region must be unmapped before its file is closed
+	MappedFileRegion.Reset();
+	MappedFileHandle.Reset();
+	FileBytes.Empty();
+	Data = nullptr;
+	DataSize = 0;
+	NumberOfRegions = 0;
+	NumberOfChunks = 0;
+}
+
+bool FVoxelWorldPack::IsOpen() const
+{
+	return Data != nullptr;
+}
+
+bool FVoxelWorldPack::Contains(FIntVector ChunkLocation) const
+{
+	int32 BlobSize = 0;
+	return FindChunkBlob(ChunkLocation, BlobSize) != nullptr;
+}
+
+bool FVoxelWorldPack::ContainsRegion(FIntVector RegionLocation) const
+{
+	return FindRegion(RegionLocation) >= 0;
+}
+
+bool FVoxelWorldPack::ReadChunk(FIntVector ChunkLocation, FChunkData& OutChunkData) const
+{
+	int32 BlobSize = 0;
+	const uint8* Blob = FindChunkBlob(ChunkLocation, BlobSize);
+	if (!Blob)
+	{
+		return false;
+	}
+
+	if (!FVoxelChunkCodec::Decode(Blob, BlobSize, OutChunkData))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not decode chunk %d, %d, %d from world pack %s"), ChunkLocation.X, ChunkLocation.Y, ChunkLocation.Z, *FilePath)
+		return false;
+	}
+	return true;
+}
+
+int32 FVoxelWorldPack::GetNumberOfRegions() const
+{
+	return NumberOfRegions;
+}
+
+int32 FVoxelWorldPack::GetNumberOfChunks() const
+{
+	return NumberOfChunks;
+}
+
+int64 FVoxelWorldPack::GetFileSize() const
+{
+	return DataSize;
+}
+
+FString FVoxelWorldPack::GetPackFilePath(const FString& PackPath)
+{
+	return FPaths::IsRelative(PackPath) ? FPaths::Combine(FPaths::ProjectContentDir(), PackPath) : PackPath;
+}
+
+bool FVoxelWorldPack::ReadHeader()
+{
+	/*Header: [magic u32][version u32][region count i32][chunk count i32][region index offset i64][chunk index offset i64]*/
+	if (DataSize < HeaderSize)
+	{
+		return false;
+	}
+
+	const uint32 Magic = static_cast<uint32>(ReadInt32(Data));
+	const uint32 Version = static_cast<uint32>(ReadInt32(Data + 4));
+	if (Magic != FileMagic || Version != FileVersion)
+	{
+		return false;
+	}
+
+	NumberOfRegions = ReadInt32(Data + 8);
+	NumberOfChunks = ReadInt32(Data + 12);
+	RegionIndexOffset = ReadInt64(Data + 16);
+	ChunkIndexOffset = ReadInt64(Data + 24);
+
+	return NumberOfRegions >= 0 && NumberOfChunks >= 0
+		&& RegionIndexOffset >= HeaderSize && RegionIndexOffset + NumberOfRegions*RegionEntrySize <= DataSize
+		&& ChunkIndexOffset >= HeaderSize && ChunkIndexOffset + NumberOfChunks*ChunkEntrySize <= DataSize;
+}
+
+int32 FVoxelWorldPack::FindRegion(FIntVector RegionLocation) const
+{
+	/*Region entry: [X i32][Y i32][Z i32][first chunk i32][chunk count i32]*/
+	if (!IsOpen())
+	{
+		return -1;
+	}
+
+	int32 Low = 0;
+	int32 High = NumberOfRegions;
+	while (Low < High)
+	{
+		const int32 Middle = Low + (High - Low)/2;
+		const uint8* Entry = Data + RegionIndexOffset + Middle*RegionEntrySize;
+		const FIntVector EntryRegion(ReadInt32(Entry), ReadInt32(Entry + 4), ReadInt32(Entry + 8));
+		if (EntryRegion == RegionLocation)
+		{
+			return Middle;
+		}
+		if (IsRegionBefore(EntryRegion, RegionLocation))
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	return -1;
+}
+
+const uint8* FVoxelWorldPack::FindChunkBlob(FIntVector ChunkLocation, int32& OutBlobSize) const
+{
+	/*Chunk entry: [local index i32][blob size i32][blob offset i64]*/
+	const FIntVector RegionLocation = GetRegionOfChunk(ChunkLocation);
+	const int32 RegionIndex = FindRegion(RegionLocation);
+	if (RegionIndex < 0)
+	{
+		return nullptr;
+	}
+
+	const uint8* RegionEntry = Data + RegionIndexOffset + RegionIndex*RegionEntrySize;
+	const int32 FirstChunk = ReadInt32(RegionEntry + 12);
+	const int32 ChunkCount = ReadInt32(RegionEntry + 16);
+	if (FirstChunk < 0 || ChunkCount < 0 || FirstChunk + ChunkCount > NumberOfChunks)
+	{
+		return nullptr;
+	}
+
+	const int32 LocalIndex = GetLocalIndex(ChunkLocation, RegionLocation);
+	int32 Low = FirstChunk;
+	int32 High = FirstChunk + ChunkCount;
+	while (Low < High)
+	{
+		const int32 Middle = Low + (High - Low)/2;
+		const uint8* Entry = Data + ChunkIndexOffset + Middle*ChunkEntrySize;
+		const int32 EntryLocalIndex = ReadInt32(Entry);
+		if (EntryLocalIndex == LocalIndex)
+		{
+			const int32 BlobSize = ReadInt32(Entry + 4);
+			const int64 BlobOffset = ReadInt64(Entry + 8);
+			if (BlobSize <= 0 || BlobOffset < HeaderSize || BlobOffset + BlobSize > DataSize)
+			{
+				return nullptr;
+			}
+			OutBlobSize = BlobSize;
+			return Data + BlobOffset;
+		}
+		if (EntryLocalIndex < LocalIndex)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	return nullptr;
+}
+
+FIntVector FVoxelWorldPack::GetRegionOfChunk(FIntVector ChunkLocation)
+{
+	return FIntVector(FMath::FloorToInt(static_cast<float>(ChunkLocation.X)/RegionSize), FMath::FloorToInt(static_cast<float>(ChunkLocation.Y)/RegionSize), FMath::FloorToInt(static_cast<float>(ChunkLocation.Z)/RegionSize));
+}
+
+int32 FVoxelWorldPack::GetLocalIndex(FIntVector ChunkLocation, FIntVector RegionLocation)
+{
+	//Same order as the chunks of region files
+	const FIntVector LocalLocation = ChunkLocation - RegionSize*RegionLocation;
+	return LocalLocation.X*RegionSize*RegionSize + LocalLocation.Y*RegionSize + LocalLocation.Z;
+}
+
+bool FVoxelWorldPack::IsRegionBefore(FIntVector A, FIntVector B)
+{
+	if (A.X != B.X)
+	{
+		return A.X < B.X;
+	}
+	if (A.Y != B.Y)
+	{
+		return A.Y < B.Y;
+	}
+	return A.Z < B.Z;
+}
+
+int32 FVoxelWorldPack::ReadInt32(const uint8* Bytes)
+{
+	//Entries are not aligned in the file
+	int32 Value;
+	FMemory::Memcpy(&Value, Bytes, sizeof(Value));
+	return INTEL_ORDER32(Value);
+}
+
+int64 FVoxelWorldPack::ReadInt64(const uint8* Bytes)
+{
+	int64 Value;
+	FMemory::Memcpy(&Value, Bytes, sizeof(Value));
+	return INTEL_ORDER64(Value);
+}
+
+FVoxelWorldPackWriter::~FVoxelWorldPackWriter()
+{
+	FileHandle.Reset();
+}
+
+bool FVoxelWorldPackWriter::Open(const FString& InFilePath)
+{
+	/*The header is written again by Finish, an unfinished pack is rejected when it is opened because its magic is left empty*/
+	FilePath = InFilePath;
+	Regions.Empty();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+	FileHandle.Reset(PlatformFile.OpenWrite(*FilePath));
+	if (!FileHandle)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open world pack %s for writing"), *FilePath)
+		return false;
+	}
+
+	TArray<uint8> EmptyHeader;
+	EmptyHeader.SetNumZeroed(FVoxelWorldPack::HeaderSize);
+	WriteOffset = 0;
+	return Write(EmptyHeader);
+}
+
+bool FVoxelWorldPackWriter::AddRegion(FIntVector RegionLocation, const TMap<FIntVector, TArray<uint8>>& EncodedChunks)
+{
+	if (!FileHandle || Regions.Contains(RegionLocation))
+	{
+		return false;
+	}
+
+	//Blobs are written in the order of the chunks in the region, which is the order in which nearby chunks are read
+	TArray<FIntVector> ChunkLocations;
+	for (const auto& ChunkPair : EncodedChunks)
+	{
+		if (FVoxelWorldPack::GetRegionOfChunk(ChunkPair.Key) == RegionLocation && ChunkPair.Value.Num() > 0)
+		{
+			ChunkLocations.Add(ChunkPair.Key);
+		}
+	}
+	ChunkLocations.Sort([RegionLocation](const FIntVector& A, const FIntVector& B)
+	{
+		return FVoxelWorldPack::GetLocalIndex(A, RegionLocation) < FVoxelWorldPack::GetLocalIndex(B, RegionLocation);
+	});
+
+	TArray<FChunkEntry>& ChunkEntries = Regions.Add(RegionLocation);
+	ChunkEntries.Reserve(ChunkLocations.Num());
+	for (const auto& ChunkLocation : ChunkLocations)
+	{
+		const TArray<uint8>& Blob = EncodedChunks[ChunkLocation];
+
+		FChunkEntry& Entry = ChunkEntries.AddDefaulted_GetRef();
+		Entry.LocalIndex = FVoxelWorldPack::GetLocalIndex(ChunkLocation, RegionLocation);
+		Entry.Size = Blob.Num();
+		Entry.Offset = WriteOffset;
+		if (!Write(Blob))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FVoxelWorldPackWriter::Finish()
+{
+	if (!FileHandle)
+	{
+		return false;
+	}
+
+	TArray<FIntVector> RegionLocations;
+	Regions.GetKeys(RegionLocations);
+	RegionLocations.Sort([](const FIntVector& A, const FIntVector& B)
+	{
+		return FVoxelWorldPack::IsRegionBefore(A, B);
+	});
+
+	TArray<uint8> RegionIndex;
+	TArray<uint8> ChunkIndex;
+	FMemoryWriter RegionIndexWriter(RegionIndex);
+	FMemoryWriter ChunkIndexWriter(ChunkIndex);
+	int32 NumberOfChunks = 0;
+	for (auto RegionLocation : RegionLocations)
+	{
+		const TArray<FChunkEntry>& ChunkEntries = Regions[RegionLocation];
+		int32 FirstChunk = NumberOfChunks;
+		int32 ChunkCount = ChunkEntries.Num();
+		RegionIndexWriter << RegionLocation.X << RegionLocation.Y << RegionLocation.Z << FirstChunk << ChunkCount;
+
+		for (auto Entry : ChunkEntries)
+		{
+			ChunkIndexWriter << Entry.LocalIndex << Entry.Size << Entry.Offset;
+		}
+		NumberOfChunks += ChunkCount;
+	}
+
+	int64 RegionIndexOffset = WriteOffset;
+	int64 ChunkIndexOffset = WriteOffset + RegionIndex.Num();
+	if (!Write(RegionIndex) || !Write(ChunkIndex))
+	{
+		return false;
+	}
+
+	TArray<uint8> Header;
+	FMemoryWriter HeaderWriter(Header);
+	uint32 Magic = FVoxelWorldPack::FileMagic;
+	uint32 Version = FVoxelWorldPack::FileVersion;
+	int32 NumberOfRegions = RegionLocations.Num();
+	HeaderWriter << Magic << Version << NumberOfRegions << NumberOfChunks << RegionIndexOffset << ChunkIndexOffset;
+
+	const bool Success = FileHandle->Seek(0) && FileHandle->Write(Header.GetData(), Header.Num()) && FileHandle->Flush();
+	FileHandle.Reset();
+	if (!Success)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not finish world pack %s"), *FilePath)
+	}
+	return Success;
+}
+
+int32 FVoxelWorldPackWriter::GetNumberOfChunks() const
+{
+	int32 NumberOfChunks = 0;
+	for (const auto& RegionPair : Regions)
+	{
+		NumberOfChunks += RegionPair.Value.Num();
+	}
+	return NumberOfChunks;
+}
+
+bool FVoxelWorldPackWriter::Write(const TArray<uint8>& Bytes)
+{
+	if (Bytes.Num() > 0 && !FileHandle->Write(Bytes.GetData(), Bytes.Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not write to world pack %s"), *FilePath)
+		return false;
+	}
+	WriteOffset += Bytes.Num();
+	return true;
+}
@@ -0,0 +1,105 @@
+﻿// .cpp
+#include "SerializationAndNetworking/VoxelWorldPackCommandlet.h"
+#include "VoxelWorld.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "SerializationAndNetworking/VoxelWorldPack.h"
+#include "SerializationAndNetworking/VoxelWorldGlobalDataSaveGame.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+
+UVoxelWorldPackCommandlet::UVoxelWorldPackCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UVoxelWorldPackCommandlet::Main(const FString& Params)
+{
+	/*Regions are copied one after the other, only the blobs of the region being copied are in memory*/
+	FString OutputPath;
+	if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=VoxelWorldPack -Output=Path [-World=WorldName] [-WorldClass=ClassPath]"))
+		return 1;
+	}
+
+	FString WorldName = AVoxelWorld::StaticClass()->GetDefaultObject<AVoxelWorld>()->WorldName;
+	FString WorldClassPath;
+	if (FParse::Value(*Params, TEXT("WorldClass="), WorldClassPath))
+	{
+		const UClass* WorldClass = LoadClass<AVoxelWorld>(nullptr, *WorldClassPath);
+		if (!WorldClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load the voxel world class %s"), *WorldClassPath)
+			return 1;
+		}
+		WorldName = WorldClass->GetDefaultObject<AVoxelWorld>()->WorldName;
+	}
+	FParse::Value(*Params, TEXT("World="), WorldName);
+
+	const FString WorldSaveSlot = WorldName + "\\WorldSaveData";
+	const auto WorldSavedInfo = UGameplayStatics::DoesSaveGameExist(WorldSaveSlot, 0) ? Cast<UVoxelWorldGlobalDataSaveGame>(UGameplayStatics::LoadGameFromSlot(WorldSaveSlot, 0)) : nullptr;
+	if (!WorldSavedInfo)
+	{
+		UE_LOG(LogTemp, Error, TEXT("World %s has no valid save"), *WorldName)
+		return 1;
+	}
+
+	const FString PackFilePath = FVoxelWorldPack::GetPackFilePath(OutputPath);
+	FVoxelWorldPackWriter PackWriter;
+	if (!PackWriter.Open(PackFilePath))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Packing %d regions of world %s into %s"), WorldSavedInfo->SavedRegions.Num(), *WorldName, *PackFilePath)
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 SkippedRegions = 0;
+
+	for (const auto& RegionLocation : WorldSavedInfo->SavedRegions)
+	{
+		//Regions still in the former save game format have no region file, the game converts them on their first access
+		FVoxelRegionFile RegionFile(FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation), RegionLocation);
+		if (!RegionFile.Open(false))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping region %d, %d, %d, it has no region file, call ConvertLegacyRegionSaves on the world first"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+			SkippedRegions += 1;
+			continue;
+		}
+
+		//Region files of a previous version are read as they are, their chunks are encoded again for the pack
+		const bool IsCurrentVersion = RegionFile.IsCurrentVersion();
+		TMap<FIntVector, TArray<uint8>> EncodedChunks;
+		for (const auto& ChunkLocation : RegionFile.GetChunkLocations())
+		{
+			FChunkData ChunkData;
+			const bool Success = IsCurrentVersion
+				? RegionFile.ReadEncodedChunk(ChunkLocation, EncodedChunks.Add(ChunkLocation))
+				: RegionFile.ReadChunk(ChunkLocation, ChunkData) && FVoxelChunkCodec::Encode(ChunkData, EncodedChunks.Add(ChunkLocation), FVoxelRegionFile::BlobCompression);
+			if (!Success)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not read chunk %d, %d, %d"), ChunkLocation.X, ChunkLocation.Y, ChunkLocation.Z)
+				return 1;
+			}
+		}
+		RegionFile.Close();
+
+		if (!PackWriter.AddRegion(RegionLocation, EncodedChunks))
+		{
+			return 1;
+		}
+	}
+
+	const int32 NumberOfChunks = PackWriter.GetNumberOfChunks();
+	if (!PackWriter.Finish())
+	{
+		return 1;
+	}
+
+	const int64 PackSize = IFileManager::Get().FileSize(*PackFilePath);
+	UE_LOG(LogTemp, Display, TEXT("Packed %d chunks in %f s, %f MB, %d regions skipped"), NumberOfChunks, FPlatformTime::Seconds() - StartTime, PackSize/(1024.0*1024.0), SkippedRegions)
+	return 0;
+}
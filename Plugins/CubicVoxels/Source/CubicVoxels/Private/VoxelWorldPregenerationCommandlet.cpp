@@ -0,0 +1,259 @@
+﻿// .cpp
+#include "ThreadedWorldGeneration/VoxelWorldPregenerationCommandlet.h"
+#include "VoxelWorld.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "SerializationAndNetworking/VoxelChunkMeshCache.h"
+#include "ThreadedWorldGeneration/VoxelChunkThreadingUtilities.h"
+#include "SerializationAndNetworking/VoxelWorldGlobalDataSaveGame.h"
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+
+UVoxelWorldPregenerationCommandlet::UVoxelWorldPregenerationCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UVoxelWorldPregenerationCommandlet::Main(const FString& Params)
+{
+	/*Regions are processed one after the other and each region in batches of chunks, the chunks of a batch are generated in parallel
+	 *Every batch is appended to the region file as soon as it is done, so at most one batch is lost when the commandlet is interrupted
+	 */
+	FIntVector MinRegion;
+	FIntVector MaxRegion;
+	if (!ParseRegionLocation(Params, TEXT("Min="), MinRegion) || !ParseRegionLocation(Params, TEXT("Max="), MaxRegion))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=VoxelWorldPregeneration -Min=X,Y,Z -Max=X,Y,Z [-World=WorldName] [-WorldClass=ClassPath] [-BatchSize=4096] [-Mesh]"))
+		return 1;
+	}
+
+	//The generation function and the default world name are set in the constructor of the world class
+	UClass* WorldClass = AVoxelWorld::StaticClass();
+	FString WorldClassPath;
+	if (FParse::Value(*Params, TEXT("WorldClass="), WorldClassPath))
+	{
+		WorldClass = LoadClass<AVoxelWorld>(nullptr, *WorldClassPath);
+		if (!WorldClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load the voxel world class %s"), *WorldClassPath)
+			return 1;
+		}
+	}
+	const AVoxelWorld* DefaultWorld = WorldClass->GetDefaultObject<AVoxelWorld>();
+
+	FString WorldName = DefaultWorld->WorldName;
+	FParse::Value(*Params, TEXT("World="), WorldName);
+
+	int32 BatchSize = 4096;
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	BatchSize = FMath::Clamp(BatchSize, 1, RegionSize*RegionSize*RegionSize);
+
+	const bool WriteMeshCache = FParse::Param(*Params, TEXT("Mesh"));
+
+	TArray<FIntVector> Regions;
+	for (int32 X = FMath::Min(MinRegion.X, MaxRegion.X); X <= FMath::Max(MinRegion.X, MaxRegion.X); X++)
+	{
+		for (int32 Y = FMath::Min(MinRegion.Y, MaxRegion.Y); Y <= FMath::Max(MinRegion.Y, MaxRegion.Y); Y++)
+		{
+			for (int32 Z = FMath::Min(MinRegion.Z, MaxRegion.Z); Z <= FMath::Max(MinRegion.Z, MaxRegion.Z); Z++)
+			{
+				Regions.Add(FIntVector(X, Y, Z));
+			}
+		}
+	}
+
+	const int64 TotalChunks = static_cast<int64>(Regions.Num())*RegionSize*RegionSize*RegionSize;
+	UE_LOG(LogTemp, Display, TEXT("Pregenerating %d regions (%lld chunks) of world %s on %d worker threads"), Regions.Num(), TotalChunks, *WorldName, FTaskGraphInterface::Get().GetNumWorkerThreads())
+
+	const double StartTime = FPlatformTime::Seconds();
+	int64 ChunksDone = 0;
+	int64 ChunksGenerated = 0;
+	int32 FailedRegions = 0;
+
+	for (int32 RegionIndex = 0; RegionIndex < Regions.Num(); RegionIndex++)
+	{
+		const FIntVector RegionLocation = Regions[RegionIndex];
+		const FString RegionFilePath = FVoxelRegionFile::GetRegionFilePath(WorldName, RegionLocation);
+
+		//A region still in the former save game format would be hidden by a new region file, the game converts it on its first access
+		const FString LegacySaveSlot = FString::Printf(TEXT("%s\\%d,%d,%d"), *WorldName, RegionLocation.X, RegionLocation.Y, RegionLocation.Z);
+		if (!FPaths::FileExists(RegionFilePath) && UGameplayStatics::DoesSaveGameExist(LegacySaveSlot, 0))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping region %d, %d, %d, it is saved in the former format, call ConvertLegacyRegionSaves on the world first"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+			ChunksDone += RegionSize*RegionSize*RegionSize;
+			continue;
+		}
+
+		FVoxelRegionFile RegionFile(RegionFilePath, RegionLocation);
+		if (!RegionFile.Open(true))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not open region file %s"), *RegionFilePath)
+			FailedRegions += 1;
+			ChunksDone += RegionSize*RegionSize*RegionSize;
+			continue;
+		}
+
+		FVoxelRegionFile MeshCacheFile(FVoxelChunkMeshCache::GetMeshCacheFilePath(WorldName, RegionLocation), RegionLocation, EVoxelRegionFileContent::ChunkMeshes);
+		if (WriteMeshCache && !MeshCacheFile.Open(true))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not open the mesh cache of region %d, %d, %d, its chunks will be meshed when they are loaded"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+		}
+
+		//Chunks are visited in the order of their index in the region, which is also the order of the blobs in the file
+		TArray<FIntVector> MissingChunks;
+		for (int32 LocalIndex = 0; LocalIndex < RegionSize*RegionSize*RegionSize; LocalIndex++)
+		{
+			const FIntVector ChunkLocation = RegionSize*RegionLocation + FIntVector(LocalIndex/(RegionSize*RegionSize), (LocalIndex/RegionSize)%RegionSize, LocalIndex%RegionSize);
+			if (!RegionFile.Contains(ChunkLocation))
+			{
+				MissingChunks.Add(ChunkLocation);
+			}
+		}
+		ChunksDone += RegionSize*RegionSize*RegionSize - MissingChunks.Num();
+
+		if (MissingChunks.Num() == 0)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Region %d, %d, %d (%d/%d) is already generated"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z, RegionIndex + 1, Regions.Num())
+			RegisterSavedRegion(WorldName, RegionLocation);
+			continue;
+		}
+
+		bool RegionFailed = false;
+		for (int32 BatchStart = 0; BatchStart < MissingChunks.Num(); BatchStart += BatchSize)
+		{
+			const TArray<FIntVector> Batch(MissingChunks.GetData() + BatchStart, FMath::Min(BatchSize, MissingChunks.Num() - BatchStart));
+			const int32 ChunksWritten = GenerateBatch(Batch, DefaultWorld->GetWorldGenerator(), RegionFile, MeshCacheFile.IsOpen() ? &MeshCacheFile : nullptr);
+			if (ChunksWritten != Batch.Num())
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not write the chunks of region %d, %d, %d"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z)
+				RegionFailed = true;
+				break;
+			}
+
+			ChunksDone += Batch.Num();
+			ChunksGenerated += Batch.Num();
+
+			const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+			const double Throughput = ChunksGenerated/FMath::Max(ElapsedTime, 1e-9);
+			const double RemainingTime = (TotalChunks - ChunksDone)/FMath::Max(Throughput, 1e-9);
+			UE_LOG(LogTemp, Display, TEXT("Region %d, %d, %d (%d/%d): %lld/%lld chunks (%.1f%%), %.1f chunks/s, %.0f s remaining"), RegionLocation.X, RegionLocation.Y, RegionLocation.Z, RegionIndex + 1, Regions.Num(), ChunksDone, TotalChunks, 100.0*ChunksDone/TotalChunks, Throughput, RemainingTime)
+		}
+
+		RegionFile.Close();
+		MeshCacheFile.Close();
+		if (RegionFailed)
+		{
+			FailedRegions += 1;
+			continue;
+		}
+		RegisterSavedRegion(WorldName, RegionLocation);
+	}
+
+	const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogTemp, Display, TEXT("Pregeneration done in %f s: %lld chunks generated, %lld were already saved, %.1f chunks/s, %d regions failed"), ElapsedTime, ChunksGenerated, ChunksDone - ChunksGenerated, ChunksGenerated/FMath::Max(ElapsedTime, 1e-9), FailedRegions)
+
+	return FailedRegions > 0 ? 1 : 0;
+}
+
+bool UVoxelWorldPregenerationCommandlet::ParseRegionLocation(const FString& Params, const TCHAR* Key, FIntVector& OutRegionLocation)
+{
+	FString Value;
+	if (!FParse::Value(*Params, Key, Value, false))
+	{
+		return false;
+	}
+
+	TArray<FString> Coordinates;
+	Value.ParseIntoArray(Coordinates, TEXT(","));
+	if (Coordinates.Num() != 3 || !Coordinates[0].IsNumeric() || !Coordinates[1].IsNumeric() || !Coordinates[2].IsNumeric())
+	{
+		return false;
+	}
+
+	OutRegionLocation = FIntVector(FCString::Atoi(*Coordinates[0]), FCString::Atoi(*Coordinates[1]), FCString::Atoi(*Coordinates[2]));
+	return true;
+}
+
+int32 UVoxelWorldPregenerationCommandlet::GenerateBatch(const TArray<FIntVector>& ChunkLocations, const FVoxelWorldGenerator& Generator, FVoxelRegionFile& RegionFile, FVoxelRegionFile* MeshCacheFile)
+{
+	/*Only the encoded chunks are kept, which is a few kilobytes per chunk instead of the whole voxel array*/
+	TArray<TArray<uint8>> EncodedChunks;
+	EncodedChunks.SetNum(ChunkLocations.Num());
+	TArray<TArray<uint8>> EncodedMeshes;
+	EncodedMeshes.SetNum(ChunkLocations.Num());
+	TArray<bool> Encoded;
+	Encoded.Init(false, ChunkLocations.Num());
+
+	ParallelFor(ChunkLocations.Num(), [&ChunkLocations, &Generator, &EncodedChunks, &EncodedMeshes, &Encoded, MeshCacheFile](int32 i)
+	{
+		const FIntVector& ChunkLocation = ChunkLocations[i];
+		FChunkData ChunkData;
+		Generator.GenerateChunk(ChunkLocation, ChunkData);
+		Encoded[i] = FVoxelChunkCodec::Encode(ChunkData, EncodedChunks[i], FVoxelRegionFile::BlobCompression);
+
+		if (MeshCacheFile && Encoded[i])
+		{
+			FVoxelChunkMeshCache::Encode(FVoxelChunkMeshCache::HashChunkData(ChunkData), ComputeInsideQuads(ChunkData), EncodedMeshes[i]);
+		}
+	});
+
+	TMap<FIntVector, TArray<uint8>> ChunksToWrite;
+	ChunksToWrite.Reserve(ChunkLocations.Num());
+	for (int32 i = 0; i < ChunkLocations.Num(); i++)
+	{
+		if (Encoded[i])
+		{
+			ChunksToWrite.Add(ChunkLocations[i], MoveTemp(EncodedChunks[i]));
+		}
+	}
+
+	const int32 NumberOfChunks = ChunksToWrite.Num();
+	if (!RegionFile.WriteEncodedChunks(ChunksToWrite))
+	{
+		return 0;
+	}
+
+	//The mesh cache is written after the chunks, a mesh without its chunk would never be read
+	if (MeshCacheFile)
+	{
+		TMap<FIntVector, TArray<uint8>> MeshesToWrite;
+		MeshesToWrite.Reserve(ChunkLocations.Num());
+		for (int32 i = 0; i < ChunkLocations.Num(); i++)
+		{
+			if (EncodedMeshes[i].Num() > 0)
+			{
+				MeshesToWrite.Add(ChunkLocations[i], MoveTemp(EncodedMeshes[i]));
+			}
+		}
+		if (!MeshCacheFile->WriteEncodedChunks(MeshesToWrite))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not write the mesh cache of %d chunks"), MeshesToWrite.Num())
+		}
+	}
+	return NumberOfChunks;
+}
+
+void UVoxelWorldPregenerationCommandlet::RegisterSavedRegion(const FString& WorldName, FIntVector RegionLocation)
+{
+	/*The world save is written after every region, a game started later reads whatever was pregenerated until then*/
+	const FString WorldSaveSlot = WorldName + "\\WorldSaveData";
+
+	UVoxelWorldGlobalDataSaveGame* WorldSavedInfo = nullptr;
+	if (UGameplayStatics::DoesSaveGameExist(WorldSaveSlot, 0))
+	{
+		WorldSavedInfo = Cast<UVoxelWorldGlobalDataSaveGame>(UGameplayStatics::LoadGameFromSlot(WorldSaveSlot, 0));
+	}
+	if (!WorldSavedInfo)
+	{
+		WorldSavedInfo = Cast<UVoxelWorldGlobalDataSaveGame>(UGameplayStatics::CreateSaveGameObject(UVoxelWorldGlobalDataSaveGame::StaticClass()));
+	}
+
+	if (!WorldSavedInfo->SavedRegions.Contains(RegionLocation))
+	{
+		WorldSavedInfo->SavedRegions.Add(RegionLocation);
+		UGameplayStatics::SaveGameToSlot(WorldSavedInfo, WorldSaveSlot, 0);
+	}
+}
@@ -0,0 +1,170 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+template <typename KeyType, typename ValueType>
+class TAdditionOrderLRU
+{
+	/*Values evicted least recently used first beyond a byte budget, a value is used when it is added or touched
+	 *Caches whose values leave them once they are used again never need to touch them, the order of addition is then the order of last use. The others must touch a value on every hit
+	 *Every value is given a new sequence number when it is added or touched, which tells apart its current place in the order from the places it left behind
+	 *Values that were removed or touched leave their former place in the order behind, they are skipped by the evictions and the order is rebuilt once it is mostly made of them
+	 *Not thread safe, the caches lock around it if they are shared
+	 */
+
+public:
+	//Adds a value, replacing the one that may already be cached under the same key. Returns its sequence number
+	uint64 Add(const KeyType& Key, ValueType&& Value, int64 Bytes)
+	{
+		Remove(Key);
+
+		FEntry& Entry = Entries.Add(Key);
+		Entry.Value = MoveTemp(Value);
+		Entry.Sequence = NextSequence++;
+		Entry.Bytes = Bytes;
+		ResidentBytes += Bytes;
+
+		AdditionOrder.Add(MakeTuple(Key, Entry.Sequence));
+		return Entry.Sequence;
+	}
+
+	ValueType* Find(const KeyType& Key)
+	{
+		FEntry* Entry = Entries.Find(Key);
+		return Entry ? &Entry->Value : nullptr;
+	}
+
+	const ValueType* Find(const KeyType& Key) const
+	{
+		const FEntry* Entry = Entries.Find(Key);
+		return Entry ? &Entry->Value : nullptr;
+	}
+
+	//Only finds the value that was given this sequence number when it was added or last touched
+	ValueType* Find(const KeyType& Key, uint64 Sequence)
+	{
+		FEntry* Entry = Entries.Find(Key);
+		return Entry && Entry->Sequence == Sequence ? &Entry->Value : nullptr;
+	}
+
+	//Moves a value to the end of the order of eviction, returns false if it is not cached
+	bool Touch(const KeyType& Key)
+	{
+		FEntry* Entry = Entries.Find(Key);
+		if (!Entry)
+		{
+			return false;
+		}
+
+		Entry->Sequence = NextSequence++;
+		AdditionOrder.Add(MakeTuple(Key, Entry->Sequence));
+		CompactAdditionOrder();
+		return true;
+	}
+
+	bool Contains(const KeyType& Key) const
+	{
+		return Entries.Contains(Key);
+	}
+
+	//Must be called when the size of a cached value changes
+	void SetBytes(const KeyType& Key, int64 Bytes)
+	{
+		if (FEntry* Entry = Entries.Find(Key))
+		{
+			ResidentBytes += Bytes - Entry->Bytes;
+			Entry->Bytes = Bytes;
+		}
+	}
+
+	bool Remove(const KeyType& Key)
+	{
+		const FEntry* Entry = Entries.Find(Key);
+		if (!Entry)
+		{
+			return false;
+		}
+
+		ResidentBytes -= Entry->Bytes;
+		Entries.Remove(Key);
+		CompactAdditionOrder();
+		return true;
+	}
+
+	//Removes the oldest values while the resident bytes are over the budget, returns the number of values evicted
+	int32 Evict(int64 ByteBudget)
+	{
+		int32 Evictions = 0;
+		while (ResidentBytes > ByteBudget && AdditionOrderHead < AdditionOrder.Num())
+		{
+			const TTuple<KeyType, uint64> Oldest = AdditionOrder[AdditionOrderHead];
+			AdditionOrderHead += 1;
+
+			const FEntry* Entry = Entries.Find(Oldest.template Get<0>());
+			if (Entry && Entry->Sequence == Oldest.template Get<1>())
+			{
+				ResidentBytes -= Entry->Bytes;
+				Entries.Remove(Oldest.template Get<0>());
+				Evictions += 1;
+			}
+		}
+		CompactAdditionOrder();
+		return Evictions;
+	}
+
+	void Empty()
+	{
+		Entries.Empty();
+		AdditionOrder.Empty();
+		AdditionOrderHead = 0;
+		ResidentBytes = 0;
+	}
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	int64 GetResidentBytes() const
+	{
+		return ResidentBytes;
+	}
+
+private:
+	struct FEntry
+	{
+		ValueType Value;
+		uint64 Sequence = 0;
+		int64 Bytes = 0;
+	};
+
+	TMap<KeyType, FEntry> Entries;
+
+	//Keys in the order they were last used, along with their sequence number
+	TArray<TTuple<KeyType, uint64>> AdditionOrder;
+	int32 AdditionOrderHead = 0;
+
+	uint64 NextSequence = 1;
+	int64 ResidentBytes = 0;
+
+	void CompactAdditionOrder()
+	{
+		const int32 PendingAdditions = AdditionOrder.Num() - AdditionOrderHead;
+		if (PendingAdditions <= 2*Entries.Num() + 64)
+		{
+			return;
+		}
+
+		TArray<TTuple<KeyType, uint64>> CompactedOrder;
+		CompactedOrder.Reserve(Entries.Num());
+		for (int32 i = AdditionOrderHead; i < AdditionOrder.Num(); i++)
+		{
+			const FEntry* Entry = Entries.Find(AdditionOrder[i].template Get<0>());
+			if (Entry && Entry->Sequence == AdditionOrder[i].template Get<1>())
+			{
+				CompactedOrder.Add(AdditionOrder[i]);
+			}
+		}
+		AdditionOrder = MoveTemp(CompactedOrder);
+		AdditionOrderHead = 0;
+	}
+};
@@ -38,6 +38,17 @@ public:
 	FIntVector Location;
 	bool IsLoaded;
 
+	//Handles to the six loaded neighbours, in the order of FChunkPipeline::Directions, null when a neighbour is not loaded
+	//They are maintained by the VoxelWorld when chunks are spawned and destroyed, so that edits reach neighbouring chunks without any map lookup
+	UPROPERTY()
+	TObjectPtr<AChunk> Neighbours[6];
+
+	//Links this chunk and the given neighbour to each other
+	void LinkNeighbour(int32 DirectionIndex, AChunk* Neighbour);
+
+	//Clears the handles of the neighbours pointing to this chunk, called before the chunk is destroyed
+	void UnlinkNeighbours();
+
 	UPROPERTY()
 	class UDataTable* VoxelCharacteristicsData;
 
@@ -61,6 +72,11 @@ public:
 
 	bool IsInsideGeometryLoaded;
 	bool IsSideGeometryLoaded[6];
+
+	//Set when the inside geometry was read from the mesh cache and the chunk was not edited since, its cache entry doesn't need to be written again
+	bool IsMeshCached = false;
+
+	const TMap<FIntVector4, FVoxel>& GetQuads() const;
 	
 	TSharedPtr<FChunkData> BlocksDataPtr;
 	
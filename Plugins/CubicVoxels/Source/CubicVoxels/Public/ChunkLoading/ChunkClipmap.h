@@ -0,0 +1,261 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+template <typename ValueType>
+class TChunkClipmap
+{
+	/*Toroidal 3D array that maps chunk coordinates to values
+	 *A chunk is stored in the slot given by its coordinates modulo the extent of the array, so that looking up a chunk near the players is a single array access
+	 *The extent is sized from the view distances, so every chunk loaded around a player gets its own slot
+	 *Chunks that collide with an already occupied slot, such as chunks around far away players, are kept in a hash map fallback under the index of their slot
+	 *A chunk of the fallback moves into its slot as soon as the chunk occupying it is removed, so the fallback doesn't keep growing while players travel. A slot is thus always occupied when it has chunks in the fallback
+	 */
+
+public:
+	TChunkClipmap()
+	{
+		SetExtent(0, 0);
+	}
+
+	//Sets the horizontal and vertical distances, in chunks, that must fit around a point without collision, existing entries are kept
+	void SetExtent(int32 HorizontalDistance, int32 VerticalDistance)
+	{
+		TArray<TPair<FIntVector, ValueType>> Entries;
+		ForEach([&Entries](const FIntVector& Key, ValueType& Value)
+		{
+			Entries.Add(TPair<FIntVector, ValueType>(Key, MoveTemp(Value)));
+		});
+
+		//Power of two sizes turn the modulo into a mask, which is also correct for negative coordinates
+		SizeXY = FMath::RoundUpToPowerOfTwo(2*HorizontalDistance + 1);
+		SizeZ = FMath::RoundUpToPowerOfTwo(2*VerticalDistance + 1);
+		MaskXY = SizeXY - 1;
+		MaskZ = SizeZ - 1;
+
+		Slots.Empty();
+		Slots.SetNum(SizeXY*SizeXY*SizeZ);
+		Fallback.Empty();
+		NumberOfEntries = 0;
+		NumberOfFallbackEntries = 0;
+
+		for (auto& Entry : Entries)
+		{
+			Add(Entry.Key, MoveTemp(Entry.Value));
+		}
+	}
+
+	ValueType* Find(const FIntVector& Key)
+	{
+		const int32 SlotIndex = GetSlotIndex(Key);
+		FSlot& Slot = Slots[SlotIndex];
+		if (!Slot.IsOccupied)
+		{
+			return nullptr;
+		}
+		if (Slot.Key == Key)
+		{
+			return &Slot.Value;
+		}
+		if (NumberOfFallbackEntries > 0)
+		{
+			if (FFallbackBucket* Bucket = Fallback.Find(SlotIndex))
+			{
+				for (auto& Entry : *Bucket)
+				{
+					if (Entry.Key == Key)
+					{
+						return &Entry.Value;
+					}
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	const ValueType* Find(const FIntVector& Key) const
+	{
+		return const_cast<TChunkClipmap*>(this)->Find(Key);
+	}
+
+	bool Contains(const FIntVector& Key) const
+	{
+		return Find(Key) != nullptr;
+	}
+
+	ValueType& operator[](const FIntVector& Key)
+	{
+		ValueType* Value = Find(Key);
+		check(Value);
+		return *Value;
+	}
+
+	ValueType& Add(const FIntVector& Key, ValueType Value)
+	{
+		if (ValueType* ExistingValue = Find(Key))
+		{
+			*ExistingValue = MoveTemp(Value);
+			return *ExistingValue;
+		}
+
+		NumberOfEntries += 1;
+
+		const int32 SlotIndex = GetSlotIndex(Key);
+		FSlot& Slot = Slots[SlotIndex];
+		if (!Slot.IsOccupied)
+		{
+			Slot.Key = Key;
+			Slot.Value = MoveTemp(Value);
+			Slot.IsOccupied = true;
+			return Slot.Value;
+		}
+
+		NumberOfFallbackEntries += 1;
+		FFallbackBucket& Bucket = Fallback.FindOrAdd(SlotIndex);
+		Bucket.Add(TPair<FIntVector, ValueType>(Key, MoveTemp(Value)));
+		return Bucket.Last().Value;
+	}
+
+	ValueType& FindOrAdd(const FIntVector& Key)
+	{
+		if (ValueType* ExistingValue = Find(Key))
+		{
+			return *ExistingValue;
+		}
+		return Add(Key, ValueType());
+	}
+
+	void Remove(const FIntVector& Key)
+	{
+		const int32 SlotIndex = GetSlotIndex(Key);
+		FSlot& Slot = Slots[SlotIndex];
+		if (!Slot.IsOccupied)
+		{
+			return;
+		}
+
+		FFallbackBucket* Bucket = NumberOfFallbackEntries > 0 ? Fallback.Find(SlotIndex) : nullptr;
+		if (Slot.Key == Key)
+		{
+			NumberOfEntries -= 1;
+			if (Bucket)
+			{
+				//The slot is handed to a chunk of the fallback instead of being freed
+				auto& Entry = Bucket->Last();
+				Slot.Key = Entry.Key;
+				Slot.Value = MoveTemp(Entry.Value);
+				RemoveFromFallback(SlotIndex, *Bucket, Bucket->Num() - 1);
+			}
+			else
+			{
+				Slot.IsOccupied = false;
+				Slot.Value = ValueType();
+			}
+			return;
+		}
+
+		if (Bucket)
+		{
+			for (int32 i = 0; i < Bucket->Num(); i++)
+			{
+				if ((*Bucket)[i].Key == Key)
+				{
+					NumberOfEntries -= 1;
+					RemoveFromFallback(SlotIndex, *Bucket, i);
+					return;
+				}
+			}
+		}
+	}
+
+	void Empty()
+	{
+		for (auto& Slot : Slots)
+		{
+			Slot = FSlot();
+		}
+		Fallback.Empty();
+		NumberOfEntries = 0;
+		NumberOfFallbackEntries = 0;
+	}
+
+	int32 Num() const
+	{
+		return NumberOfEntries;
+	}
+
+	int32 NumInFallback() const
+	{
+		return NumberOfFallbackEntries;
+	}
+
+	//Calls the function on every entry, entries may be modified but not added or removed during the iteration
+	template <typename FunctionType>
+	void ForEach(FunctionType Function)
+	{
+		if (NumberOfEntries == 0)
+		{
+			return;
+		}
+		for (auto& Slot : Slots)
+		{
+			if (Slot.IsOccupied)
+			{
+				Function(static_cast<const FIntVector&>(Slot.Key), Slot.Value);
+			}
+		}
+		for (auto& Bucket : Fallback)
+		{
+			for (auto& Entry : Bucket.Value)
+			{
+				Function(static_cast<const FIntVector&>(Entry.Key), Entry.Value);
+			}
+		}
+	}
+
+	TArray<FIntVector> GetKeys() const
+	{
+		TArray<FIntVector> Result;
+		Result.Reserve(NumberOfEntries);
+		const_cast<TChunkClipmap*>(this)->ForEach([&Result](const FIntVector& Key, ValueType&)
+		{
+			Result.Add(Key);
+		});
+		return Result;
+	}
+
+private:
+	struct FSlot
+	{
+		FIntVector Key = FIntVector(0,0,0);
+		ValueType Value = ValueType();
+		bool IsOccupied = false;
+	};
+
+	//Chunks of the fallback that collide with the same slot, there is rarely more than one
+	typedef TArray<TPair<FIntVector, ValueType>, TInlineAllocator<1>> FFallbackBucket;
+
+	int32 GetSlotIndex(const FIntVector& Key) const
+	{
+		return ((Key.X & MaskXY)*SizeXY + (Key.Y & MaskXY))*SizeZ + (Key.Z & MaskZ);
+	}
+
+	void RemoveFromFallback(int32 SlotIndex, FFallbackBucket& Bucket, int32 EntryIndex)
+	{
+		Bucket.RemoveAtSwap(EntryIndex);
+		if (Bucket.Num() == 0)
+		{
+			Fallback.Remove(SlotIndex);
+		}
+		NumberOfFallbackEntries -= 1;
+	}
+
+	TArray<FSlot> Slots;
+	TMap<int32, FFallbackBucket> Fallback;
+
+	int32 SizeXY = 1;
+	int32 SizeZ = 1;
+	int32 MaskXY = 0;
+	int32 MaskZ = 0;
+	int32 NumberOfEntries = 0;
+	int32 NumberOfFallbackEntries = 0;
+};
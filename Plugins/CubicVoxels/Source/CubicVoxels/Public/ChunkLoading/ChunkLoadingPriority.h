@@ -0,0 +1,40 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+struct FChunkLoadingAnchor
+{
+	/*Snapshot of something chunks are loaded around, in chunk units and in the coordinates of the voxel world
+	 *It is copied to the generation threads, so it must not reference any game object
+	 */
+
+	FVector Position = FVector::ZeroVector;
+
+	//Velocity in chunks per second, the anchor is expected to reach Position + Velocity*LookaheadTime
+	FVector Velocity = FVector::ZeroVector;
+
+	//Unit vector of the camera direction, zero when the anchor has no view direction
+	FVector Forward = FVector::ZeroVector;
+
+	float LookaheadTime = 0;
+
+	//How much later a chunk right behind the camera is loaded compared to a chunk at the same distance in front of it, 0 disables it
+	float ViewDirectionWeight = 0;
+
+	//Distances to this anchor are divided by this factor, so that anchors with a higher priority are served first
+	float PriorityScale = 1;
+};
+
+class FChunkLoadingPriority
+{
+	/*Priority of a chunk as an effective distance to the nearest anchor, chunks with the lowest value are loaded first
+	 *The distance is measured to the path predicted from the anchor's velocity, so that the chunks a moving player is heading to come before the ones it leaves behind
+	 *It is then stretched for chunks outside of the view direction, so that what is in front of the camera appears first
+	 */
+
+public:
+	static float GetPriority(const FChunkLoadingAnchor& Anchor, FIntVector ChunkLocation);
+	static float GetPriority(const TArray<FChunkLoadingAnchor>& Anchors, FIntVector ChunkLocation);
+
+	//Returns true iff the chunk is in the half space in front of the anchor's camera
+	static bool IsInFront(const FChunkLoadingAnchor& Anchor, FIntVector ChunkLocation);
+};
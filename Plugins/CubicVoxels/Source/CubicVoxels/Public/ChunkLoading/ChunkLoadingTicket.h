@@ -0,0 +1,27 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "ChunkLoading/ChunkViewShells.h"
+
+struct FChunkLoadingTicket
+{
+	/*Request to keep the chunks around an anchor loaded, for anything that is not a managed player: AI squads, cinematic cameras, server-side simulations...
+	 *The anchor follows an actor when one is given, otherwise it stays at a fixed location
+	 */
+
+	TWeakObjectPtr<AActor> AnchorActor;
+	FVector AnchorLocation = FVector::ZeroVector;
+
+	//Chunks within this one-norm distance of the anchor are loaded, the same distance is used vertically
+	int32 Radius = 0;
+
+	//Distances to this ticket's anchor are divided by its priority when chunk orders are sorted
+	float Priority = 1;
+
+	EChunkLoadingLevel Level = EChunkLoadingLevel::FullMesh;
+
+	TSharedPtr<FChunkViewShells> Shells;
+
+	FIntVector LastLoadingOrigin = FIntVector(0,0,0);
+	bool HasLoadingOrigin = false;
+};
@@ -0,0 +1,46 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+class FChunkViewShells
+{
+	/*Precomputed tables describing the chunks in view of a loading origin for given view distances
+	 *The view is the set of chunk offsets whose one-norm is at most the view distance and whose vertical offset is below the vertical view distance
+	 *When the origin moves by one chunk in any direction, the chunks entering and leaving the view are read from a table instead of rescanning the whole view
+	 */
+
+public:
+	FChunkViewShells(int32 InViewDistance, int32 InVerticalViewDistance);
+
+	int32 GetViewDistance() const { return ViewDistance; }
+	int32 GetVerticalViewDistance() const { return VerticalViewDistance; }
+
+	//Returns true iff the chunk at the given offset from the origin is in view
+	bool Contains(FIntVector Offset) const;
+
+	//Layers of the view sorted by one-norm, layer i holds the offsets at distance i from the origin
+	const TArray<TArray<FIntVector>>& GetViewLayers() const;
+
+	//Number of chunks in view
+	int32 Num() const;
+
+	//Appends the chunks that are in view of the new origin but were not in view of the old one, sorted by distance to the new origin
+	void GetEnteringChunks(FIntVector OldOrigin, FIntVector NewOrigin, TArray<FIntVector>& OutChunks) const;
+
+	//Appends the chunks that were in view of the old origin but are not in view of the new one
+	void GetLeavingChunks(FIntVector OldOrigin, FIntVector NewOrigin, TArray<FIntVector>& OutChunks) const;
+
+	//Appends the chunks around the origin that are in view for these shells but not for the other ones, sorted by distance to the origin
+	void GetChunksNotInView(const FChunkViewShells& OtherShells, FIntVector Origin, TArray<FIntVector>& OutChunks) const;
+
+private:
+	int32 ViewDistance;
+	int32 VerticalViewDistance;
+
+	TArray<TArray<FIntVector>> ViewLayers;
+
+	//Offsets relative to the new origin that enter the view when the origin moves by a unit step, indexed by GetStepIndex
+	TArray<FIntVector> EnteringShells[27];
+
+	static int32 GetStepIndex(FIntVector Step);
+	static bool IsUnitStep(FIntVector Step);
+};
@@ -0,0 +1,88 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+#include "AdditionOrderLRU.h"
+
+struct FUnloadedChunkCacheStats
+{
+	int64 Hits = 0;
+	int64 Misses = 0;
+	int64 Evictions = 0;
+	int64 Invalidations = 0;
+
+	//Work that the hits saved, a chunk that was never saved would have been generated again and every chunk kept with its geometry would have been meshed again
+	int64 GenerationsAvoided = 0;
+	int64 MeshingsAvoided = 0;
+
+	int64 ResidentBytes = 0;
+	int32 ResidentChunks = 0;
+};
+
+//A chunk kept in memory after it was unloaded
+struct FUnloadedChunk
+{
+	//Until it is encoded on a worker thread, the chunk is kept as it was when it was unloaded
+	TSharedPtr<FChunkData> ChunkData;
+	TSharedPtr<TMap<FIntVector4, FVoxel>> InsideQuads;
+
+	//Encoded with FVoxelChunkCodec and FVoxelChunkMeshCache, the quads are empty if the chunk had no geometry
+	TArray<uint8> EncodedChunkData;
+	TArray<uint8> EncodedInsideQuads;
+
+	//Set when the chunk has no saved data, it would have to be generated again
+	bool WasGenerated = false;
+
+	bool HasInsideQuads() const
+	{
+		return InsideQuads.IsValid() || EncodedInsideQuads.Num() > 0;
+	}
+};
+
+//A chunk encoded on a worker thread after it was unloaded, for the cache of unloaded chunks, for the mesh cache on disk or for both
+struct FEncodedUnloadedChunk
+{
+	FIntVector ChunkLocation;
+	uint64 Sequence = 0;
+	bool KeepInMemory = false;
+	bool WriteMeshCache = false;
+	TArray<uint8> EncodedChunkData;
+	TArray<uint8> EncodedInsideQuads;
+};
+
+class FUnloadedChunkCache
+{
+	/*Recently unloaded chunks kept in memory, so that a player walking back and forth across the unloading distance doesn't make them generated and meshed again
+	 *Chunks are compressed on worker threads once they are added and are evicted least recently unloaded first beyond a byte budget
+	 *A chunk is removed from the cache when it is loaded again, so the order of eviction is the order in which chunks were added
+	 *The cache doesn't follow the edits, the world invalidates the chunks that are edited while they are unloaded
+	 */
+
+public:
+	//Adds a chunk that was just unloaded, replacing the one that may already be cached. Returns the sequence number the encoded chunk is given back with
+	uint64 Add(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkData, TSharedPtr<TMap<FIntVector4, FVoxel>> InsideQuads, bool WasGenerated);
+
+	//Replaces the data of a chunk with its encoding, ignored if the chunk was loaded or added again since
+	void SetEncoded(FIntVector ChunkLocation, uint64 Sequence, TArray<uint8>&& EncodedChunkData, TArray<uint8>&& EncodedInsideQuads);
+
+	//Removes a chunk from the cache to load it, counted as a hit or a miss
+	//A chunk that is still being encoded is copied, as the worker thread may still be reading it
+	bool Take(FIntVector ChunkLocation, FUnloadedChunk& OutUnloadedChunk);
+
+	bool Contains(FIntVector ChunkLocation) const;
+
+	//Data of a cached chunk without taking it from the cache, or nullptr. An encoded chunk is decoded once and kept decoded along with its encoding, for the queries that follow
+	const FChunkData* FindChunkData(FIntVector ChunkLocation);
+	void Invalidate(FIntVector ChunkLocation);
+	void Evict(int64 ByteBudget);
+	void Empty();
+
+	FUnloadedChunkCacheStats GetStats() const;
+	void LogStats() const;
+
+private:
+	TAdditionOrderLRU<FIntVector, FUnloadedChunk> Chunks;
+
+	FUnloadedChunkCacheStats Stats;
+
+	static int64 GetEntryBytes(const FUnloadedChunk& Chunk);
+};
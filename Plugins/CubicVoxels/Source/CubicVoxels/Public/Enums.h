@@ -1,19 +1,29 @@
 #pragma once
 
 //Enum that represents the loading state of a chunk
+//A chunk is Unloading when it left every player's view while its generation was in flight, its data is dropped when it arrives
+//A chunk is PendingRegion while the saved data of its region is read from disk, no order has been sent for it yet
 enum class EChunkState
 {
-	Loading, Loaded, Unloading
+	Loading, Loaded, Unloading, PendingRegion
 };
 
 //Enum that represents the type of threaded work to be realised to generate a given chunk
 enum class EChunkThreadedWorkOrderType
 {
-	GenerationAndMeshing, MeshingFromData, GeneratingAndMeshingWithAdditiveData, GeneratingExistingChunksSides
+	GenerationAndMeshing, MeshingFromData, GeneratingAndMeshingWithAdditiveData, GeneratingExistingChunksSides, GenerationOnly, LoadingUnloadedChunk, LoadingFromWorldPack
+};
+
+//Enum that represents how far a chunk requested by a loading ticket is taken
+//DataOnly chunks have their voxel data in memory but no actor and no mesh
+UENUM(BlueprintType)
+enum class EChunkLoadingLevel : uint8
+{
+	DataOnly, FullMesh
 };
 
 UENUM()
 enum class EVoxelWorldNetworkMode
 {
-	ClientOnly
+	ClientOnly, Server
 };
\ No newline at end of file
@@ -2,20 +2,26 @@
 #include "ThreadedWorldGeneration/FVoxelWorldGenerationRunnable.h"
 #include "Containers/Queue.h"
 #include "VoxelStructs.h"
+#include "ChunkLoading/ChunkViewShells.h"
 #include "ReplicationStructs.generated.h"
 
 class AVoxelDataStreamer;
 
 struct FVoxelWorldManagedPlayerData
 {
-	FVoxelWorldGenerationRunnable* PlayerWorldGenerationThread;
-	TQueue<FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* ChunkGenerationOrdersQueuePtr;
-	
-	FVoxelWorldGenerationRunnable* PlayerChunkSidesGenerationThread;
-	TQueue<FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* ChunkSidesMeshingOrdersQueuePtr;
-
+	//The chunk orders of every player go through the VoxelWorld's generation scheduler, which balances them between its threads
 	TObjectPtr<AVoxelDataStreamer> PlayerDataStreamer;
 
+	//Chunk in which the player was on the last tick, chunks are only created when the player crosses a chunk boundary
+	FIntVector LastLoadingOrigin = FIntVector(0,0,0);
+	bool HasLoadingOrigin = false;
+
+	//View distances of the player, and the shell tables of its view and of its unloading distance, which are shared between players with the same distances
+	int32 ViewDistance = 0;
+	int32 VerticalViewDistance = 0;
+	TSharedPtr<FChunkViewShells> ViewShells;
+	TSharedPtr<FChunkViewShells> RetainingShells;
+
 };
 
 USTRUCT()
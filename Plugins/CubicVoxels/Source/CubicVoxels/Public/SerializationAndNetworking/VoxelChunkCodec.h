@@ -0,0 +1,75 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+
+//Layout of the voxels of an encoded chunk, every encoding starts with the palette of the voxel types of the chunk
+enum class EVoxelChunkEncoding : uint8
+{
+	Uniform,		//The chunk is made of a single voxel type, the palette is enough
+	Runs,			//Runs of identical voxels, each one a palette index and a length
+	PackedPalette,	//One palette index per voxel, packed on as few bits as the palette size allows
+	Edits,			//Edits of a sparse additive chunk, each one a voxel index and a palette index
+	Num
+};
+
+//General purpose compression applied on top of the encoding when it makes the chunk smaller
+enum class EVoxelChunkCompression : uint8
+{
+	None,
+	LZ4,
+	Zlib,
+	Oodle,
+	Num
+};
+
+class FVoxelChunkCodec
+{
+	/*Encodes chunk data into a compact byte buffer and back, for save files and for any other copy of a chunk that is not being read voxel by voxel
+	 *Layout: [encoding u8][compression u8][raw size i32] then the payload, compressed if the compression is not None
+	 *Payload: [flags u8][palette size u16][palette] then the data of the encoding
+	 *Encode picks the smallest encoding that applies to the chunk, so lightly varied chunks stay small even without compression
+	 */
+
+public:
+	//Encodes the chunk with the smallest applicable encoding
+	static bool Encode(const FChunkData& ChunkData, TArray<uint8>& OutBytes, EVoxelChunkCompression Compression = EVoxelChunkCompression::LZ4);
+
+	//Encodes the chunk with the given encoding, fails if the encoding can't represent the chunk
+	static bool EncodeAs(const FChunkData& ChunkData, EVoxelChunkEncoding Encoding, TArray<uint8>& OutBytes, EVoxelChunkCompression Compression = EVoxelChunkCompression::LZ4);
+
+	static bool Decode(const uint8* Bytes, int32 NumberOfBytes, FChunkData& OutChunkData);
+	static bool Decode(const TArray<uint8>& Bytes, FChunkData& OutChunkData);
+
+	//Returns the encoding of an encoded chunk without decoding it
+	static EVoxelChunkEncoding GetEncoding(const TArray<uint8>& Bytes);
+
+	static const TCHAR* GetEncodingName(EVoxelChunkEncoding Encoding);
+	static const TCHAR* GetCompressionName(EVoxelChunkCompression Compression);
+
+private:
+	//Voxels of a dense chunk as indices into its palette, in voxel index order
+	struct FPalettedChunk
+	{
+		TArray<FVoxel> Palette;
+		TArray<uint16> Indices;
+	};
+
+	static void BuildPalettedChunk(const FChunkData& ChunkData, FPalettedChunk& OutPalettedChunk);
+	static void BuildEdits(const FChunkData& ChunkData, TArray<FVoxel>& OutPalette, TArray<FAdditiveVoxel>& OutEdits, TArray<uint16>& OutEditPaletteIndices);
+
+	static int32 GetBitsPerIndex(int32 PaletteSize);
+	static int32 GetPackedSize(const FPalettedChunk& PalettedChunk);
+	static int32 GetRunsSize(const FPalettedChunk& PalettedChunk);
+
+	static void WritePalette(FArchive& Writer, const TArray<FVoxel>& Palette);
+	static bool ReadPalette(FArchive& Reader, TArray<FVoxel>& OutPalette);
+
+	static bool WritePayload(const FChunkData& ChunkData, EVoxelChunkEncoding Encoding, const FPalettedChunk* PalettedChunk, TArray<uint8>& OutPayload);
+	static bool ReadPayload(const uint8* Payload, int32 PayloadSize, EVoxelChunkEncoding Encoding, FChunkData& OutChunkData);
+	static bool Finish(EVoxelChunkEncoding Encoding, EVoxelChunkCompression Compression, const TArray<uint8>& Payload, TArray<uint8>& OutBytes);
+
+	static FName GetCompressionFormat(EVoxelChunkCompression Compression);
+
+	static constexpr int32 HeaderSize = 6;
+	static constexpr uint8 AdditiveFlag = 1;
+};
@@ -0,0 +1,29 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+
+class FVoxelChunkMeshCache
+{
+	/*Encodes the inside geometry of a chunk so that a saved chunk can be shown again without being meshed
+	 *The entries are stored in a file per region laid out like the region files but tagged as holding meshes, next to them, and each entry holds the hash of the chunk data it was meshed from
+	 *An entry is only used if the hash of the chunk data being loaded is the same, so an edit made to a chunk after its mesh was cached simply makes it miss
+	 *Sides are not cached, they depend on the neighbouring chunks and meshing one costs about as much as checking that it is still valid
+	 *Layout: [data hash u32][compressed u8][raw size i32] then the payload, compressed with LZ4 if it made it smaller
+	 *Payload: [palette size u16][palette][quad count i32] then for every quad its location and direction packed in a u32 and a palette index
+	 */
+
+public:
+	//Hash of the voxels of a dense chunk, stable from one run to the next as voxel types are hashed by name
+	static uint32 HashChunkData(const FChunkData& ChunkData);
+
+	//Keeps the quads whose face is between two voxels of the chunk, the others are side quads
+	static void GetInsideQuads(const TMap<FIntVector4, FVoxel>& Quads, TMap<FIntVector4, FVoxel>& OutInsideQuads);
+
+	static bool Encode(uint32 DataHash, const TMap<FIntVector4, FVoxel>& InsideQuads, TArray<uint8>& OutBytes);
+	static bool Decode(const TArray<uint8>& Bytes, uint32& OutDataHash, TMap<FIntVector4, FVoxel>& OutInsideQuads);
+
+	static FString GetMeshCacheFilePath(const FString& WorldName, FIntVector RegionLocation);
+
+private:
+	static constexpr int32 HeaderSize = 9;
+};
@@ -0,0 +1,109 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "VoxelStructs.h"
+
+class IFileHandle;
+
+//A single voxel edit, located in voxel coordinates relative to the world
+struct FVoxelEdit
+{
+	uint64 Sequence = 0;
+	FIntVector VoxelLocation;
+
+	//The previous voxel is only known when the chunk was in memory at the time of the edit
+	bool OldVoxelKnown = false;
+	FVoxel OldVoxel;
+
+	FVoxel NewVoxel;
+};
+
+class FVoxelEditJournal
+{
+	/*Append-only log of the voxel edits of a world, so that an edit is on disk a fraction of a second after it is made without rewriting its chunk
+	 *The journal is split in segments, a new segment is started when a world save takes its snapshot and the older segments are deleted once that save is written
+	 *Each segment is self-contained: the voxel types it uses are defined in it before their first use
+	 *Every record carries a checksum, replay stops at the first torn or corrupted record, which can only be the last one written before a crash
+	 *All the file work but opening and reading happens in Flush, the functions called on the game thread only touch the buffers and never wait for the disk
+	 */
+
+public:
+	FVoxelEditJournal();
+	~FVoxelEditJournal();
+
+	//Opens the journal of a world, new edits are appended to a new segment
+	bool Open(const FString& InDirectory);
+	void Close();
+	bool IsOpen() const;
+
+	//Reads the edits of every segment on disk in the order they were made
+	bool ReadEdits(TArray<FVoxelEdit>& OutEdits);
+
+	//Buffers an edit, it reaches the disk on the next flush
+	void Append(FVoxelEdit Edit);
+
+	//Whether the next flush has anything to write or delete
+	bool NeedsFlush() const;
+
+	//Writes the buffered edits, creating the segments started since the last flush, then deletes the segments released since then. May be called on any thread
+	bool Flush();
+
+	//Starts a new segment, returns its index. The edits buffered so far still go to the previous segment
+	int32 Rotate();
+
+	//Releases the segments whose edits have all been written into region files, they are deleted by the next flush
+	void DeleteSegmentsBefore(int32 SegmentIndex);
+
+	//Bytes written or buffered for the current segment, used to decide when to fold the journal into the region files
+	int64 GetCurrentSegmentBytes() const;
+
+	static FString GetJournalDirectory(const FString& WorldName);
+
+private:
+	enum class ERecordType : uint8
+	{
+		VoxelType, Edit
+	};
+
+	FString Directory;
+	bool IsJournalOpen = false;
+	int32 CurrentSegmentIndex = 0;
+	int64 CurrentSegmentBytes = 0;
+	uint64 NextSequence = 0;
+
+	//Voxel types defined in the current segment
+	TMap<FName, uint16> VoxelTypeIds;
+
+	//Bytes of the current segment waiting for the next flush
+	TArray<uint8> PendingBytes;
+
+	//Bytes taken from PendingBytes that are not on disk yet, because their segment was rotated away before a flush or because their write failed, in the order they must be written
+	TArray<TPair<int32, TArray<uint8>>> UnwrittenBytes;
+
+	//Segments before this one are deleted by the next flush
+	int32 SegmentsToDeleteBefore = INDEX_NONE;
+
+	//Guards the buffers and is never held during file operations, so that appending an edit doesn't wait for a flush
+	mutable FCriticalSection JournalMutex;
+
+	//Guards the file handle and serializes the flushes, taken before JournalMutex when both are needed
+	FCriticalSection FileMutex;
+	TUniquePtr<IFileHandle> FileHandle;
+	int32 FileSegmentIndex = INDEX_NONE;
+
+	FString GetSegmentPath(int32 SegmentIndex) const;
+	TArray<int32> GetSegmentIndices() const;
+
+	//Resets the buffers for a new segment, its file is created by the next flush
+	void StartSegment(int32 SegmentIndex);
+
+	//Points the file handle at a segment, its file is created if Create is set and appended to otherwise
+	bool OpenSegmentFile(int32 SegmentIndex, bool Create);
+	uint16 GetVoxelTypeId(const FVoxel& Voxel);
+	void AppendRecord(ERecordType RecordType, const TArray<uint8>& Payload);
+	bool ReadSegment(int32 SegmentIndex, TArray<FVoxelEdit>& OutEdits);
+
+	static constexpr uint32 SegmentMagic = 0x4A525643; //"CVRJ"
+	static constexpr uint32 SegmentVersion = 1;
+	static constexpr uint16 UnknownVoxelTypeId = 0xFFFF;
+};
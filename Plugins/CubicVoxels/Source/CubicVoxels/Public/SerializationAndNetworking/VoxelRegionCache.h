@@ -0,0 +1,69 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+
+struct FVoxelRegionCacheStats
+{
+	int64 Hits = 0;
+	int64 Misses = 0;
+	int64 Evictions = 0;
+	int64 WriteBacks = 0;
+	int64 ResidentBytes = 0;
+	int32 ResidentRegions = 0;
+};
+
+class FVoxelRegionCache
+{
+	/*Saved data of the regions kept in memory, bounded by a byte budget
+	 *Regions are evicted least recently used first, pinned regions are never evicted
+	 *The cache doesn't know which chunks are dirty, the world writes them back before evicting a region
+	 */
+
+public:
+	//Returns the chunks of a cached region and marks it as the most recently used, counted as a hit or a miss
+	TMap<FIntVector, FChunkData>* Find(FIntVector RegionLocation);
+	TMap<FIntVector, FChunkData>& FindOrAdd(FIntVector RegionLocation);
+	bool Contains(FIntVector RegionLocation) const;
+
+	//Access that is neither counted in the stats nor changes the order of eviction
+	const TMap<FIntVector, FChunkData>* Peek(FIntVector RegionLocation) const;
+	void Remove(FIntVector RegionLocation);
+
+	//Regions are pinned while any of their chunks is referenced by a player or a loading ticket
+	void Pin(FIntVector RegionLocation);
+	void Unpin(FIntVector RegionLocation);
+	bool IsPinned(FIntVector RegionLocation) const;
+
+	//Returns the regions that are not pinned, least recently used first, as long as the resident bytes are over the budget
+	void GetEvictionCandidates(int64 ByteBudget, TArray<FIntVector>& OutCandidates);
+	int64 GetResidentBytes();
+
+	void RecordEviction();
+	void RecordWriteBack();
+	FVoxelRegionCacheStats GetStats();
+	void LogStats();
+
+	static int64 GetChunkDataBytes(const FChunkData& ChunkData);
+
+private:
+	struct FRegionCacheEntry
+	{
+		TMap<FIntVector, FChunkData> Chunks;
+		uint64 LastAccess = 0;
+		int64 Bytes = 0;
+	};
+
+	TMap<FIntVector, FRegionCacheEntry> Entries;
+	TMap<FIntVector, int32> PinCounts;
+
+	//Regions that were accessed for writing since their size was last computed
+	TSet<FIntVector> RegionsWithStaleSize;
+
+	uint64 AccessClock = 0;
+	int64 ResidentBytes = 0;
+
+	FVoxelRegionCacheStats Stats;
+
+	FRegionCacheEntry& Touch(FIntVector RegionLocation, FRegionCacheEntry& Entry);
+	void RefreshStaleSizes();
+};
@@ -0,0 +1,143 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "VoxelStructs.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+
+class IFileHandle;
+
+//What the blobs of a region file hold, each kind has its own magic in the header so that a file is never read as the other kind
+enum class EVoxelRegionFileContent : uint8
+{
+	//Chunk data encoded with FVoxelChunkCodec, upgraded to the current encoding when the file format changes
+	Chunks,
+
+	//Entries of FVoxelChunkMeshCache, copied as they are when the file format changes since their encoding is versioned on its own
+	ChunkMeshes
+};
+
+class FVoxelRegionFile
+{
+	/*Binary file holding the saved chunks of one region
+	 *Layout: a fixed-size header, then the chunk blobs, then a table giving the offset and size of the blob of every chunk, the header points to the table
+	 *Every blob is encoded on its own by FVoxelChunkCodec, so a single chunk can be read or rewritten without touching the rest of the region
+	 *Rewritten chunks are appended along with a new table and the header is updated last, the space left behind is reclaimed by Compact
+	 *Every public function locks the file, so it can be read on the region I/O thread while the game thread saves into it
+	 */
+
+public:
+	FVoxelRegionFile(const FString& InFilePath, FIntVector InRegionLocation, EVoxelRegionFileContent InContent = EVoxelRegionFileContent::Chunks);
+	~FVoxelRegionFile();
+
+	//Opens the file and reads its table, the file is created if it doesn't exist and CreateIfMissing is set
+	//A mesh cache file that can't be read is started over when CreateIfMissing is set, it only saves meshing time
+	bool Open(bool CreateIfMissing);
+	void Close();
+	bool IsOpen() const;
+
+	//Chunks are given in absolute chunk coordinates, they must belong to the region of the file
+	bool Contains(FIntVector ChunkLocation) const;
+	int32 Num() const;
+	TArray<FIntVector> GetChunkLocations() const;
+
+	bool ReadChunk(FIntVector ChunkLocation, FChunkData& OutChunkData);
+	bool WriteChunk(FIntVector ChunkLocation, const FChunkData& ChunkData);
+
+	//Writes several chunks with a single table update
+	bool WriteChunks(const TMap<FIntVector, FChunkData>& Chunks);
+	bool WriteChunks(const TMap<FIntVector, TSharedPtr<FChunkData>>& Chunks);
+
+	//Writes chunks already encoded with FVoxelChunkCodec, for bulk writers that encode on several threads, the bytes are moved out of the map
+	bool WriteEncodedChunks(TMap<FIntVector, TArray<uint8>>& EncodedChunks);
+
+	//Reads the bytes of a chunk as they were written, without decoding them. The only way to read the blobs of files that don't hold chunks
+	//The bytes of files of a previous version are in their former encoding until the file is first written to
+	bool ReadEncodedChunk(FIntVector ChunkLocation, TArray<uint8>& OutBytes);
+	bool IsCurrentVersion() const;
+
+	bool ReadRegion(TMap<FIntVector, FChunkData>& OutRegionData);
+
+	//Replaces the whole content of the file with the given chunks, leaving no unused space
+	bool WriteRegion(const TMap<FIntVector, FChunkData>& RegionData);
+
+	//Rewrites the file without the blobs and tables that are not referenced anymore
+	bool Compact();
+
+	int64 GetFileSize() const;
+	int64 GetUnusedBytes() const;
+
+	static FString GetRegionFilePath(const FString& WorldName, FIntVector RegionLocation);
+
+	//Compression applied by the chunk codec to the blobs written in region files
+	static constexpr EVoxelChunkCompression BlobCompression = EVoxelChunkCompression::LZ4;
+
+private:
+	struct FChunkEntry
+	{
+		int64 Offset = 0;
+		int32 CompressedSize = 0;
+
+		//Size of the blob before its zlib compression, only stored by version 1 files
+		int32 LegacyUncompressedSize = 0;
+	};
+
+	struct FChunkBlob
+	{
+		int32 LocalIndex = 0;
+		TArray<uint8> CompressedBytes;
+	};
+
+	FString FilePath;
+	FIntVector RegionLocation;
+	EVoxelRegionFileContent Content = EVoxelRegionFileContent::Chunks;
+	TUniquePtr<IFileHandle> FileHandle;
+
+	//Recursive, public functions call each other
+	mutable FCriticalSection FileMutex;
+
+	//Entries of the table, keyed by the index of the chunk inside the region
+	TMap<int32, FChunkEntry> ChunkTable;
+	int64 TableOffset = 0;
+	int64 UnusedBytes = 0;
+
+	bool IsInRegion(FIntVector ChunkLocation) const;
+	int32 GetLocalIndex(FIntVector ChunkLocation) const;
+	FIntVector GetChunkLocation(int32 LocalIndex) const;
+
+	bool ReadHeaderAndTable();
+	bool WriteHeader();
+	bool WriteTable();
+	bool AppendBlobs(const TArray<FChunkBlob>& Blobs);
+	bool ReplaceContent(const TArray<FChunkBlob>& Blobs);
+
+	//Puts back the file a crash left in the middle of ReplaceContent, from the .bak and .tmp files next to it
+	void RecoverInterruptedReplace() const;
+	bool ReadBlob(const FChunkEntry& Entry, TArray<uint8>& OutCompressedBytes);
+	bool AddBlob(FIntVector ChunkLocation, const FChunkData& ChunkData, TArray<FChunkBlob>& Blobs) const;
+	bool CommitBlobs(const TArray<FChunkBlob>& Blobs);
+
+	static bool EncodeChunk(const FChunkData& ChunkData, FChunkBlob& OutBlob);
+	bool DecodeChunk(const TArray<uint8>& CompressedBytes, int32 LegacyUncompressedSize, FChunkData& OutChunkData) const;
+
+	//Files of a previous version are read with their former encoding, and rewritten with the chunk codec before anything is written to them
+	bool UpgradeFormat();
+
+	//Encoding of the chunks of version 1 files: a palette of the voxel types followed by runs of identical voxels, or by the list of edits of an additive chunk, compressed with zlib
+	static bool DeserializeLegacyChunk(const TArray<uint8>& Bytes, FChunkData& OutChunkData);
+
+	//Version of the open file, the blobs of version 2 and above are encoded with FVoxelChunkCodec
+	uint32 Version = FileVersion;
+
+	static constexpr uint32 FileMagic = 0x46525643; //"CVRF"
+	static constexpr uint32 MeshFileMagic = 0x4D525643; //"CVRM"
+	uint32 GetFileMagic() const { return Content == EVoxelRegionFileContent::Chunks ? FileMagic : MeshFileMagic; }
+	static constexpr uint32 FileVersion = 2;
+	static constexpr int64 HeaderSize = 32;
+	static constexpr int64 TableEntrySize = 16;
+	static constexpr int64 LegacyTableEntrySize = 20;
+	int64 GetTableEntrySize() const { return Version >= 2 ? TableEntrySize : LegacyTableEntrySize; }
+
+	//Flags of a chunk in version 1 files
+	static constexpr uint8 ChunkAdditiveFlag = 1;
+	static constexpr uint8 ChunkSparseFlag = 2;
+};
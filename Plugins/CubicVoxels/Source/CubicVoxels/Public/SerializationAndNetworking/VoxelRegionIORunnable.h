@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "VoxelStructs.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+
+//Request to read every saved chunk of a region, sent by the game thread
+struct FVoxelRegionReadRequest
+{
+	FIntVector RegionLocation;
+	TSharedPtr<FVoxelRegionFile> RegionFile;
+
+	//Slot of the region in the former save game format, only checked when the region has no region file
+	FString LegacySaveSlot;
+};
+
+//Result of a read, sent back to the game thread
+struct FVoxelRegionReadResult
+{
+	FIntVector RegionLocation;
+	TSharedPtr<FVoxelRegionFile> RegionFile;
+
+	//Set when the region file exists and every chunk was read
+	bool RegionFileRead = false;
+
+	//Set when there is no region file but the region was saved in the former format, it must be converted on the game thread
+	bool LegacySaveFound = false;
+
+	TSharedPtr<TMap<FIntVector, FChunkData>> RegionData;
+};
+
+class FVoxelRegionIORunnable : public FRunnable
+{
+	/*Thread that reads the region files, so that the game thread never waits on the disk when a player walks into a saved area
+	 *Requests are served in the order they were sent, each one reads a whole region
+	 */
+
+public:
+	FVoxelRegionIORunnable();
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Exit() override;
+	virtual void Stop() override;
+
+	bool bShutdown = false;
+
+	//Functions used on the game thread
+	void RequestRegionRead(const FVoxelRegionReadRequest& Request);
+	int32 GetPendingReadsCount() const;
+
+	//Queues used to communicate with the game thread
+	TQueue<FVoxelRegionReadRequest, EQueueMode::Spsc> RegionReadRequestsQueue;
+	TQueue<FVoxelRegionReadResult, EQueueMode::Spsc> RegionReadResultsQueue;
+
+	void StartShutdown();
+
+	FRunnableThread* Thread = nullptr;
+
+private:
+	FThreadSafeCounter PendingReadsCount;
+
+	void ReadRegion(const FVoxelRegionReadRequest& Request);
+};
@@ -0,0 +1,34 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+
+struct FVoxelRegionSaveTask
+{
+	/*Save of the dirty chunks of one region, run on a worker thread
+	 *The chunks are a snapshot taken on the game thread, chunks edited after the snapshot are copied before being written to (copy-on-write), so the snapshot never changes while it is written
+	 */
+
+	FIntVector RegionLocation;
+	TSharedPtr<FVoxelRegionFile> RegionFile;
+
+	//Slot of the region in the former save game format, a region that still has one must be converted on the game thread before it is written
+	FString LegacySaveSlot;
+
+	TMap<FIntVector, TSharedPtr<FChunkData>> Chunks;
+
+	//Encoded mesh cache entries of the region, written to its mesh cache file once the chunks are written. A task may only carry meshes
+	TSharedPtr<FVoxelRegionFile> MeshCacheFile;
+	TMap<FIntVector, TArray<uint8>> ChunkMeshes;
+
+	//Results, set by Run
+	bool Success = false;
+	bool LegacySaveFound = false;
+	double WriteTime = 0;
+
+	//Serializes, compresses and writes the chunks into the region file
+	void Run();
+
+private:
+	bool WriteChunks();
+};
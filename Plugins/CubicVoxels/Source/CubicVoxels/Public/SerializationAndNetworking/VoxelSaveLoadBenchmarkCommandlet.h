@@ -0,0 +1,67 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelStructs.h"
+#include "VoxelSaveLoadBenchmarkCommandlet.generated.h"
+
+//Generates regions with the world's generation function, applies a scripted pattern of edits, then saves, reloads and verifies them with every save format and logs the throughput of each one
+//Usage: -run=VoxelSaveLoadBenchmark [-Regions=4] [-ChunksPerRegion=256] [-EditsPerChunk=64] [-Seed=0] [-WorldClass=ClassPath] [-SaveGame] [-Csv=Path] [-Keep]
+//-SaveGame also measures the former save game format, which is much slower. -Csv appends one line per format to the given file, for nightly runs to track regressions
+//Returns 1 if any chunk read back differs from the chunk that was saved
+UCLASS()
+class CUBICVOXELS_API UVoxelSaveLoadBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelSaveLoadBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	//Chunks saved by every format, they are kept to be compared voxel by voxel with the chunks read back
+	struct FBenchmarkChunks
+	{
+		TArray<FIntVector> Regions;
+		TArray<FIntVector> ChunkLocations;
+		TArray<TSharedPtr<FChunkData>> Chunks;
+		TArray<int32> RegionIndices; //Index in Regions of the region of each chunk
+		int32 AdditiveChunks = 0;
+	};
+
+	struct FFormatResult
+	{
+		FString Format;
+		int64 Bytes = 0;
+		double WriteTime = 0;
+		double ReadTime = 0;
+
+		//Time to make the saved data readable before any chunk is read, only the world pack has one
+		double OpenTime = 0;
+
+		int32 ChunksRead = 0;
+		int32 Mismatches = 0;
+
+		//Growth of the resident memory of the process during each phase, before what it read or wrote is released
+		uint64 WriteMemory = 0;
+		uint64 ReadMemory = 0;
+	};
+
+	//Chunks of a region are a slab of columns around the surface of the default terrain, then chunks that only hold edits next to them
+	static void GenerateChunks(FBenchmarkChunks& OutChunks, const struct FVoxelWorldGenerator& Generator, int32 NumberOfRegions, int32 ChunksPerRegion, int32 EditsPerChunk, int32 Seed);
+
+	//Counts the chunks read back whose voxels differ from the saved ones, or that were not read back at all
+	static int32 VerifyChunks(const FBenchmarkChunks& SavedChunks, const TMap<FIntVector, const FChunkData*>& ReadChunks);
+	static bool AreChunksEqual(const FChunkData& SavedChunk, const FChunkData& ReadChunk);
+
+	//Region files are saved and read by a voxel world of the given class, the same way as in game
+	static FFormatResult BenchmarkVoxelWorld(const FBenchmarkChunks& SavedChunks, UClass* WorldClass, const FString& WorldName);
+	static FFormatResult BenchmarkWorldPack(const FBenchmarkChunks& SavedChunks, const FString& WorldName);
+	static FFormatResult BenchmarkSaveGame(const FBenchmarkChunks& SavedChunks, const FString& WorldName);
+
+	static void LogResult(const FFormatResult& Result, int32 NumberOfChunks);
+	static void AppendCsv(const FString& CsvPath, const FFormatResult& Result, int32 NumberOfRegions, int32 NumberOfChunks);
+
+	static uint64 GetUsedMemory();
+	static uint64 GetMemoryGrowth(uint64 UsedMemoryBefore);
+};
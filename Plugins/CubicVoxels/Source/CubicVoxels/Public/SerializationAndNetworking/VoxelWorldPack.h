@@ -0,0 +1,112 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class IFileHandle;
+
+class FVoxelWorldPack
+{
+	/*Read-only file holding the chunks of many regions of an authored world, the base the saved edits of the players are applied on
+	 *Layout: a fixed-size header, then the chunk blobs, then the region index and the chunk index, the header points to both indices
+	 *Region index: one entry per region sorted by region location, giving the range of its chunks in the chunk index
+	 *Chunk index: the chunks of every region sorted by their index inside the region, each one the offset and size of its blob
+	 *Blobs are encoded with FVoxelChunkCodec, as in region files. Integers are little-endian
+	 *The file is memory-mapped and nothing is read when it is opened but the header, a chunk is found with two binary searches and decoded straight from the mapping
+	 *The pack is never written to once it is built, so any thread may read it without locking
+	 */
+
+public:
+	~FVoxelWorldPack();
+
+	bool Open(const FString& InFilePath);
+	void Close();
+	bool IsOpen() const;
+
+	//Chunks are given in absolute chunk coordinates
+	bool Contains(FIntVector ChunkLocation) const;
+	bool ContainsRegion(FIntVector RegionLocation) const;
+	bool ReadChunk(FIntVector ChunkLocation, FChunkData& OutChunkData) const;
+
+	int32 GetNumberOfRegions() const;
+	int32 GetNumberOfChunks() const;
+	int64 GetFileSize() const;
+
+	//Resolves the pack path of a world relative to the project's content directory, packs must be staged as loose files to be mapped
+	static FString GetPackFilePath(const FString& PackPath);
+
+private:
+	friend class FVoxelWorldPackWriter;
+
+	FString FilePath;
+	TUniquePtr<IMappedFileHandle> MappedFileHandle;
+	TUniquePtr<IMappedFileRegion> MappedFileRegion;
+
+	//Platforms that can't map the file read it whole instead
+	TArray<uint8> FileBytes;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	int32 NumberOfRegions = 0;
+	int32 NumberOfChunks = 0;
+	int64 RegionIndexOffset = 0;
+	int64 ChunkIndexOffset = 0;
+
+	bool ReadHeader();
+
+	//Returns the index of the region in the region index, or -1
+	int32 FindRegion(FIntVector RegionLocation) const;
+
+	//Returns the blob of a chunk, or nullptr
+	const uint8* FindChunkBlob(FIntVector ChunkLocation, int32& OutBlobSize) const;
+
+	static FIntVector GetRegionOfChunk(FIntVector ChunkLocation);
+	static int32 GetLocalIndex(FIntVector ChunkLocation, FIntVector RegionLocation);
+	static bool IsRegionBefore(FIntVector A, FIntVector B);
+
+	static int32 ReadInt32(const uint8* Bytes);
+	static int64 ReadInt64(const uint8* Bytes);
+
+	static constexpr uint32 FileMagic = 0x50575643; //"CVWP"
+	static constexpr uint32 FileVersion = 1;
+	static constexpr int64 HeaderSize = 32;
+	static constexpr int64 RegionEntrySize = 20;
+	static constexpr int64 ChunkEntrySize = 16;
+};
+
+class FVoxelWorldPackWriter
+{
+	/*Builds a world pack one region at a time, so that only the blobs of one region and the indices are kept in memory
+	 *Regions may be added in any order, the indices are sorted when the pack is finished
+	 */
+
+public:
+	~FVoxelWorldPackWriter();
+
+	bool Open(const FString& InFilePath);
+
+	//Appends the chunks of a region already encoded with FVoxelChunkCodec, chunks outside of the region are ignored
+	bool AddRegion(FIntVector RegionLocation, const TMap<FIntVector, TArray<uint8>>& EncodedChunks);
+
+	//Writes the indices and the header, the pack can't be read before
+	bool Finish();
+
+	int32 GetNumberOfChunks() const;
+
+private:
+	struct FChunkEntry
+	{
+		int32 LocalIndex = 0;
+		int32 Size = 0;
+		int64 Offset = 0;
+	};
+
+	FString FilePath;
+	TUniquePtr<IFileHandle> FileHandle;
+	int64 WriteOffset = 0;
+	TMap<FIntVector, TArray<FChunkEntry>> Regions;
+
+	bool Write(const TArray<uint8>& Bytes);
+};
@@ -0,0 +1,18 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelWorldPackCommandlet.generated.h"
+
+//Builds a read-only world pack from the region files of an authored world, to be set as the BaseWorldPack of the worlds played on it
+//Usage: -run=VoxelWorldPack -Output=Path [-World=WorldName] [-WorldClass=/Game/Path/BP_VoxelWorld.BP_VoxelWorld_C]
+//A relative output path is relative to the project's content directory. The blobs of the region files are copied as they are, without being decoded
+UCLASS()
+class CUBICVOXELS_API UVoxelWorldPackCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelWorldPackCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+//Stages a chunk goes through before it is visible in game, in pipeline order
+//Each stage only runs once its inputs (the chunk's own previous stage and, for side meshing, the neighbour's data) are ready
+enum class EChunkPipelineStage : uint8
+{
+	Requested,	//A generation or meshing order has been sent to a worker thread
+	Generated,	//The voxel data has reached the game thread and the chunk actor exists
+	Meshed,		//The inside geometry has been received, side geometry follows as neighbours become generated
+	Uploaded,	//The geometry has been sent to the procedural mesh at least once
+	Num
+};
+
+struct FChunkPipelineState
+{
+	/*Progress of a single chunk through the pipeline*/
+
+	EChunkPipelineStage Stage = EChunkPipelineStage::Requested;
+
+	//Bit i is set once the side meshing of direction i has been issued, so that it is never issued twice whatever the arrival order of chunks
+	uint8 IssuedSidesMask = 0;
+
+	//Bit i is set once the side geometry of direction i has been received
+	uint8 MeshedSidesMask = 0;
+
+	//Set when new geometry was added to the chunk and it must be sent to its mesh
+	bool NeedsUpload = false;
+
+	double RequestTime = 0;
+
+	//Set when the chunk was in front of the camera of the nearest player when it was requested
+	bool RequestedInFront = false;
+};
+
+struct FChunkPipelineStats
+{
+	/*Measurements of the pipeline's throughput and of the latency of each stage, counted from the chunk's request*/
+
+	int32 ChunksEnteringStage[static_cast<int32>(EChunkPipelineStage::Num)] = {};
+	double TotalLatencyToStage[static_cast<int32>(EChunkPipelineStage::Num)] = {};
+	double MaxLatencyToStage[static_cast<int32>(EChunkPipelineStage::Num)] = {};
+
+	int32 SideMeshingsIssued = 0;
+	int32 SideMeshingsReceived = 0;
+	int32 Uploads = 0;
+
+	//Chunks whose inside geometry was read from the mesh cache instead of being meshed
+	int32 InsideMeshesFromCache = 0;
+
+	//Time to visible of the chunks requested in front of a player, which the loading priority is meant to reduce
+	int32 InFrontChunksUploaded = 0;
+	double TotalInFrontLatencyToUpload = 0;
+
+	double StartTime = 0;
+};
+
+class FChunkPipeline
+{
+	/*Dependency-aware scheduler that tracks the stage reached by every chunk and decides which stages are ready to run
+	 * It only lives on the game thread, worker threads are fed with orders once their inputs are ready
+	 */
+
+public:
+	FChunkPipeline();
+
+	//Stage transitions
+	void OnChunkRequested(FIntVector ChunkLocation, bool InFront = false);
+	void OnChunkGenerated(FIntVector ChunkLocation);
+	void OnInsideGeometryReceived(FIntVector ChunkLocation, bool FromCache = false);
+	void OnSideGeometryReceived(FIntVector ChunkLocation, int32 DirectionIndex);
+	void OnChunkUploaded(FIntVector ChunkLocation);
+	void OnChunkRemoved(FIntVector ChunkLocation);
+
+	//Returns true iff the chunk has reached the given stage
+	bool HasReachedStage(FIntVector ChunkLocation, EChunkPipelineStage Stage) const;
+
+	//Returns the directions in which the meshing of a side of the chunk is ready and has not been issued yet, and marks them as issued on both chunks
+	TArray<int32> ClaimReadySideMeshings(FIntVector ChunkLocation);
+
+	//Returns the chunks whose mesh must be rebuilt and clears their upload flag
+	TArray<FIntVector> ConsumeChunksToUpload();
+
+	const FChunkPipelineStats& GetStats() const;
+	void LogStats() const;
+
+	static const FIntVector Directions[6];
+	static const int32 OppositeDirections[6];
+
+private:
+	TMap<FIntVector, FChunkPipelineState> ChunkPipelineStates;
+	TSet<FIntVector> ChunksToUpload;
+
+	FChunkPipelineStats Stats;
+
+	void EnterStage(FChunkPipelineState& State, EChunkPipelineStage Stage);
+};
@@ -13,29 +13,62 @@ struct FChunkThreadedWorkOrderBase
 	TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* OutputChunkDataQueuePtr;
 	TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* GeneratedChunkGeometryToLoadQueuePtr;
 
-	FVoxel (*GenerationFunction) (FVector);
+	FVoxelWorldGenerator Generator;
 	TSharedPtr<FChunkData> TargetChunkDataPtr;
 
+	//Mesh cache of the chunk's region, meshing orders read the chunk's inside geometry from it when it is up to date
+	TSharedPtr<FVoxelRegionFile> MeshCacheFile;
+
+	//Chunk taken from the cache of unloaded chunks
+	TSharedPtr<FUnloadedChunk> UnloadedChunk;
+
+	//Pack the chunk is decoded from, the target chunk data then holds the edits saved on top of it if there are any
+	TSharedPtr<const FVoxelWorldPack> WorldPack;
+
 	//Data specific to chunk sides generation orders
 	TSharedPtr<FChunkData> NeighboringChunkDataPtr;
 	int32 DirectionIndex;
 
+	//Relative cost of the order, used to balance orders between generation threads
+	int32 GetCost() const
+	{
+		switch (OrderType)
+		{
+		case EChunkThreadedWorkOrderType::GenerationAndMeshing:
+			return 16;
+		case EChunkThreadedWorkOrderType::GeneratingAndMeshingWithAdditiveData:
+			return 18;
+		case EChunkThreadedWorkOrderType::MeshingFromData:
+			return 6;
+		case EChunkThreadedWorkOrderType::GeneratingExistingChunksSides:
+			return 1;
+		case EChunkThreadedWorkOrderType::GenerationOnly:
+			return 10;
+		case EChunkThreadedWorkOrderType::LoadingUnloadedChunk:
+			return UnloadedChunk.IsValid() && UnloadedChunk->HasInsideQuads() ? 2 : 6;
+		case EChunkThreadedWorkOrderType::LoadingFromWorldPack:
+			return GeneratedChunkGeometryToLoadQueuePtr ? 7 : 1;
+		default:
+			return 1;
+		}
+	}
+
 	//Method that generates the underlying chunk
 	void SendOrder()
 	{
 		if (OrderType == EChunkThreadedWorkOrderType::GenerationAndMeshing)
 		{
-			GenerateChunkDataAndComputeInsideFaces(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, GenerationFunction);
+			GenerateChunkDataAndComputeInsideFaces(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, Generator);
 		}
 
 		if (OrderType == EChunkThreadedWorkOrderType::GeneratingAndMeshingWithAdditiveData)
 		{
-			GenerateUnloadedDataAndComputeInsideFaces(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, GenerationFunction, TargetChunkDataPtr);
+			GenerateUnloadedDataAndComputeInsideFaces(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, Generator, TargetChunkDataPtr);
 		}
 
 		if (OrderType == EChunkThreadedWorkOrderType::MeshingFromData)
 		{
-			ComputeInsideFacesOfLoadedChunk(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, TargetChunkDataPtr);
+			ComputeInsideFacesOfLoadedChunk(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, TargetChunkDataPtr, MeshCacheFile);
 		}
 
 		if(OrderType == EChunkThreadedWorkOrderType::GeneratingExistingChunksSides)
@@ -43,6 +76,21 @@ struct FChunkThreadedWorkOrderBase
 			//GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Yellow, TEXT("Launching order for chunk sides generation"));
 			ComputeChunkSideFacesFromData(TargetChunkDataPtr, NeighboringChunkDataPtr, DirectionIndex, GeneratedChunkGeometryToLoadQueuePtr, ChunkLocation);
 		}
+
+		if (OrderType == EChunkThreadedWorkOrderType::GenerationOnly)
+		{
+			GenerateChunkDataOnly(ChunkLocation, OutputChunkDataQueuePtr, Generator, TargetChunkDataPtr);
+		}
+
+		if (OrderType == EChunkThreadedWorkOrderType::LoadingUnloadedChunk)
+		{
+			LoadUnloadedChunk(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, Generator, UnloadedChunk);
+		}
+
+		if (OrderType == EChunkThreadedWorkOrderType::LoadingFromWorldPack)
+		{
+			LoadChunkFromWorldPack(ChunkLocation, OutputChunkDataQueuePtr, GeneratedChunkGeometryToLoadQueuePtr, Generator, WorldPack, TargetChunkDataPtr);
+		}
 		
 	};
 
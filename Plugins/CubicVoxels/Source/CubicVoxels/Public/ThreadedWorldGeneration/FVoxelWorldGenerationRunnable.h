@@ -1,7 +1,9 @@
 ﻿// .h
 #pragma once
 #include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "ChunkThreadingStructs.h"
+#include "ChunkLoading/ChunkLoadingPriority.h"
 
 class FVoxelWorldGenerationRunnable : public FRunnable {
 public:
@@ -14,25 +16,34 @@ public:
 
 	bool bShutdown= false;
 
-	//Functions to retrieve pointers to the queues used to communicate with the game thread, they are used on the game thread
-	TQueue< FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* GetGenerationOrdersQueue();
+	//Functions used on the game thread to give orders to the thread and to know how busy it is
+	void AddOrder(const FChunkThreadedWorkOrderBase& Order);
+	int32 GetPendingOrdersCost() const;
+	int32 GetPendingOrdersCount() const;
+	int32 GetCompletedOrdersCount() const;
 	
 	//Queue used to communicate with the game thread
 	TQueue< FChunkThreadedWorkOrderBase, EQueueMode::Mpsc> ChunkThreadedWorkOrdersQueue;
 
 	void StartShutdown();
 	
-	//FIntVector PlayerRelativeLocation;
-	TMap<int32, FIntVector> ManagedPlayersPositionsMap;
+	//Loading anchors of the managed players, set from the game thread and used to sort the orders
+	void SetLoadingAnchors(const TArray<FChunkLoadingAnchor>& Anchors);
 
 	FRunnableThread* Thread = nullptr;
 
 private:
 	
-	
-	TArray<FChunkThreadedWorkOrderBase> SortedByDistanceToPlayerChunkBuffer;
+	TArray<FChunkLoadingAnchor> LoadingAnchors;
+	FCriticalSection LoadingAnchorsMutex;
 
-	bool IsCloserToNearestPlayer(FChunkThreadedWorkOrderBase A, FChunkThreadedWorkOrderBase B, const TMap<int32, FIntVector>& ManagedPlayersPositionsMapConstCopy);
+	//Live load of the thread, incremented when an order is added and decremented when it is done
+	FThreadSafeCounter PendingOrdersCost;
+	FThreadSafeCounter PendingOrdersCount;
+	FThreadSafeCounter CompletedOrdersCount;
+	
+	//Orders waiting to be sent, along with their priority
+	TArray<TTuple<float, FChunkThreadedWorkOrderBase>> SortedByPriorityChunkBuffer;
 
 protected:
 	
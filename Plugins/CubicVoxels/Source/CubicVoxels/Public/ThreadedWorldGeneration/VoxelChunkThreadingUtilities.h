@@ -1,6 +1,12 @@
 ﻿#pragma once
 #include "VoxelStructs.h"
 #include "GlobalPluginParameters.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "SerializationAndNetworking/VoxelChunkMeshCache.h"
+#include "SerializationAndNetworking/VoxelChunkCodec.h"
+#include "SerializationAndNetworking/VoxelWorldPack.h"
+#include "ChunkLoading/UnloadedChunkCache.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
 
 //constant arrays helpful to build the triangles of a chunk's mesh
 const  FVector BlockVertexData[8] = {
@@ -23,7 +29,7 @@ const int BlockTriangleData[24] = {
 	3,2,7,6  // Down
 };
 	
-static void GenerateChunkDataAndComputeInsideFaces(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  FVoxel (*GenerationFunction) (FVector))
+static void GenerateChunkDataAndComputeInsideFaces(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  const FVoxelWorldGenerator& Generator)
 {
 	/*Function to generate procedurally a chunk and its mesh data*/
 	
@@ -34,29 +40,19 @@ static void GenerateChunkDataAndComputeInsideFaces(FIntVector Coordinates, TQueu
 	const TSharedPtr<FChunkData> ChunkDataPtr(new FChunkData);
 
 	//Fill the arrays with the chunk's voxels
-	for (int32 x = 0; x < ChunkSize; x++)
-	{
-		for (int32 y = 0; y < ChunkSize; y++)
-		{
-			for (int32 z = 0; z < ChunkSize; z++)
-			{
-				auto const Position = DefaultVoxelSize*FVector(x + ChunkSize*Coordinates.X, y + ChunkSize*Coordinates.Y , z + ChunkSize*Coordinates.Z);
-					
-				ChunkDataPtr->SetVoxel(x,y,z, (*GenerationFunction)(Position));
-					
-			}
-		}
-	}
+	Generator.GenerateChunk(Coordinates, *ChunkDataPtr);
 	
 
 	// float TimeElapsedInMs = (FDateTime::UtcNow() - StartTime).GetTotalMilliseconds(); 
 	// UE_LOG(LogTemp, Warning, TEXT("Time taken to generate: %f"), TimeElapsedInMs);
 	// StartTime = FDateTime::UtcNow(); 
 		
-	//Generate the chunk's quads data
+	//Generate the chunk's quads data, a uniform chunk has none
 	TMap<FIntVector4, FVoxel> QuadsData;
+	FVoxel UniformVoxel;
+	const bool IsUniform = ChunkDataPtr->IsUniform(UniformVoxel);
 	
-	for (int x = 0; x < ChunkSize; ++x)
+	for (int x = 0; x < ChunkSize && !IsUniform; ++x)
 	{
 		for (int y = 0; y < ChunkSize; ++y)
 		{
@@ -99,36 +95,30 @@ static void GenerateChunkDataAndComputeInsideFaces(FIntVector Coordinates, TQueu
 	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, ChunkDataPtr));
 }
 
-static void GenerateUnloadedDataAndComputeInsideFaces(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  FVoxel (*GenerationFunction) (FVector),  TSharedPtr<FChunkData> ChunkDataPtr)
+static TSharedPtr<FChunkData> GenerateOnTopOfAdditiveData(FIntVector Coordinates, const FVoxelWorldGenerator& Generator, const FChunkData& AdditiveChunkData)
+{
+	/*Generate every voxel of the chunk, then apply its edits. Sparse additive data is applied in O(edits), dense legacy data still needs a full pass*/
+	const TSharedPtr<FChunkData> ChunkDataPtr = MakeShared<FChunkData>();
+	Generator.GenerateChunk(Coordinates, *ChunkDataPtr);
+
+	ChunkDataPtr->ApplyAsAdditive(AdditiveChunkData);
+	return ChunkDataPtr;
+}
+
+static void GenerateUnloadedDataAndComputeInsideFaces(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  const FVoxelWorldGenerator& Generator,  TSharedPtr<FChunkData> AdditiveChunkDataPtr)
 {
 	/*Generate a chunk defined additively based on the procedural generator, then generate its mesh data*/
 	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Blue, TEXT("Starting to generate from additive data"));	
 
 	//Fill the arrays with the chunk's voxels
-	for (int32 x = 0; x < ChunkSize; x++)
-	{
-		for (int32 y = 0; y < ChunkSize; y++)
-		{
-			for (int32 z = 0; z < ChunkSize; z++)
-			{
-				if (!ChunkDataPtr->GetVoxelAt(x,y,z))
-				{
-					auto const Position = DefaultVoxelSize*FVector(x + ChunkSize*Coordinates.X, y + ChunkSize*Coordinates.Y , z + ChunkSize*Coordinates.Z);
-					
-					ChunkDataPtr->SetVoxel(x,y,z, (*GenerationFunction)(Position));
-				}
-				
-				// FString MyFooString = (ChunkDataPtr->GetVoxelAt(x,y,z).VoxelType).ToString();
-				// const TCHAR* tchar_is_wchar_t_under_the_hood = *MyFooString;
-				// UE_LOG(LogTemp, Display, TEXT("Generated a voxel of type %s"), tchar_is_wchar_t_under_the_hood )
-			}
-		}
-	}
+	const TSharedPtr<FChunkData> ChunkDataPtr = GenerateOnTopOfAdditiveData(Coordinates, Generator, *AdditiveChunkDataPtr);
 		
-	//Generate the chunk's quads data
+	//Generate the chunk's quads data, a uniform chunk has none
 	TMap<FIntVector4, FVoxel> QuadsData;
+	FVoxel UniformVoxel;
+	const bool IsUniform = ChunkDataPtr->IsUniform(UniformVoxel);
 	
-	for (int x = 0; x < ChunkSize; ++x)
+	for (int x = 0; x < ChunkSize && !IsUniform; ++x)
 	{
 		for (int y = 0; y < ChunkSize; ++y)
 		{
@@ -170,20 +160,30 @@ static void GenerateUnloadedDataAndComputeInsideFaces(FIntVector Coordinates, TQ
 	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, ChunkDataPtr));
 }
 
-static void ComputeInsideFacesOfLoadedChunk(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  TSharedPtr<FChunkData> CompressedChunkBlocksPtr)
+static void GenerateChunkDataOnly(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, const FVoxelWorldGenerator& Generator, TSharedPtr<FChunkData> AdditiveChunkDataPtr)
 {
-	/*Generate the mesh data of a chunk whose voxel data is already accessible*/
-		
-	//Generate the chunk's quads data
+	/*Generate the voxel data of a chunk without meshing it, on top of its additive data if it has any*/
+	const FChunkData NoEdits = FChunkData::SparseAdditiveChunkData();
+	const TSharedPtr<FChunkData> ChunkDataPtr = GenerateOnTopOfAdditiveData(Coordinates, Generator, AdditiveChunkDataPtr.IsValid() ? *AdditiveChunkDataPtr : NoEdits);
+
+	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, ChunkDataPtr));
+}
+
+static TMap<FIntVector4, FVoxel> ComputeInsideQuads(const FChunkData& ChunkData)
+{
+	/*Compute the quads between the voxels of a chunk, the quads of its sides need the neighbouring chunks*/
+	
 	TMap<FIntVector4, FVoxel> QuadsData;
+	FVoxel UniformVoxel;
+	const bool IsUniform = ChunkData.IsUniform(UniformVoxel);
 	
-	for (int x = 0; x < ChunkSize; ++x)
+	for (int x = 0; x < ChunkSize && !IsUniform; ++x)
 	{
 		for (int y = 0; y < ChunkSize; ++y)
 		{
 			for (int z = 0; z < ChunkSize; ++z)
 			{
-				const auto CurrentBlock =  CompressedChunkBlocksPtr->GetVoxelAt(FIntVector3(x,y,z));
+				const auto CurrentBlock =  ChunkData.GetVoxelAt(FIntVector3(x,y,z));
 
 				if (CurrentBlock.VoxelType != "Air" )
 				{
@@ -200,7 +200,7 @@ static void ComputeInsideFacesOfLoadedChunk(FIntVector Coordinates, TQueue< TTup
 					{
 						if (Directions[i].X >= 0 && Directions[i].X < ChunkSize && Directions[i].Y >= 0 && Directions[i].Y < ChunkSize && Directions[i].Z >= 0 && Directions[i].Z < ChunkSize) 
 						{
-							const auto CurrentNeighbour = CompressedChunkBlocksPtr->GetVoxelAt(Directions[i]);
+							const auto CurrentNeighbour = ChunkData.GetVoxelAt(Directions[i]);
 							if (CurrentNeighbour.IsTransparent == true && (CurrentNeighbour != CurrentBlock) ) 
 							{
 								QuadsData.Add(FIntVector4(x,y,z,i), CurrentBlock);
@@ -212,12 +212,120 @@ static void ComputeInsideFacesOfLoadedChunk(FIntVector Coordinates, TQueue< TTup
 		}
 	}
 
+	return QuadsData;
+}
+
+static bool LoadCachedInsideFaces(FIntVector Coordinates, TSharedPtr<FChunkGeometry>& OutGeometry, const FChunkData& ChunkData, FVoxelRegionFile& MeshCacheFile)
+{
+	/*Read the inside geometry of a chunk from the mesh cache, it is only used if it was meshed from the same voxels*/
+	TArray<uint8> EncodedMesh;
+	if (!MeshCacheFile.Open(false) || !MeshCacheFile.ReadEncodedChunk(Coordinates, EncodedMesh))
+	{
+		return false;
+	}
+
+	uint32 CachedDataHash = 0;
+	auto CachedGeometry = MakeShared<FChunkGeometry>();
+	if (!FVoxelChunkMeshCache::Decode(EncodedMesh, CachedDataHash, CachedGeometry->Geometry) || CachedDataHash != FVoxelChunkMeshCache::HashChunkData(ChunkData))
+	{
+		return false;
+	}
+
+	CachedGeometry->ChunkLocation = Coordinates;
+	CachedGeometry->DirectionIndex = -1;
+	CachedGeometry->FromCache = true;
+	OutGeometry = CachedGeometry;
+	return true;
+}
+
+static void ComputeInsideFacesOfLoadedChunk(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr,  TSharedPtr<FChunkData> CompressedChunkBlocksPtr, TSharedPtr<FVoxelRegionFile> MeshCacheFile)
+{
+	/*Generate the mesh data of a chunk whose voxel data is already accessible, or read it from the mesh cache of its region if it is given one*/
+
+	TSharedPtr<FChunkGeometry> GeneratedGeometry;
+	if (!MeshCacheFile.IsValid() || !LoadCachedInsideFaces(Coordinates, GeneratedGeometry, *CompressedChunkBlocksPtr, *MeshCacheFile))
+	{
+		GeneratedGeometry = MakeShared<FChunkGeometry>();
+		GeneratedGeometry->ChunkLocation = Coordinates;
+		GeneratedGeometry->Geometry = ComputeInsideQuads(*CompressedChunkBlocksPtr);
+		GeneratedGeometry->DirectionIndex = -1;
+	}
+	
+	ChunkGeometryLoadingQueuePtr->Enqueue(GeneratedGeometry);
+	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, CompressedChunkBlocksPtr));
+}
+
+static void LoadUnloadedChunk(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr, const FVoxelWorldGenerator& Generator, TSharedPtr<FUnloadedChunk> UnloadedChunk)
+{
+	/*Bring back a chunk from the cache of unloaded chunks, its inside geometry is only meshed again if it was not kept with it*/
+	TSharedPtr<FChunkData> ChunkDataPtr = UnloadedChunk->ChunkData;
+	if (!ChunkDataPtr.IsValid())
+	{
+		ChunkDataPtr = MakeShared<FChunkData>();
+		if (!FVoxelChunkCodec::Decode(UnloadedChunk->EncodedChunkData, *ChunkDataPtr))
+		{
+			//The saved data of the chunk, if any, is left untouched and is read again the next time it is loaded
+			UE_LOG(LogTemp, Error, TEXT("Could not decode unloaded chunk %d, %d, %d, generating it instead"), Coordinates.X, Coordinates.Y, Coordinates.Z)
+			GenerateChunkDataAndComputeInsideFaces(Coordinates, PreCookedChunksToLoadBlockData, ChunkGeometryLoadingQueuePtr, Generator);
+			return;
+		}
+	}
+
 	auto GeneratedGeometry = MakeShared<FChunkGeometry>();
 	GeneratedGeometry->ChunkLocation = Coordinates;
-	GeneratedGeometry->Geometry = QuadsData;
 	GeneratedGeometry->DirectionIndex = -1;
+
+	uint32 DataHash = 0;
+	if (UnloadedChunk->InsideQuads.IsValid())
+	{
+		GeneratedGeometry->Geometry = *UnloadedChunk->InsideQuads;
+	}
+	else if (UnloadedChunk->EncodedInsideQuads.Num() == 0 || !FVoxelChunkMeshCache::Decode(UnloadedChunk->EncodedInsideQuads, DataHash, GeneratedGeometry->Geometry))
+	{
+		GeneratedGeometry->Geometry = ComputeInsideQuads(*ChunkDataPtr);
+	}
+
 	ChunkGeometryLoadingQueuePtr->Enqueue(GeneratedGeometry);
-	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, CompressedChunkBlocksPtr));
+	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, ChunkDataPtr));
+}
+
+static TSharedPtr<FChunkData> ResolveWorldPackChunk(FIntVector Coordinates, const FVoxelWorldGenerator& Generator, const FVoxelWorldPack& WorldPack, const FChunkData* AdditiveChunkData)
+{
+	/*Decode a chunk from the world pack and apply the edits saved on top of it
+	 *Chunks of the pack that are themselves additive are applied on top of the generator, like additive saved data
+	 */
+	const FChunkData NoEdits = FChunkData::SparseAdditiveChunkData();
+	TSharedPtr<FChunkData> ChunkDataPtr = MakeShared<FChunkData>();
+	if (!WorldPack.ReadChunk(Coordinates, *ChunkDataPtr))
+	{
+		ChunkDataPtr = GenerateOnTopOfAdditiveData(Coordinates, Generator, NoEdits);
+	}
+	else if (ChunkDataPtr->IsAdditive)
+	{
+		ChunkDataPtr = GenerateOnTopOfAdditiveData(Coordinates, Generator, *ChunkDataPtr);
+	}
+
+	if (AdditiveChunkData)
+	{
+		ChunkDataPtr->ApplyAsAdditive(*AdditiveChunkData);
+	}
+	return ChunkDataPtr;
+}
+
+static void LoadChunkFromWorldPack(FIntVector Coordinates, TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc>* PreCookedChunksToLoadBlockData, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr, const FVoxelWorldGenerator& Generator, TSharedPtr<const FVoxelWorldPack> WorldPack, TSharedPtr<FChunkData> AdditiveChunkDataPtr)
+{
+	/*Its inside geometry is only computed if a geometry queue is given*/
+	const TSharedPtr<FChunkData> ChunkDataPtr = ResolveWorldPackChunk(Coordinates, Generator, *WorldPack, AdditiveChunkDataPtr.Get());
+
+	if (ChunkGeometryLoadingQueuePtr)
+	{
+		auto GeneratedGeometry = MakeShared<FChunkGeometry>();
+		GeneratedGeometry->ChunkLocation = Coordinates;
+		GeneratedGeometry->Geometry = ComputeInsideQuads(*ChunkDataPtr);
+		GeneratedGeometry->DirectionIndex = -1;
+		ChunkGeometryLoadingQueuePtr->Enqueue(GeneratedGeometry);
+	}
+	PreCookedChunksToLoadBlockData->Enqueue(MakeTuple(Coordinates, ChunkDataPtr));
 }
 
 static int32 Modulo(int32 Number, int32 N) 
@@ -239,6 +347,14 @@ static FIntVector NormaliseCyclicalCoordinates(FIntVector Coordinates, int32 Nor
 	return FIntVector( Modulo(Coordinates.X,  Norm), Modulo(Coordinates.Y , Norm), Modulo(Coordinates.Z , Norm));
 }
 
+static bool HasNoSideFaces(const FChunkData& ChunkData, const FChunkData& NeighbourChunkData)
+{
+	/*Faces are only added to voxels other than air facing a different transparent voxel, which a uniform chunk of air or two uniform chunks of opaque or identical voxels never have*/
+	FVoxel UniformVoxel;
+	FVoxel NeighbourUniformVoxel;
+	return ChunkData.IsUniform(UniformVoxel) && (UniformVoxel.VoxelType == "Air" || (NeighbourChunkData.IsUniform(NeighbourUniformVoxel) && (NeighbourUniformVoxel == UniformVoxel || !NeighbourUniformVoxel.IsTransparent)));
+}
+
 static void ComputeChunkSideFacesFromData(TSharedPtr<FChunkData> DataOfChunkToAddFacesTo, TSharedPtr<FChunkData> NeighbourChunkBlocks, int32 DirectionIndex, TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc>* ChunkGeometryLoadingQueuePtr, FIntVector ChunkToAddFacesToCoordinates)
 {
 	/*Function to compute the faces of a chunks' sides*/
@@ -285,8 +401,10 @@ static void ComputeChunkSideFacesFromData(TSharedPtr<FChunkData> DataOfChunkToAd
 	//Generate the chunk's side's quads data
 
 	TMap<FIntVector4, FVoxel> SideGeometryData;
+
+	const bool HasNoFace = HasNoSideFaces(*DataOfChunkToAddFacesTo, *NeighbourChunkBlocks);
 		
-	for (int x = 0; x < ChunkSize; ++x)
+	for (int x = 0; x < ChunkSize && !HasNoFace; ++x)
 	{
 		for (int y = 0; y < ChunkSize; ++y)
 		{
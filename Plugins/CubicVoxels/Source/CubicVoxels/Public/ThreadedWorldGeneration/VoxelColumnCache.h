@@ -0,0 +1,54 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "AdditionOrderLRU.h"
+
+//Values of the column function of the generator for a column of chunks, shared by every chunk stacked in the column
+struct FVoxelChunkColumn
+{
+	//One value per column of voxels, at x*ChunkSize + y
+	TArray<float> Values;
+	float MinValue = 0;
+	float MaxValue = 0;
+};
+
+struct FVoxelColumnCacheStats
+{
+	int64 Hits = 0;
+	int64 Misses = 0;
+	int64 Evictions = 0;
+	int64 Removals = 0;
+
+	int64 ResidentBytes = 0;
+	int32 ResidentColumns = 0;
+};
+
+class FVoxelColumnCache
+{
+	/*Column data of the generator, computed by the first chunk of a column to be generated and reused by the chunks above and below it
+	 *Shared by the generation threads, every access is locked but the column function is evaluated outside of the lock. Two chunks of a new column generated at the same time both compute it, the first one is kept
+	 *The world removes a column once none of its chunks is in any player's or ticket's view, columns are otherwise evicted least recently used first beyond a byte budget, so that the columns still in view are kept over the ones left behind
+	 */
+
+public:
+	explicit FVoxelColumnCache(int64 InByteBudget);
+
+	//Columns are given in chunk coordinates
+	TSharedPtr<const FVoxelChunkColumn> FindOrCompute(FIntPoint ColumnLocation, float (*ColumnFunction) (FVector2D));
+	void Remove(FIntPoint ColumnLocation);
+	void Empty();
+
+	FVoxelColumnCacheStats GetStats() const;
+	void LogStats() const;
+
+	//Evaluates the column function on every column of voxels, at the positions the generator gives the per-voxel functions
+	static TSharedPtr<FVoxelChunkColumn> ComputeColumn(FIntPoint ColumnLocation, float (*ColumnFunction) (FVector2D));
+
+private:
+	mutable FCriticalSection CriticalSection;
+	TAdditionOrderLRU<FIntPoint, TSharedPtr<const FVoxelChunkColumn>> Columns;
+	int64 ByteBudget = 0;
+
+	FVoxelColumnCacheStats Stats;
+
+	static int64 GetColumnBytes();
+};
@@ -0,0 +1,51 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+
+enum class EVoxelNoiseType : uint8
+{
+	Perlin, Simplex, Value, Cellular
+};
+
+//Fractal combination of octaves of the base noise, FBm sums them and Ridged sums their folded absolute value
+enum class EVoxelNoiseFractal : uint8
+{
+	None, FBm, Ridged
+};
+
+struct FVoxelNoiseSettings
+{
+	EVoxelNoiseType Type = EVoxelNoiseType::Perlin;
+	EVoxelNoiseFractal Fractal = EVoxelNoiseFractal::None;
+	int32 Seed = 0;
+
+	//Frequency of the first octave, coordinates are multiplied by it
+	float Frequency = 1;
+
+	//Each octave has its frequency multiplied by Lacunarity and its amplitude by Gain, and is seeded with the next seed
+	int32 Octaves = 1;
+	float Lacunarity = 2;
+	float Gain = 0.5f;
+};
+
+class FVoxelNoise
+{
+	/*2D noise for terrain generators, evaluated 4 samples at a time with the engine's vector registers: SSE on x64, NEON on ARM, and the engine's scalar emulation elsewhere
+	 *Every noise is written once over a set of lane operations, instantiated for plain floats and for vector registers, so both paths perform the same IEEE operations in the same order and give bit-identical results for a seed
+	 *For that reason the noises never use fused multiply-adds, approximations such as reciprocal estimates, or operations whose result depends on the instruction set
+	 *Values are in about [-1, 1]. Cellular noise is the distance to the nearest feature point remapped to that range
+	 *Nothing is shared between calls, any thread may evaluate noise, in particular the chunk generation threads
+	 *Coordinates are floats, far from the origin the precision of the noise degrades like any float computation, and the integer cell of a coordinate must fit in an int32
+	 */
+
+public:
+	static float Evaluate2D(const FVoxelNoiseSettings& Settings, float X, float Y);
+
+	//Evaluates Count samples, 4 per vector operation and the remaining ones one at a time. OutValues may alias X or Y
+	static void Evaluate2D(const FVoxelNoiseSettings& Settings, const float* X, const float* Y, float* OutValues, int32 Count);
+
+	//Same samples one at a time, the reference the vector path is checked against
+	static void Evaluate2DScalar(const FVoxelNoiseSettings& Settings, const float* X, const float* Y, float* OutValues, int32 Count);
+
+	//Evaluates a grid of SizeX*SizeY samples starting at the origin, OutValues[x*SizeY + y] is the sample at Origin + Step*(x, y), the order of the columns of a chunk
+	static void EvaluateGrid2D(const FVoxelNoiseSettings& Settings, FVector2f Origin, float Step, int32 SizeX, int32 SizeY, float* OutValues);
+};
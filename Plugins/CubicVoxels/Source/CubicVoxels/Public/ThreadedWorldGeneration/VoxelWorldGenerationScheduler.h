@@ -0,0 +1,35 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "ChunkThreadingStructs.h"
+#include "ChunkLoading/ChunkLoadingPriority.h"
+
+class FVoxelWorldGenerationRunnable;
+
+class FVoxelWorldGenerationScheduler
+{
+	/*Dispatches chunk work orders to a pool of generation threads
+	 *Each order goes to the thread with the lowest pending cost at the time it is issued, so that no player's workload stays pinned to one thread
+	 *All threads sort their orders by priority for every managed player, so a chunk needed by several players is generated once for all of them
+	 */
+
+public:
+	~FVoxelWorldGenerationScheduler();
+
+	//Adds threads to the pool
+	void AddThreads(int32 NumberOfThreads);
+	int32 GetNumberOfThreads() const;
+
+	//Sends an order to the least loaded thread, must be called on the game thread
+	void EnqueueOrder(const FChunkThreadedWorkOrderBase& Order);
+
+	//Sends the loading anchors of every managed player to every thread, they are used to prioritize orders
+	void UpdateLoadingAnchors(const TArray<FChunkLoadingAnchor>& Anchors);
+
+	//Stops and destroys every thread of the pool
+	void Shutdown();
+
+	void LogStats() const;
+
+private:
+	TArray<FVoxelWorldGenerationRunnable*> GenerationThreads;
+};
@@ -0,0 +1,39 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "VoxelStructs.h"
+#include "ThreadedWorldGeneration/VoxelColumnCache.h"
+
+struct FVoxelWorldGenerator
+{
+	/*Procedural generation of the terrain of a world, called on the generation threads so every function must be thread-safe
+	 *A generator is given in one of three ways, from the fastest to the slowest:
+	 *ChunkFunction fills a whole chunk at once
+	 *ColumnFunction is evaluated once per column of a chunk, typically a heightmap, then VoxelInColumnFunction classifies each voxel of the column with the value of its column
+	 *VoxelFunction is evaluated on its own for every voxel, it is the former per-voxel generation function
+	 *Positions are the world-space positions of the voxels, as they have always been given to the per-voxel function
+	 */
+
+	FVoxel (*VoxelFunction) (FVector) = nullptr;
+	float (*ColumnFunction) (FVector2D) = nullptr;
+	FVoxel (*VoxelInColumnFunction) (FVector, float) = nullptr;
+	void (*ChunkFunction) (FIntVector, FChunkData&) = nullptr;
+
+	//Optional, tells whether every voxel of a chunk is the same voxel from conservative bounds, before any voxel is generated
+	//It is given the column of the chunk when the generator has a column function, with the bounds of its values, and null otherwise. It must only return true for chunks that are uniform, such as chunks above the highest surface of their column
+	//Uniform chunks are stored as a single stack and have no inside faces to mesh
+	bool (*UniformChunkFunction) (FIntVector, const FVoxelChunkColumn*, FVoxel&) = nullptr;
+
+	//Cache of the values of ColumnFunction shared by the chunks of a column, they are computed for each chunk without it
+	TSharedPtr<FVoxelColumnCache> ColumnCache;
+
+	//Fills every voxel of the chunk with the fastest function available
+	void GenerateChunk(FIntVector ChunkLocation, FChunkData& OutChunkData) const;
+
+	bool IsBatched() const;
+	bool IsValid() const;
+
+	//Adapter of a per-voxel generation function, chunks are generated one voxel at a time
+	static FVoxelWorldGenerator FromVoxelFunction(FVoxel (*InVoxelFunction) (FVector));
+
+	static FVector GetVoxelPosition(FIntVector ChunkLocation, int32 x, int32 y, int32 z);
+};
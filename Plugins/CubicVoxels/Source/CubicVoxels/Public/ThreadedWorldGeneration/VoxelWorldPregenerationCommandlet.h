@@ -0,0 +1,32 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelStructs.h"
+#include "VoxelWorldPregenerationCommandlet.generated.h"
+
+class AVoxelWorld;
+
+//Generates a box of regions offline with the world's generation function and writes them to region files, so that players don't wait for the terrain to be generated
+//Usage: -run=VoxelWorldPregeneration -Min=X,Y,Z -Max=X,Y,Z [-World=WorldName] [-WorldClass=/Game/Path/BP_VoxelWorld.BP_VoxelWorld_C] [-BatchSize=4096] [-Mesh]
+//Min and Max are region coordinates and are both included. The chunks already in the region files are skipped, so an interrupted run resumes where it stopped and saved edits are never overwritten
+//With -Mesh the inside geometry of the generated chunks is also written to the mesh cache, so that the game doesn't mesh them the first time they are loaded
+UCLASS()
+class CUBICVOXELS_API UVoxelWorldPregenerationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelWorldPregenerationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	static bool ParseRegionLocation(const FString& Params, const TCHAR* Key, FIntVector& OutRegionLocation);
+
+	//Generates and encodes the given chunks on every core, then appends them to the region file. Returns the number of chunks written
+	//Their inside geometry is written to the mesh cache file if one is given
+	static int32 GenerateBatch(const TArray<FIntVector>& ChunkLocations, const struct FVoxelWorldGenerator& Generator, class FVoxelRegionFile& RegionFile, FVoxelRegionFile* MeshCacheFile);
+
+	//Registers the region in the world save so that the game reads its region file instead of generating it
+	static void RegisterSavedRegion(const FString& WorldName, FIntVector RegionLocation);
+};
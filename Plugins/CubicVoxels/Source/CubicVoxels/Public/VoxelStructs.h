@@ -2,6 +2,7 @@
 #include "GlobalPluginParameters.h"
 #include "ProceduralMeshComponent.h" 
 #include "Engine/DataTable.h"
+#include "Algo/BinarySearch.h"
 #include "VoxelStructs.generated.h"
 
 USTRUCT()
@@ -103,6 +104,28 @@ struct FChunkGeometry
 	
 
 	int32 DirectionIndex; //Takes a value between 0 and 5 for a chunk's side, and something else for a chunk's inside
+
+	bool FromCache = false; //Set when the geometry was read from the mesh cache instead of being meshed
+};
+
+USTRUCT()
+struct FAdditiveVoxel
+{
+	/*Single edit of a sparse additive chunk, the voxel replaces the generated one at the given index*/
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(SaveGame)
+	int32 VoxelIndex;
+
+	UPROPERTY(SaveGame)
+	FVoxel Voxel;
+
+	FAdditiveVoxel()
+	{
+		VoxelIndex = 0;
+	}
+
+	FAdditiveVoxel(int32 VoxelIndex, FVoxel Voxel) : VoxelIndex(VoxelIndex), Voxel(Voxel) {}
 };
 
 USTRUCT()
@@ -120,6 +143,14 @@ struct FChunkData
 
 	UPROPERTY(SaveGame)
 	bool IsAdditive;
+
+	//Set on additive chunks that only store their edits in AdditiveVoxels, in which case neither voxel array is used
+	UPROPERTY(SaveGame)
+	bool IsSparse = false;
+
+	//Edits of a sparse additive chunk, sorted by voxel index. Voxels without an edit read as "Null"
+	UPROPERTY(SaveGame)
+	TArray<FAdditiveVoxel> AdditiveVoxels;
 	
 	FChunkData()
 	{
@@ -129,14 +160,25 @@ struct FChunkData
 
 	//Lookup functions
 
-	FVoxel GetVoxelAt(int32 x, int32 y, int32 z)
+	FVoxel GetVoxelAt(int32 x, int32 y, int32 z) const
 	{
 		return GetVoxelAt(FIntVector(x,y,z));
 	}
 
-	FVoxel GetVoxelAt(FIntVector IntLocation){ //Function to manipulate compressed chunk data //TODO: move this code into a method of FChunkData and replace all usages of it with the method
+	FVoxel GetVoxelAt(FIntVector IntLocation) const { //Function to manipulate compressed chunk data //TODO: move this code into a method of FChunkData and replace all usages of it with the method
 
-		if (IsCompressed)
+		if (IsSparse)
+		{
+			const int32 EditIndex = FindAdditiveVoxel(IntLocation.X*ChunkSize*ChunkSize + IntLocation.Y*ChunkSize + IntLocation.Z);
+			if (EditIndex == INDEX_NONE)
+			{
+				FVoxel NullVoxel;
+				NullVoxel.VoxelType = "Null";
+				return NullVoxel;
+			}
+			return AdditiveVoxels[EditIndex].Voxel;
+		}
+		else if (IsCompressed)
 		{
 			const int32 BlockIndex = IntLocation.X*ChunkSize*ChunkSize + IntLocation.Y*ChunkSize + IntLocation.Z ;
 	
@@ -176,68 +218,14 @@ struct FChunkData
 		}
 		else
 		{
-			if (IsCompressed)
+			if (IsSparse)
 			{
-				auto BlockIndex = VoxelLocation.X*ChunkSize*ChunkSize + VoxelLocation.Y*ChunkSize + VoxelLocation.Z;
-
-				int32 i = 0;
-	
-				while (CompressedChunkData[i].StackSize - 1 < BlockIndex)
-				{
-					BlockIndex -= CompressedChunkData[i].StackSize;
-					i += 1;
-				
-				}
-	
-	
-				if (CompressedChunkData[i].Voxel == DefaultVoxel)
-				{
-					if (BlockIndex == 0)
-					{
-						CompressedChunkData[i].StackSize -= 1;
-						CompressedChunkData.Insert(FVoxelStack(DefaultVoxel, 1), i);
-					}
-					else
-					{
-						if (BlockIndex == CompressedChunkData[i].StackSize - 1)
-						{
-							if (i+1 < CompressedChunkData.Num())
-							{
-								if (CompressedChunkData[i+1].Voxel == DefaultVoxel)
-								{
-									CompressedChunkData[i].StackSize -= 1;
-									CompressedChunkData[i+1].StackSize += 1;
-								}
-								else
-								{
-									CompressedChunkData[i].StackSize -= 1;
-									CompressedChunkData.Insert(FVoxelStack(DefaultVoxel, 1), i+1);
-								}
-							}
-							else
-							{
-								CompressedChunkData[i].StackSize -= 1;
-								CompressedChunkData.Add(FVoxelStack(DefaultVoxel, 1));
-							}
-						}
-						else
-						{
-							const auto Temp = CompressedChunkData[i].StackSize;
-							CompressedChunkData[i].StackSize = BlockIndex;
-							if (i+1 < CompressedChunkData.Num())
-							{
-								CompressedChunkData.Insert(FVoxelStack(CompressedChunkData[i].Voxel, Temp - BlockIndex - 1), i+1);
-								CompressedChunkData.Insert(FVoxelStack(DefaultVoxel, 1), i+1);
-							}
-							else
-							{
-								CompressedChunkData.Add(FVoxelStack(DefaultVoxel, 1));
-								CompressedChunkData.Add(FVoxelStack(CompressedChunkData[i].Voxel, Temp - BlockIndex - 1));
-							}
-						}
-			
-					}
-				}
+				SetAdditiveVoxel(VoxelLocation.X*ChunkSize*ChunkSize + VoxelLocation.Y*ChunkSize + VoxelLocation.Z, DefaultVoxel);
+			}
+			else if (IsCompressed)
+			{
+				//Removing a voxel is setting it to air, which splits the stack it is in like any other edit
+				SetVoxel(VoxelLocation, DefaultVoxel);
 			}
 			else
 			{
@@ -260,7 +248,11 @@ struct FChunkData
 		}
 		else
 		{
-			if (IsCompressed)
+			if (IsSparse)
+			{
+				SetAdditiveVoxel(VoxelLocation.X*ChunkSize*ChunkSize + VoxelLocation.Y*ChunkSize + VoxelLocation.Z, Voxel);
+			}
+			else if (IsCompressed)
 			{
 				auto BlockIndex = VoxelLocation.X*ChunkSize*ChunkSize + VoxelLocation.Y*ChunkSize + VoxelLocation.Z;
 
@@ -332,8 +324,18 @@ struct FChunkData
 		}
 	}
 
-	void ApplyAsAdditive(FChunkData AdditiveChunk) //Replace every voxel that is not marked as "None" in the additive chunk by its value in the additive chunk.
+	void ApplyAsAdditive(const FChunkData& AdditiveChunk) //Replace every voxel that is not marked as "None" in the additive chunk by its value in the additive chunk.
 	{
+		if (AdditiveChunk.IsSparse)
+		{
+			//Only the edits are visited, the "Null" voxels are implicit
+			for (const auto& AdditiveVoxel : AdditiveChunk.AdditiveVoxels)
+			{
+				SetVoxel(AdditiveVoxel.VoxelIndex/(ChunkSize*ChunkSize), (AdditiveVoxel.VoxelIndex/ChunkSize)%ChunkSize, AdditiveVoxel.VoxelIndex%ChunkSize, AdditiveVoxel.Voxel);
+			}
+			return;
+		}
+		
 		for (int32 x = 0; x < ChunkSize; x++)
 		{
 			for (int32 y = 0; y < ChunkSize; y++)
@@ -364,10 +366,54 @@ struct FChunkData
 		}
 
 		IsAdditive = A.IsAdditive;
+		IsSparse = A.IsSparse;
+		AdditiveVoxels = A.AdditiveVoxels;
 		
 		return *this;
 	}
 
+	void MakeSparse()
+	{
+		/*Convert dense additive data, as written before edits were stored sparsely, to its list of edits*/
+		if (IsSparse || !IsAdditive)
+		{
+			return;
+		}
+
+		AdditiveVoxels.Empty();
+		int32 VoxelIndex = 0;
+		if (IsCompressed)
+		{
+			for (const auto& VoxelStack : CompressedChunkData)
+			{
+				for (int32 i = 0; i < VoxelStack.StackSize; i++)
+				{
+					if (VoxelStack.Voxel)
+					{
+						AdditiveVoxels.Add(FAdditiveVoxel(VoxelIndex, VoxelStack.Voxel));
+					}
+					VoxelIndex += 1;
+				}
+			}
+		}
+		else
+		{
+			for (const auto& Voxel : UncompressedChunkData)
+			{
+				if (Voxel)
+				{
+					AdditiveVoxels.Add(FAdditiveVoxel(VoxelIndex, Voxel));
+				}
+				VoxelIndex += 1;
+			}
+		}
+
+		UncompressedChunkData.Empty();
+		CompressedChunkData.Empty();
+		IsCompressed = false;
+		IsSparse = true;
+	}
+
 	static bool Compress(FChunkData A) //returns true iff the chunk was successfully compressed
 	{
 		if(A.IsCompressed)
@@ -411,6 +457,37 @@ struct FChunkData
 		}
 	}
 
+	//Whether every voxel of the chunk is the same, only known for chunks stored as a single stack like the uniform chunks of the generator
+	bool IsUniform(FVoxel& OutVoxel) const
+	{
+		if (IsCompressed && !IsSparse && CompressedChunkData.Num() == 1)
+		{
+			OutVoxel = CompressedChunkData[0].Voxel;
+			return true;
+		}
+		return false;
+	}
+
+	static FChunkData UniformChunkData(const FVoxel& Voxel)
+	{
+		/*Chunk made of a single voxel, stored as one stack instead of a voxel array. Edits split the stack*/
+		FChunkData Result;
+		Result.UncompressedChunkData.Empty();
+		Result.CompressedChunkData.Add(FVoxelStack(Voxel, ChunkSize*ChunkSize*ChunkSize));
+		Result.IsCompressed = true;
+		return Result;
+	}
+
+	static FChunkData SparseAdditiveChunkData()
+	{
+		/*Additive data holding no edit yet, edits are then added in O(log(edits)) without touching the other voxels*/
+		FChunkData Result;
+		Result.IsAdditive = true;
+		Result.IsSparse = true;
+		Result.UncompressedChunkData.Empty();
+		return Result;
+	}
+
 	static FChunkData EmptyChunkData(bool IsCompressed)
 	{
 		FChunkData Result;
@@ -438,6 +515,36 @@ struct FChunkData
 		
 		return Result;
 	}
+
+private:
+
+	int32 FindAdditiveVoxel(int32 VoxelIndex) const
+	{
+		const int32 EditIndex = Algo::LowerBoundBy(AdditiveVoxels, VoxelIndex, &FAdditiveVoxel::VoxelIndex);
+		return EditIndex < AdditiveVoxels.Num() && AdditiveVoxels[EditIndex].VoxelIndex == VoxelIndex ? EditIndex : INDEX_NONE;
+	}
+
+	void SetAdditiveVoxel(int32 VoxelIndex, const FVoxel& Voxel)
+	{
+		/*Setting a "Null" voxel removes the edit so that the generated voxel shows again*/
+		const int32 EditIndex = Algo::LowerBoundBy(AdditiveVoxels, VoxelIndex, &FAdditiveVoxel::VoxelIndex);
+		const bool EditExists = EditIndex < AdditiveVoxels.Num() && AdditiveVoxels[EditIndex].VoxelIndex == VoxelIndex;
+		if (!Voxel)
+		{
+			if (EditExists)
+			{
+				AdditiveVoxels.RemoveAt(EditIndex);
+			}
+		}
+		else if (EditExists)
+		{
+			AdditiveVoxels[EditIndex].Voxel = Voxel;
+		}
+		else
+		{
+			AdditiveVoxels.Insert(FAdditiveVoxel(VoxelIndex, Voxel), EditIndex);
+		}
+	}
 };
 
 static FIntVector FloorVector(FVector Vector)
@@ -7,7 +7,22 @@
 #include "VoxelStructs.h"
 #include "SerializationAndNetworking/ReplicationStructs.h"
 #include "ThreadedWorldGeneration/FVoxelWorldGenerationRunnable.h"
+#include "ThreadedWorldGeneration/ChunkPipeline.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerationScheduler.h"
+#include "ThreadedWorldGeneration/VoxelWorldGenerator.h"
+#include "ChunkLoading/ChunkClipmap.h"
+#include "ChunkLoading/ChunkViewShells.h"
+#include "ChunkLoading/ChunkLoadingPriority.h"
+#include "ChunkLoading/ChunkLoadingTicket.h"
+#include "ChunkLoading/UnloadedChunkCache.h"
 #include "SerializationAndNetworking/VoxelWorldGlobalDataSaveGame.h"
+#include "SerializationAndNetworking/VoxelRegionFile.h"
+#include "SerializationAndNetworking/VoxelWorldPack.h"
+#include "SerializationAndNetworking/VoxelRegionIORunnable.h"
+#include "SerializationAndNetworking/VoxelRegionSaveTask.h"
+#include "SerializationAndNetworking/VoxelRegionCache.h"
+#include "SerializationAndNetworking/VoxelEditJournal.h"
+#include "SerializationAndNetworking/VoxelChunkMeshCache.h"
 #include "VoxelWorld.generated.h"
 
 class AChunk;
@@ -15,6 +30,8 @@ class UProceduralMeshComponent;
 
 enum class EChunkState;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnVoxelWorldSaved, bool, Success);
+
 UCLASS()
 class AVoxelWorld : public AActor
 {
@@ -35,10 +52,98 @@ public:
 	UPROPERTY()
 	EVoxelWorldNetworkMode NetworkMode;
 
-	//Chunk loading distance parameters //TODO: Make it mutable at runtime
+	//Chunk loading distance parameters given to the players when they are added, they can be changed at runtime with SetViewDistance
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	int32 ViewDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	int32 VerticalViewDistance;
 
+	//Changes the view distances of every managed player, chunks entering the view are loaded and chunks leaving it are unloaded progressively
+	UFUNCTION(BlueprintCallable)
+	void SetViewDistance(int32 NewViewDistance, int32 NewVerticalViewDistance);
+
+	//Changes the view distances of a single managed player
+	UFUNCTION(BlueprintCallable)
+	void SetPlayerViewDistance(APlayerController* Player, int32 NewViewDistance, int32 NewVerticalViewDistance);
+
+	//Governor that lowers the view distance when frames take longer than the target and raises it when there is headroom
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool AutomaticViewDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float TargetFrameTimeMs;
+
+	//Every player's view distance is lowered by one chunk when the smoothed frame time is over TargetFrameTimeMs times ViewDistanceDecreaseThreshold, and raised when it is under TargetFrameTimeMs times ViewDistanceIncreaseThreshold
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ViewDistanceDecreaseThreshold;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ViewDistanceIncreaseThreshold;
+
+	//Seconds between two changes, so that the loading and unloading a change causes can settle
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ViewDistanceChangeInterval;
+
+	//Weight of the last frame in the smoothed frame time, between 0 and 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float FrameTimeSmoothingFactor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinimumViewDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaximumViewDistance;
+
+	//Chunks are prioritized by their distance to the path each player is predicted to follow during this many seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float PrefetchLookaheadTime;
+
+	//How much chunks behind the camera are delayed compared to chunks in front of it, 0 loads them by distance only
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ViewDirectionPriorityWeight;
+
+	//Chunks are unloaded once they are this many chunks beyond the view distance of every player, so that players walking along a chunk boundary don't make chunks load and unload repeatedly
+	UPROPERTY(EditAnywhere)
+	int32 UnloadingHysteresis;
+
+	//Maximum number of chunk actors destroyed on a single tick
+	UPROPERTY(EditAnywhere)
+	int32 MaxChunkUnloadsPerTick;
+
+	//Memory budget of the saved data of regions kept in memory, the least recently used regions that have no chunk in view are evicted beyond it
+	UPROPERTY(EditAnywhere)
+	int32 RegionCacheBudgetMB;
+
+	//Saved chunks keep the inside geometry they had when they were unloaded in a mesh cache next to the region files, so that they are not meshed again when they are reloaded unchanged
+	UPROPERTY(EditAnywhere)
+	bool UseMeshCache;
+
+	//Read-only pack of the authored world, relative to the project's content directory. The chunks it holds are decoded from it instead of being generated and the saved edits are applied on top of them
+	//Empty if the world is only generated. The pack must be staged as a loose file, with Additional Non-Asset Directories to Copy, to be memory-mapped
+	UPROPERTY(EditAnywhere)
+	FString BaseWorldPack;
+
+	//Memory budget of the chunks kept compressed after they were unloaded, a chunk that is loaded again before it is evicted is neither generated nor meshed again. 0 disables the cache
+	UPROPERTY(EditAnywhere)
+	int32 UnloadedChunkCacheBudgetMB;
+
+	//Memory budget of the column values of the generator shared by the chunks stacked in a column, a column is dropped once it leaves every view. 0 disables the cache
+	UPROPERTY(EditAnywhere)
+	int32 ColumnCacheBudgetMB;
+
+	//Edits are appended to the world's edit journal and written to disk this often, in seconds
+	UPROPERTY(EditAnywhere)
+	float JournalFlushInterval;
+
+	//Once this much of the journal has been written since the last save, the world is saved so that the journal can be deleted
+	UPROPERTY(EditAnywhere)
+	int32 JournalCompactionThresholdKB;
+
+	//Number of generation threads shared by all the players on a server, 0 means one per available core
+	UPROPERTY(EditAnywhere)
+	int32 NumberOfServerGenerationThreads;
+
 	//Table that links voxel types with their materials
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	class UDataTable* VoxelPhysicalCharacteristicsTable;
@@ -46,6 +151,13 @@ public:
 	//Pointer to the function that generates the terrain procedurally
 	FVoxel (*WorldGenerationFunction) (FVector);
 
+	//Batched generator of the terrain, chunks are generated with it instead of WorldGenerationFunction as long as its VoxelFunction is WorldGenerationFunction or null
+	//The default terrain computes its heightmap once per column with it, and skips the chunks its columns show to be uniform as long as both of its column functions are kept
+	FVoxelWorldGenerator WorldGenerator;
+
+	//Generator the chunks are generated with, WorldGenerationFunction goes through the per-voxel adapter when WorldGenerator doesn't replace it
+	FVoxelWorldGenerator GetWorldGenerator() const;
+
 	//The VoxelWorld may manage multiple players in mutiplayer
 	//It will generate the world around each managed player
 	//On the client there will generally be only one managed player, on the server every player is generally managed
@@ -60,12 +172,34 @@ public:
 	//Functions to access chunk data
 	bool IsChunkLoaded(FIntVector ChunkLocation);
 	TMap<FIntVector, FChunkData>* GetRegionSavedData(FIntVector RegionLocation);
+	FChunkData* FindChunkSavedData(FIntVector ChunkLocation);
 	void SetChunkSavedData(FIntVector ChunkLocation, FChunkData NewData);
 
 	//Blueprint functions to edit and save the world
+	//Saving only takes a snapshot of the dirty chunks on the game thread, the regions are written on worker threads and OnVoxelWorldSaved is broadcast once they are all written
+	//A save requested while another one is running starts once it is done
 	UFUNCTION(BlueprintCallable)
 	void SaveVoxelWorld();
 
+	UPROPERTY(BlueprintAssignable)
+	FOnVoxelWorldSaved OnVoxelWorldSaved;
+
+	//True from SaveVoxelWorld until its save is written, the write-backs of regions evicted while streaming don't count
+	UFUNCTION(BlueprintPure)
+	bool IsSaving() const;
+
+	//Waits until every save in flight is written
+	void FlushPendingSaves();
+
+	//Loads the global saved data of the world, or creates it for a world that was never saved. Called when play begins, tools that save or read a world without playing it call it themselves
+	void LoadWorldSavedInfo();
+
+	//Drops the saved data of every region that has nothing left to write, their chunks are read from their region file again the next time they are accessed
+	void ReleaseSavedRegions();
+
+	//Must be called before modifying chunk data that may be shared with a save in flight, the data is copied if it is part of the save's snapshot
+	void MakeChunkDataWritable(TSharedPtr<FChunkData>& ChunkDataPtr);
+
 	UFUNCTION(BlueprintCallable)
 	void DestroyBlockAt(FVector BlockWorldLocation); 
 
@@ -74,14 +208,41 @@ public:
 
 	UFUNCTION(BlueprintCallable)
 	FVoxel GetBlockAt(FVector BlockWorldLocation);
-	
+
+	//Converts every region saved in the former save game format to a region file, regions are otherwise converted the first time they are accessed
+	UFUNCTION(BlueprintCallable)
+	void ConvertLegacyRegionSaves();
 
 	//Function to add a player to be managed by the VoxelWorld
 	UFUNCTION(BlueprintCallable)
 	void AddManagedPlayer(APlayerController* PlayerToAdd);
+
+	//Keeps the chunks within a radius of an anchor loaded until the ticket is removed, the anchor follows the actor if one is given and stays at the location otherwise
+	//Returns the id of the ticket
+	UFUNCTION(BlueprintCallable)
+	int32 AddChunkLoadingTicket(AActor* AnchorActor, FVector AnchorLocation, int32 Radius, float Priority = 1, EChunkLoadingLevel Level = EChunkLoadingLevel::FullMesh);
+
+	UFUNCTION(BlueprintCallable)
+	void RemoveChunkLoadingTicket(int32 TicketId);
 	
 	//Functions that are used by the chunk actor occasionally
 	TObjectPtr<AChunk> GetActorOfLoadedChunk(FIntVector ChunkLocation);
+
+	//Prints the throughput and per-stage latency of the chunk pipeline
+	UFUNCTION(BlueprintCallable)
+	void LogChunkPipelineStats();
+
+	//Logs the hit rate, the resident size and the evictions of the region cache
+	UFUNCTION(BlueprintCallable)
+	void LogRegionCacheStats();
+
+	//Logs the hit rate, the resident size and the generations and meshings saved by the cache of unloaded chunks
+	UFUNCTION(BlueprintCallable)
+	void LogUnloadedChunkCacheStats();
+
+	//Logs the hit rate and the resident size of the cache of generator columns
+	UFUNCTION(BlueprintCallable)
+	void LogColumnCacheStats();
 	
 private:
 	//Each player is assigned a unique Id to be identified by on other threads
@@ -89,27 +250,154 @@ private:
 	UPROPERTY()
 	TMap<APlayerController*, int32> PlayerIDs;
 	
-	//Only used on the server to set a fixed number of threads to handle players
-	int32 NumberOfWorldGenerationThreads;
-	int32 CurrentGenerationThreadIndex;
-	TArray<FVoxelWorldGenerationRunnable*> WorldGenerationThreads;
+	//Pool of threads that run the chunk orders of every managed player
+	FVoxelWorldGenerationScheduler GenerationScheduler;
 
 	//Main functions called on actor ticking
-	void UpdatePlayerPositionsOnThreads();
+	void UpdateLoadingAnchors();
 	void IterateChunkCreationNearPlayers();
+	void IterateChunkCreationNearTickets();
 	void IterateGeneratedChunkLoadingAndSidesGeneration();
 	void IterateChunkMeshing();
 	void IterateChunkUnloading();
 
-	TMap<FIntVector, EChunkState> ChunkStates;
-	TMap<FIntVector, TObjectPtr<AChunk>> ChunkActorsMap;
+	//Chunk states and actors are probed many times per chunk per tick, so they are stored in clipmaps centered on the players
+	TChunkClipmap<EChunkState> ChunkStates;
+	TChunkClipmap<TObjectPtr<AChunk>> ChunkActorsMap;
 	TSet<FIntVector> ChunksToSave;
 	TSet<FIntVector> RegionsToSave;
 
-	void CreateChunkAt(FIntVector ChunkLocation, TQueue<FChunkThreadedWorkOrderBase, EQueueMode::Mpsc>* OrdersQueuePtr);
+	//Tracks the stage reached by every chunk and decides when its next stage may run
+	FChunkPipeline ChunkPipeline;
+
+	void CreateChunkAt(FIntVector ChunkLocation, EChunkLoadingLevel Level = EChunkLoadingLevel::FullMesh);
+	void UnloadChunk(FIntVector ChunkLocation);
+	void RequestChunkMeshing(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkDataPtr);
+	void RequestChunkDataOnly(FIntVector ChunkLocation);
+	void RequestSideMeshing(FIntVector ChunkLocation, int32 DirectionIndex, TSharedPtr<FChunkData> ChunkDataPtr, TSharedPtr<FChunkData> NeighbourChunkDataPtr);
+
+	//Uniform chunks have no inside faces, their data and empty geometry are handed back directly instead of going through a meshing order. Returns false for other chunks
+	bool LoadUniformChunkWithoutMeshing(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkDataPtr);
+
+	//Loaded chunks that were only requested as data, they have no actor
+	TChunkClipmap<TSharedPtr<FChunkData>> DataOnlyChunks;
+
+	//Chunks whose data is being generated without a mesh, the value is set when a mesh was requested in the meantime
+	TMap<FIntVector, bool> DataOnlyOrdersInFlight;
+
+	//Tickets keeping chunks loaded around anchors that are not managed players
+	TMap<int32, FChunkLoadingTicket> LoadingTickets;
+	int32 NextLoadingTicketId;
+	FIntVector GetLoadingOriginOfLocation(FVector WorldLocation) const;
+
+	//Number of players and tickets whose unloading distance contains each chunk, chunks that drop to zero are queued for unloading
+	TChunkClipmap<uint32> ChunkReferenceCounts;
+	TQueue<FIntVector> ChunksToUnload;
+	void UpdateChunkReferences(const FVoxelWorldManagedPlayerData& PlayerData, FIntVector NewLoadingOrigin);
+	void AddChunkReference(FIntVector ChunkLocation);
+	void RemoveChunkReference(FIntVector ChunkLocation);
+	void RemoveColumnReference(FIntPoint ColumnLocation);
+	void SetupChunkLoadingTables();
+	void EnsureClipmapExtent(int32 HorizontalDistance, int32 VerticalDistance);
+	int32 ClipmapHorizontalExtent;
+	int32 ClipmapVerticalExtent;
+
+	//Returns the shell tables of the given view distances, they are computed once and then cached
+	TSharedPtr<FChunkViewShells> GetViewShells(int32 HorizontalDistance, int32 VerticalDistance);
+	TMap<FIntPoint, TSharedPtr<FChunkViewShells>> ViewShellsCache;
+	void SetPlayerViewShells(FVoxelWorldManagedPlayerData& PlayerData, int32 NewViewDistance, int32 NewVerticalViewDistance);
+
+	void UpdateViewDistanceGovernor(float DeltaTime);
+	float SmoothedFrameTimeMs;
+	float TimeSinceLastViewDistanceChange;
+
+	//Regions whose saved data is currently in memory, in each region the chunks are located in absolute chunk coordinates
+	FVoxelRegionCache LoadedRegions;
+	void IterateRegionCacheEviction();
+	void RemoveRegionFromMemory(FIntVector RegionLocation);
+
+	//Region files that have been opened, a region file is only opened once a chunk of its region is accessed or saved
+	TMap<FIntVector, TSharedPtr<FVoxelRegionFile>> RegionFiles;
+	FVoxelRegionFile* GetRegionFile(FIntVector RegionLocation, bool CreateIfMissing);
+	bool ConvertLegacyRegionSave(FIntVector RegionLocation, FVoxelRegionFile& RegionFile);
+
+	//Saved regions are read whole on the region I/O thread before any of their chunks is created
+	FVoxelRegionIORunnable* RegionIORunnable = nullptr;
+
+	//Regions whose saved chunks are all in LoadedRegions, their chunks can be created without any disk access
+	TSet<FIntVector> RegionsInMemory;
+
+	//Chunks waiting for the read of their region, along with the level they were requested at, a region is read once whatever the number of chunks waiting for it
+	TMap<FIntVector, TMap<FIntVector, EChunkLoadingLevel>> PendingRegionChunks;
+
+	TSharedPtr<FVoxelRegionFile> FindOrAddRegionFile(FIntVector RegionLocation);
+
+	//Opened when the game starts, regions that are only in the pack are never read, their chunks are decoded on the generation threads
+	TSharedPtr<FVoxelWorldPack> BaseWorldPackFile;
+	bool IsInBaseWorldPack(FIntVector ChunkLocation) const;
+	void RequestWorldPackChunk(FIntVector ChunkLocation, TSharedPtr<FChunkData> AdditiveChunkDataPtr, bool ComputeGeometry);
+
+	//Mesh cache files of the regions, null for the regions that have none on disk. They are region files tagged as holding encoded inside geometry, so the chunk codec never runs on them
+	TMap<FIntVector, TSharedPtr<FVoxelRegionFile>> MeshCacheFiles;
+	TSharedPtr<FVoxelRegionFile> FindMeshCacheFile(FIntVector RegionLocation, bool CreateIfMissing);
+
+	//The meshes of the saved chunks being unloaded are kept by region until the next save writes them
+	//A region's meshes are written on their own once it has a batch of them, and every region's once too many are waiting, so that exploring without editing doesn't keep them all in memory
+	TMap<FIntVector, TMap<FIntVector, TArray<uint8>>> PendingChunkMeshes;
+	void IterateChunkMeshWriting();
+	void DispatchChunkMeshWrite(FIntVector RegionLocation, TMap<FIntVector, TArray<uint8>>&& ChunkMeshes);
+	static constexpr int32 ChunkMeshWriteBatchSize = 64;
+	static constexpr int32 MaxPendingChunkMeshes = 1024;
+
+	//Chunks recently unloaded, they are loaded from it instead of being generated or copied from their saved data and meshed
+	FUnloadedChunkCache UnloadedChunks;
+
+	//Created when the game starts, shared with the generation threads through the generator of the orders
+	TSharedPtr<FVoxelColumnCache> ColumnCache;
+
+	//Number of referenced chunks in each column of chunks, the column is removed from the column cache when it drops to zero
+	TMap<FIntPoint, int32> ColumnReferenceCounts;
+	void RequestUnloadedChunk(FIntVector ChunkLocation, EChunkLoadingLevel Level, FUnloadedChunk& UnloadedChunk);
+
+	//Unloaded chunks are encoded on worker threads, for the cache of unloaded chunks and for the mesh cache
+	TArray<TFuture<void>> UnloadedChunkEncodingTasks;
+	TQueue<FEncodedUnloadedChunk, EQueueMode::Mpsc> EncodedUnloadedChunks;
+	void EncodeUnloadedChunk(FIntVector ChunkLocation, TSharedPtr<FChunkData> ChunkData, const AChunk* ChunkActor);
+	void IterateUnloadedChunkEncoding();
+	bool IsLoadedFromSavedData(FIntVector ChunkLocation);
+	bool IsRegionInMemory(FIntVector RegionLocation) const;
+	void WaitForRegion(FIntVector ChunkLocation, EChunkLoadingLevel Level);
+	void IterateRegionLoading();
+
+	//Regions being written by the save in flight or written back before their eviction, each on its own worker thread
+	int32 RegionSavesInFlight = 0;
+	TMap<FIntVector, int32> RegionWritesInFlight;
+	bool WorldSaveInFlight = false;
+	TArray<TFuture<void>> SaveTasksInFlight;
+	TQueue<TSharedPtr<FVoxelRegionSaveTask>, EQueueMode::Mpsc> CompletedRegionSaves;
+	
+	//Chunk data shared with the save in flight, it is copied on write until the save is done
+	TSet<const FChunkData*> ChunkDataInSaveSnapshot;
+	
+	bool SaveFailed = false;
+	bool SaveRequestedWhileSaving = false;
+	double SaveStartTime = 0;
+	
+	//Journal of the edits made since the last save, replayed on BeginPlay if the game stopped before the edits were saved
+	FVoxelEditJournal EditJournal;
+	TFuture<bool> JournalFlushTask;
+	float TimeSinceJournalFlush = 0;
+	bool IsReplayingJournal = false;
+
+	//First journal segment that is not covered by the save in flight
+	int32 JournalSegmentOfSave = INDEX_NONE;
 
-	//Map of all the regions that are currently loaded in memory, in each region the chunks are located in absolute chunk coordinates
-	TMap<FIntVector, TMap<FIntVector, FChunkData>> LoadedRegions; 
+	void JournalEdit(FVector BlockWorldLocation, FVoxel NewVoxel);
+	void ReplayEditJournal();
+	void IterateEditJournal(float DeltaTime);
+
+	void DispatchRegionSave(TSharedPtr<FVoxelRegionSaveTask> SaveTask);
+	void IterateSaveCompletion();
 
 	TQueue< TTuple<FIntVector, TSharedPtr<FChunkData>>, EQueueMode::Mpsc> GeneratedChunksToLoadInGame;
 	TQueue< TSharedPtr<FChunkGeometry>, EQueueMode::Mpsc> ChunkQuadsToLoad;
@@ -118,15 +406,18 @@ private:
 
 	void RegisterChunkForSaving(FIntVector3 ChunkLocation);
 
-	FCriticalSection PlayerPositionsUpdateOnThreadsMutex;
-	FCriticalSection ThreadShutdownMutex;
-
 	int32 DistanceToNearestPlayer(FIntVector ChunkLocation);
+	FIntVector GetPlayerLoadingOrigin(APlayerController* Player) const;
+	FChunkLoadingAnchor GetPlayerLoadingAnchor(APlayerController* Player) const;
+
+	//Anchors of every managed player for the current tick, shared with the generation threads
+	TArray<FChunkLoadingAnchor> LoadingAnchors;
+	bool IsInFrontOfNearestAnchor(FIntVector ChunkLocation) const;
 	TObjectPtr<APlayerController> NearestPlayerToChunk(FIntVector ChunkLocation);
 
 	FString GetRegionName(FIntVector RegionLocation);
 
-	void ServerThreadsSetup(int32 NumberOfThreads);
+	void ServerThreadsSetup();
 
 	
 protected:
@@ -134,15 +425,19 @@ protected:
 	virtual void BeginPlay() override;
 	virtual void EndPlay( const EEndPlayReason::Type EndPlayReason  ) override;
 	
-	TArray<TSet<FIntVector>> ViewLayers;
-	TArray<TTuple<FIntVector, TSharedPtr<FChunkData>>> GeneratedChunksToLoadByDistanceToNearestPlayer;
-	TMap<FIntVector, uint32> NumbersOfPlayerOutsideRangeOfChunkMap;
+	//Chunks keyed by their priority, which is computed once per chunk rather than in every comparison of the sort
+	TArray<TTuple<float, TTuple<FIntVector, TSharedPtr<FChunkData>>>> GeneratedChunksToLoadByPriority;
 	TQueue<TSharedPtr<FChunkGeometry>> ChunkGeometryToBeLoadedLater;
 
 	static int32 OneNorm(FIntVector Vector);
 	
 	static FVoxel DefaultGenerateBlockAt(FVector Position);
 
+	//Default terrain as a heightmap pass and a classification of the voxels of each column, DefaultGenerateBlockAt is both of them for a single voxel
+	static float DefaultSurfaceHeight(FVector2D ColumnPosition);
+	static FVoxel DefaultGenerateBlockInColumn(FVector Position, float SurfaceHeight);
+	static bool DefaultClassifyUniformChunk(FIntVector ChunkLocation, const FVoxelChunkColumn* Column, FVoxel& OutVoxel);
+
 	//SaveGame that stores all the global data of the VoxelWorld actor
 	//That is the data which is not owned by a particular region
 	UPROPERTY()
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelStructs.h"
+#include "VoxelWorldBenchmarkCommandlet.generated.h"
+
+class AVoxelWorld;
+
+//Measures the chunk codec, the storage of the chunk states, the world generator and the noises of a voxel world class offline and logs the results
+//Usage: -run=VoxelWorldBenchmark [-Codec] [-StateStorage] [-Generation] [-Noise] [-Chunks=256] [-Samples=1048576] [-WorldClass=/Game/Path/BP_VoxelWorld.BP_VoxelWorld_C]
+//Every benchmark runs when none is selected. The settings of the world, such as its view distances and its generation function, are read from the class defaults
+//Returns 1 if any benchmark finds that two paths that must agree gave different results
+UCLASS()
+class CUBICVOXELS_API UVoxelWorldBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelWorldBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	//Every benchmark returns the number of mismatches it found
+
+	//Size and encoding and decoding speed of every chunk codec encoding and compression on chunks generated around the origin
+	static int32 BenchmarkChunkCodec(const AVoxelWorld* DefaultWorld, int32 NumberOfChunks);
+
+	//Cost of the chunk state lookups of a tick when they are stored in hash maps and in clipmaps, and checks that the fallback of the clipmap empties once the chunks it collided with are removed
+	static int32 BenchmarkChunkStateStorage(const AVoxelWorld* DefaultWorld);
+
+	//Generates the same chunks with the per-voxel adapter of the world's generation function and with its generator, checks that they are identical and logs the speedup
+	static int32 BenchmarkWorldGeneration(const AVoxelWorld* DefaultWorld, int32 NumberOfChunks);
+
+	//Throughput of every noise of FVoxelNoise on its scalar and vector paths next to FMath::PerlinNoise2D, both paths must give the same bits
+	static int32 BenchmarkNoise(int32 NumberOfSamples);
+};